@@ -0,0 +1,19 @@
+TEMPLATE = subdirs
+
+SUBDIRS = editor \
+	bench \
+	check \
+	corpus \
+	daemon \
+	edit \
+	store \
+	throughput
+
+editor.file = source/lozsrame.pro
+bench.subdir = source/tools/bench
+check.subdir = source/tools/check
+corpus.subdir = source/tools/corpus
+daemon.subdir = source/tools/daemon
+edit.subdir = source/tools/edit
+store.subdir = source/tools/store
+throughput.subdir = source/tools/throughput
@@ -0,0 +1,561 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <memory>
+#include <vector>
+
+#include <QFile>
+
+#include "batch/batchloader.hh"
+#include "batch/workstealingpool.hh"
+#include "model/sramfile.hh"
+
+#ifdef Q_OS_UNIX
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// LOZSRAME_URING is defined when the kernel headers for io_uring, and a C
+// library with statx, are available. The kernel may still refuse it.
+#if defined(Q_OS_LINUX) && defined(STATX_SIZE) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #define LOZSRAME_URING
+
+        #include <cerrno>
+        #include <cstring>
+
+        #include <linux/io_uring.h>
+        #include <sys/mman.h>
+        #include <sys/syscall.h>
+    #endif
+#endif
+
+using namespace lozsrame;
+
+namespace {
+    /**
+     * Reads one file with blocking calls.
+     *
+     * @param filename The file to read.
+     * @param handler The function to call with the file.
+     */
+    void preadFile(const QString &filename,
+                   const BatchLoader::Handler &handler) {
+        char buffer[SRAM_SIZE];
+
+#ifdef Q_OS_UNIX
+        const int fd =
+            open(QFile::encodeName(filename).constData(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+
+        if ((fd < 0) || (fstat(fd, &st) != 0)) {
+            if (fd >= 0) {
+                close(fd);
+            }
+
+            handler(filename, nullptr, -1);
+            return;
+        }
+
+        qint64 size = st.st_size;
+
+        if (size == SRAM_SIZE) {
+            size = pread(fd, buffer, SRAM_SIZE, 0);
+        }
+
+        close(fd);
+#else
+        QFile file(filename);
+
+        if (!file.open(QIODevice::ReadOnly)) {
+            handler(filename, nullptr, -1);
+            return;
+        }
+
+        qint64 size = file.size();
+
+        if (size == SRAM_SIZE) {
+            size = file.read(buffer, SRAM_SIZE);
+        }
+#endif
+
+        handler(filename, (size == SRAM_SIZE) ? buffer : nullptr, size);
+    }
+
+#ifdef LOZSRAME_URING
+    /// the operations submitted for a file, stored in the low bits of the
+    /// user data next to the slot number
+    enum ur_op { OP_OPEN, OP_STATX, OP_READ, OP_CLOSE, OP_CANCEL, OP_COUNT };
+
+    /**
+     * A minimal io_uring, driven through the raw system calls so there is
+     * no library to depend on. Only one thread may use it.
+     */
+    class Ring {
+      private:
+        int                  fd;
+        unsigned             entries;
+        void                *sqRing, *cqRing;
+        size_t               sqRingSize, cqRingSize, sqesSize;
+        unsigned            *sqHead, *sqTail, *sqMask, *sqArray;
+        unsigned            *cqHead, *cqTail, *cqMask;
+        struct io_uring_sqe *sqes;
+        struct io_uring_cqe *cqes;
+        unsigned             unsubmitted;
+
+      public:
+        /**
+         * Creates a new Ring.
+         *
+         * @param size The number of submission queue entries.
+         */
+        Ring(unsigned size);
+
+        ~Ring();
+
+        Ring(const Ring &) = delete;
+        Ring &operator=(const Ring &) = delete;
+
+        /**
+         * Checks if the ring was set up and supports the operations the
+         * loader needs.
+         *
+         * @return true if the ring can be used; false otherwise.
+         */
+        bool isReady() const;
+
+        /**
+         * Gets the next free submission queue entry, cleared.
+         *
+         * @return The entry.
+         */
+        struct io_uring_sqe *next();
+
+        /**
+         * Submits the pending entries and waits for a completion.
+         *
+         * @return true on success; false otherwise.
+         */
+        bool submitAndWait();
+
+        /**
+         * Takes the next completion, if any.
+         *
+         * @param cqe Set to the completion.
+         *
+         * @return true if a completion was taken; false otherwise.
+         */
+        bool complete(struct io_uring_cqe &cqe);
+    };
+
+    Ring::Ring(unsigned size)
+        : fd(-1), entries(0), sqRing(MAP_FAILED), cqRing(MAP_FAILED),
+          sqes(static_cast<struct io_uring_sqe *>(MAP_FAILED)),
+          unsubmitted(0) {
+        struct io_uring_params params;
+
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, size, &params));
+
+        if (fd < 0) {
+            return;
+        }
+
+        entries    = params.sq_entries;
+        sqRingSize = params.sq_off.array + (entries * sizeof(unsigned));
+        cqRingSize = params.cq_off.cqes
+                     + (params.cq_entries * sizeof(struct io_uring_cqe));
+        sqesSize   = entries * sizeof(struct io_uring_sqe);
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        sqes   = static_cast<struct io_uring_sqe *>(
+            mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+
+        if ((sqRing == MAP_FAILED) || (cqRing == MAP_FAILED)
+            || (sqes == MAP_FAILED)) {
+            return;
+        }
+
+        char *sq = static_cast<char *>(sqRing);
+        char *cq = static_cast<char *>(cqRing);
+
+        sqHead  = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sqTail  = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sqMask  = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        cqHead  = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cqTail  = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cqMask  = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes    = reinterpret_cast<struct io_uring_cqe *>(
+            cq + params.cq_off.cqes);
+    }
+
+    Ring::~Ring() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqesSize);
+        }
+
+        if (cqRing != MAP_FAILED) {
+            munmap(cqRing, cqRingSize);
+        }
+
+        if (sqRing != MAP_FAILED) {
+            munmap(sqRing, sqRingSize);
+        }
+
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    auto Ring::isReady() const -> bool {
+        if ((fd < 0) || (sqRing == MAP_FAILED) || (cqRing == MAP_FAILED)
+            || (sqes == MAP_FAILED)) {
+            return false;
+        }
+
+        // the opcodes arrived in Linux 5.6; older kernels reject the probe
+        const size_t size = sizeof(struct io_uring_probe)
+                            + (256 * sizeof(struct io_uring_probe_op));
+        std::vector<char> buffer(size, 0);
+        auto *probe = reinterpret_cast<struct io_uring_probe *>(buffer.data());
+
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe,
+                    256)
+            < 0) {
+            return false;
+        }
+
+        for (int op : {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ,
+                       IORING_OP_CLOSE, IORING_OP_ASYNC_CANCEL}) {
+            if ((op > probe->last_op)
+                || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    auto Ring::next() -> struct io_uring_sqe * {
+        const unsigned tail  = *sqTail;
+        const unsigned index = tail & *sqMask;
+
+        Q_ASSERT(tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) < entries);
+
+        std::memset(&sqes[index], 0, sizeof(struct io_uring_sqe));
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++unsubmitted;
+
+        return &sqes[index];
+    }
+
+    auto Ring::submitAndWait() -> bool {
+        for (;;) {
+            const long submitted =
+                syscall(__NR_io_uring_enter, fd, unsubmitted, 1,
+                        IORING_ENTER_GETEVENTS, nullptr, 0);
+
+            if (submitted >= 0) {
+                unsubmitted -= static_cast<unsigned>(submitted);
+                return true;
+            }
+
+            if ((errno != EINTR) && (errno != EAGAIN) && (errno != EBUSY)) {
+                return false;
+            }
+        }
+    }
+
+    auto Ring::complete(struct io_uring_cqe &cqe) -> bool {
+        const unsigned head = *cqHead;
+
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+
+        cqe = cqes[head & *cqMask];
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+
+        return true;
+    }
+
+    /// a file being read through the ring
+    struct Slot {
+        int          index = -1;
+        QByteArray   path;
+        struct statx stx;
+        int          fd = -1, pending;
+        bool         statted;
+        char         buffer[SRAM_SIZE];
+    };
+#endif
+}  // namespace
+
+BatchLoader::BatchLoader(enum bl_backend backend)
+    : backend(backend), lastBackend(BACKEND_AUTO), queueDepth(256),
+      threads(QThread::idealThreadCount() * 4) {}
+
+void BatchLoader::setQueueDepth(int depth) {
+    queueDepth = qBound(1, depth, 4096);
+}
+
+void BatchLoader::setThreadCount(int count) {
+    threads = qMax(count, 1);
+}
+
+auto BatchLoader::getBackendName(enum bl_backend backend) -> const char * {
+    switch (backend) {
+        case BACKEND_PREAD:
+            return "pread";
+        case BACKEND_URING:
+            return "io_uring";
+        default:
+            return "auto";
+    }
+}
+
+void BatchLoader::load(const QStringList &filenames, const Handler &handler) {
+    if ((backend != BACKEND_PREAD) && loadUring(filenames, handler)) {
+        lastBackend = BACKEND_URING;
+        return;
+    }
+
+    loadPread(filenames, handler);
+    lastBackend = BACKEND_PREAD;
+}
+
+void BatchLoader::loadPread(const QStringList &filenames,
+                            const Handler &handler) {
+    WorkStealingPool pool(threads);
+
+    for (const QString &filename : filenames) {
+        pool.submit([&filename, &handler] { preadFile(filename, handler); });
+    }
+
+    pool.waitForDone();
+}
+
+auto BatchLoader::loadUring(const QStringList &filenames,
+                            const Handler &handler) -> bool {
+#ifdef LOZSRAME_URING
+    // the slots must outlive the ring, which the kernel may still be
+    // writing into until it is closed
+    std::unique_ptr<std::vector<Slot>> owned(new std::vector<Slot>(queueDepth));
+    std::vector<Slot>                 &queue = *owned;
+    int                                next = 0, inflight = 0;
+    bool                               delivered = false;
+
+    // between submissions, a file queues at most three entries (a close,
+    // then the open and statx of the next file), and aborting queues
+    // three cancels per file on top of those; the completion queue is
+    // twice the size of the submission queue
+    Ring ring(static_cast<unsigned>(queueDepth * 8));
+
+    if (!ring.isReady()) {
+        return false;
+    }
+
+    // starts reading the next file into a free slot
+    auto start = [&](Slot &slot, quint64 id) {
+        slot.index   = next++;
+        slot.path    = QFile::encodeName(filenames.at(slot.index));
+        slot.fd      = -1;
+        slot.pending = 2;
+        slot.statted = false;
+
+        struct io_uring_sqe *sqe = ring.next();
+
+        sqe->opcode     = IORING_OP_OPENAT;
+        sqe->fd         = AT_FDCWD;
+        sqe->addr       = reinterpret_cast<quint64>(slot.path.constData());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data  = (id * OP_COUNT) + OP_OPEN;
+
+        sqe             = ring.next();
+        sqe->opcode     = IORING_OP_STATX;
+        sqe->fd         = AT_FDCWD;
+        sqe->addr       = reinterpret_cast<quint64>(slot.path.constData());
+        sqe->len        = STATX_SIZE;
+        sqe->off        = reinterpret_cast<quint64>(&slot.stx);
+        sqe->user_data  = (id * OP_COUNT) + OP_STATX;
+
+        inflight += 2;
+    };
+
+    // hands a file to the handler, closes it, and reuses its slot
+    auto finish = [&](Slot &slot, quint64 id, const char *data, qint64 size) {
+        handler(filenames.at(slot.index), data, size);
+        delivered = true;
+
+        if (slot.fd >= 0) {
+            struct io_uring_sqe *sqe = ring.next();
+
+            sqe->opcode    = IORING_OP_CLOSE;
+            sqe->fd        = slot.fd;
+            sqe->user_data = (id * OP_COUNT) + OP_CLOSE;
+            ++inflight;
+
+            // the ring owns it now, so the fallback mustn't close it again
+            slot.fd = -1;
+        }
+
+        slot.index = -1;
+
+        if (next < filenames.size()) {
+            start(slot, id);
+        }
+    };
+
+    // cancels everything still in flight and waits for it to finish, so
+    // the kernel is done opening files and writing into the slots
+    auto cancel = [&]() -> bool {
+        for (int id = 0; id < queueDepth; ++id) {
+            if (queue[id].index < 0) {
+                continue;
+            }
+
+            for (int op = OP_OPEN; op < OP_CLOSE; ++op) {
+                struct io_uring_sqe *sqe = ring.next();
+
+                sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+                sqe->addr      = (id * OP_COUNT) + op;
+                sqe->user_data = (id * OP_COUNT) + OP_CANCEL;
+                ++inflight;
+            }
+        }
+
+        while (inflight > 0) {
+            if (!ring.submitAndWait()) {
+                return false;
+            }
+
+            struct io_uring_cqe cqe;
+
+            while (ring.complete(cqe)) {
+                --inflight;
+
+                if ((cqe.user_data % OP_COUNT) == OP_OPEN) {
+                    queue[cqe.user_data / OP_COUNT].fd = cqe.res;
+                }
+            }
+        }
+
+        return true;
+    };
+
+    for (int i = 0; (i < queueDepth) && (next < filenames.size()); ++i) {
+        start(queue[i], i);
+    }
+
+    while (inflight > 0) {
+        if (!ring.submitAndWait()) {
+            // if the ring can't even be waited on, the kernel may write
+            // into the slots until it has torn the ring down, which
+            // happens after it is closed, so they are never freed
+            if (!cancel()) {
+                owned.release();
+            }
+
+            for (Slot &slot : queue) {
+                if (slot.fd >= 0) {
+                    close(slot.fd);
+                }
+            }
+
+            // the kernel set up the ring but won't run it, so read the
+            // files it didn't finish the slow way
+            if (!delivered) {
+                return false;
+            }
+
+            for (const Slot &slot : queue) {
+                if (slot.index >= 0) {
+                    preadFile(filenames.at(slot.index), handler);
+                }
+            }
+
+            for (; next < filenames.size(); ++next) {
+                preadFile(filenames.at(next), handler);
+            }
+
+            break;
+        }
+
+        struct io_uring_cqe cqe;
+
+        while (ring.complete(cqe)) {
+            const quint64 id   = cqe.user_data / OP_COUNT;
+            Slot         &slot = queue[id];
+
+            --inflight;
+
+            switch (cqe.user_data % OP_COUNT) {
+                case OP_OPEN:
+                    slot.fd = cqe.res;
+                    break;
+                case OP_STATX:
+                    slot.statted = (cqe.res == 0);
+                    break;
+                case OP_READ:
+                    finish(slot, id,
+                           (cqe.res == SRAM_SIZE) ? slot.buffer : nullptr,
+                           (cqe.res < 0) ? -1 : cqe.res);
+                    continue;
+                default:
+                    continue;
+            }
+
+            if (--slot.pending > 0) {
+                continue;
+            }
+
+            if ((slot.fd < 0) || !slot.statted) {
+                finish(slot, id, nullptr, -1);
+            } else if (slot.stx.stx_size != SRAM_SIZE) {
+                finish(slot, id, nullptr, slot.stx.stx_size);
+            } else {
+                struct io_uring_sqe *sqe = ring.next();
+
+                sqe->opcode    = IORING_OP_READ;
+                sqe->fd        = slot.fd;
+                sqe->addr      = reinterpret_cast<quint64>(slot.buffer);
+                sqe->len       = SRAM_SIZE;
+                sqe->user_data = (id * OP_COUNT) + OP_READ;
+                ++inflight;
+            }
+        }
+    }
+
+    return true;
+#else
+    Q_UNUSED(filenames);
+    Q_UNUSED(handler);
+
+    return false;
+#endif
+}
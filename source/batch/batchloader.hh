@@ -0,0 +1,137 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_BATCHLOADER_HH_
+#define LOZSRAME_BATCHLOADER_HH_
+
+#include <functional>
+
+#include <QString>
+#include <QStringList>
+
+namespace lozsrame {
+    /// the ways a batch loader can read files
+    enum bl_backend { BACKEND_AUTO, BACKEND_PREAD, BACKEND_URING };
+
+    /**
+     * Reads many SRAM files as fast as the disk allows. When reading lots of
+     * small files, the time goes on the open, size, and read system calls of
+     * each file rather than on moving the data, so the loader keeps many
+     * files in flight at once instead of reading them one after another.
+     *
+     * On Linux, it submits the opens, size checks, and reads for a whole
+     * queue of files through io_uring and handles them as they complete.
+     * Where io_uring isn't available, a thread pool reads the files with
+     * one blocking pread each.
+     */
+    class BatchLoader {
+      public:
+        /**
+         * Called with each file once it has been read. The data is only
+         * read if the file is the size of an SRAM file, so it is nullptr
+         * and size is the file size otherwise; pass both to
+         * SRAMFile::fromData() to validate the file. A size below zero
+         * means the file couldn't be read at all.
+         *
+         * The data is only valid until the function returns. It may be
+         * called from several threads at once.
+         */
+        typedef std::function<void(const QString &, const char *, qint64)>
+            Handler;
+
+      private:
+        enum bl_backend backend, lastBackend;
+        int             queueDepth, threads;
+
+        /**
+         * Reads files with a pool of threads.
+         *
+         * @param filenames The files to read.
+         * @param handler The function to call with each file.
+         */
+        void loadPread(const QStringList &filenames, const Handler &handler);
+
+        /**
+         * Reads files through io_uring.
+         *
+         * @param filenames The files to read.
+         * @param handler The function to call with each file.
+         *
+         * @return true if the files were read; false if io_uring isn't
+         *         available, in which case none of them were.
+         */
+        bool loadUring(const QStringList &filenames, const Handler &handler);
+
+      public:
+        /**
+         * Creates a new BatchLoader.
+         *
+         * @param backend How to read files. BACKEND_AUTO uses io_uring
+         *                where available and threads elsewhere.
+         */
+        BatchLoader(enum bl_backend backend = BACKEND_AUTO);
+
+        /**
+         * Sets the number of files io_uring keeps in flight.
+         *
+         * @param depth The queue depth.
+         */
+        void setQueueDepth(int depth);
+
+        /**
+         * Sets the number of threads reading files without io_uring.
+         *
+         * @param count The number of threads.
+         */
+        void setThreadCount(int count);
+
+        /**
+         * Reads files, returning once the handler has been called for
+         * every one of them. Files complete in no particular order.
+         *
+         * @param filenames The files to read.
+         * @param handler The function to call with each file.
+         */
+        void load(const QStringList &filenames, const Handler &handler);
+
+        /**
+         * Gets the backend the last load() used, after any fallback.
+         *
+         * @return The backend, or BACKEND_AUTO if nothing has been loaded.
+         */
+        enum bl_backend getBackend() const;
+
+        /**
+         * Gets the name of a backend.
+         *
+         * @param backend The backend.
+         *
+         * @return The name.
+         */
+        static const char *getBackendName(enum bl_backend backend);
+    };
+
+    inline enum bl_backend BatchLoader::getBackend() const {
+        return lastBackend;
+    }
+}  // namespace lozsrame
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_BOUNDEDQUEUE_HH_
+#define LOZSRAME_BOUNDEDQUEUE_HH_
+
+#include <deque>
+#include <utility>
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+
+namespace lozsrame {
+    /**
+     * A blocking first in, first out queue with a fixed capacity, used to
+     * connect the stages of a pipeline. A full queue blocks its producers,
+     * so a fast stage can't run arbitrarily far ahead of a slow one.
+     *
+     * The queue is finished once every producer has called close(), and
+     * pop() then fails after the remaining items have been taken.
+     */
+    template <typename T>
+    class BoundedQueue {
+      private:
+        std::deque<T>  items;
+        QMutex         mutex;
+        QWaitCondition notEmpty, notFull;
+        int            capacity, producers;
+
+      public:
+        /**
+         * Creates a new BoundedQueue.
+         *
+         * @param capacity The most items the queue will hold.
+         * @param producers The number of threads that will push items.
+         */
+        BoundedQueue(int capacity, int producers = 1);
+
+        BoundedQueue(const BoundedQueue &) = delete;
+        BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+        /**
+         * Adds an item to the back of the queue, waiting for room if the
+         * queue is full.
+         *
+         * @param item The item.
+         */
+        void push(T item);
+
+        /**
+         * Takes an item from the front of the queue, waiting for one if the
+         * queue is empty.
+         *
+         * @param item Set to the item.
+         *
+         * @return true if an item was taken; false if the queue is empty
+         *         and every producer has closed it.
+         */
+        bool pop(T &item);
+
+        /**
+         * Marks that one of the producers has finished pushing items.
+         */
+        void close();
+    };
+
+    template <typename T>
+    inline BoundedQueue<T>::BoundedQueue(int capacity, int producers)
+        : capacity(qMax(capacity, 1)), producers(producers) {}
+
+    template <typename T>
+    inline void BoundedQueue<T>::push(T item) {
+        QMutexLocker locker(&mutex);
+
+        while (static_cast<int>(items.size()) >= capacity) {
+            notFull.wait(&mutex);
+        }
+
+        items.push_back(std::move(item));
+        notEmpty.wakeOne();
+    }
+
+    template <typename T>
+    inline bool BoundedQueue<T>::pop(T &item) {
+        QMutexLocker locker(&mutex);
+
+        while (items.empty()) {
+            if (producers == 0) {
+                return false;
+            }
+
+            notEmpty.wait(&mutex);
+        }
+
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.wakeOne();
+
+        return true;
+    }
+
+    template <typename T>
+    inline void BoundedQueue<T>::close() {
+        QMutexLocker locker(&mutex);
+
+        if (--producers == 0) {
+            notEmpty.wakeAll();
+        }
+    }
+}  // namespace lozsrame
+
+#endif
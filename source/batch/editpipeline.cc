@@ -0,0 +1,281 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <memory>
+#include <vector>
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+
+#include "batch/editpipeline.hh"
+#include "model/filesync.hh"
+
+using namespace lozsrame;
+
+EditPipeline::StageThread::StageThread(std::function<void()> body)
+    : body(body) {}
+
+void EditPipeline::StageThread::run() {
+    body();
+}
+
+EditPipeline::EditPipeline(const EditScript &script)
+    : script(script), queueDepth(64), batchSize(64), elapsed(0) {
+    // the disk stages wait on I/O, so they get extra threads to keep
+    // several requests in flight; the rest take microseconds per file
+    threads[STAGE_READ]     = 4;
+    threads[STAGE_DECODE]   = 1;
+    threads[STAGE_EDIT]     = 1;
+    threads[STAGE_CHECKSUM] = 1;
+    threads[STAGE_WRITE]    = 4;
+}
+
+void EditPipeline::setOutputDirectory(const QString &directory) {
+    outputDirectory = directory;
+}
+
+void EditPipeline::setReporter(const Reporter &reporter) {
+    this->reporter = reporter;
+}
+
+void EditPipeline::setQueueDepth(int depth) {
+    queueDepth = qMax(depth, 1);
+}
+
+void EditPipeline::setBatchSize(int size) {
+    batchSize = qMax(size, 1);
+}
+
+void EditPipeline::setThreadCount(enum ep_stage stage, int count) {
+    threads[stage] = qMax(count, 1);
+}
+
+auto EditPipeline::getStageName(enum ep_stage stage) -> const char * {
+    switch (stage) {
+        case STAGE_READ:
+            return "read";
+        case STAGE_DECODE:
+            return "decode";
+        case STAGE_EDIT:
+            return "edit";
+        case STAGE_CHECKSUM:
+            return "checksum";
+        case STAGE_WRITE:
+            return "write";
+        default:
+            return "";
+    }
+}
+
+auto EditPipeline::getOutputFilename(const QString &filename) const
+    -> QString {
+    if (outputDirectory.isEmpty()) {
+        return filename;
+    }
+
+    return QDir(outputDirectory).filePath(QFileInfo(filename).fileName());
+}
+
+auto EditPipeline::process(enum ep_stage stage, Job &job, SaveBatch &batch)
+    -> bool {
+    switch (stage) {
+        case STAGE_READ: {
+            QFile file(job.filename);
+
+            if (!file.open(QIODevice::ReadOnly)) {
+                job.status = STATUS_UNREADABLE;
+                return false;
+            }
+
+            job.data = file.read(SRAM_SIZE + 1);
+
+            if (job.data.size() != SRAM_SIZE) {
+                job.status = STATUS_INVALID;
+                return false;
+            }
+
+            return true;
+        }
+        case STAGE_DECODE:
+            try {
+                job.sram = QSharedPointer<SRAMFile>(new SRAMFile(
+                    SRAMFile::fromData(job.data.constData(), SRAM_SIZE)));
+            } catch (InvalidSRAMFileException &) {
+                job.status = STATUS_INVALID;
+                return false;
+            }
+
+            return true;
+        case STAGE_EDIT:
+            script.apply(*job.sram);
+            return true;
+        case STAGE_CHECKSUM:
+            job.data = job.sram->toData();
+            job.sram.reset();
+            return true;
+        case STAGE_WRITE:
+            if (!batch.add(getOutputFilename(job.filename), job.data)) {
+                job.status = STATUS_UNWRITABLE;
+                return false;
+            }
+
+            return true;
+        default:
+            return false;
+    }
+}
+
+void EditPipeline::commitBatch(SaveBatch &batch, QStringList &filenames) {
+    QStringList failed;
+
+    batch.commit(&failed);
+
+    if (reporter) {
+        for (const QString &filename : filenames) {
+            const bool written =
+                !failed.contains(resolveFile(getOutputFilename(filename)));
+
+            reporter(filename, written ? STATUS_OK : STATUS_UNWRITABLE);
+        }
+    }
+
+    filenames.clear();
+}
+
+void EditPipeline::runStage(enum ep_stage stage, const QStringList &filenames,
+                            QAtomicInt &next, Queue *input, Queue *output) {
+    QElapsedTimer timer;
+    Job           job;
+    SaveBatch     batch;
+    QStringList   batched;
+
+    for (;;) {
+        if (input) {
+            if (!input->pop(job)) {
+                break;
+            }
+        } else {
+            const int index = next.fetchAndAddRelaxed(1);
+
+            if (index >= filenames.size()) {
+                break;
+            }
+
+            job          = Job();
+            job.filename = filenames.at(index);
+        }
+
+        timer.start();
+
+        const bool passed = process(stage, job, batch);
+
+        if (passed && (stage == STAGE_WRITE)) {
+            batched.append(job.filename);
+
+            if (batch.getCount() >= batchSize) {
+                commitBatch(batch, batched);
+            }
+        }
+
+        nsecs[stage].fetchAndAddRelaxed(timer.nsecsElapsed());
+        items[stage].fetchAndAddRelaxed(1);
+
+        if (passed && output) {
+            output->push(std::move(job));
+        } else if (!passed && reporter) {
+            reporter(job.filename, job.status);
+        }
+    }
+
+    if (!batched.isEmpty()) {
+        timer.start();
+        commitBatch(batch, batched);
+        nsecs[stage].fetchAndAddRelaxed(timer.nsecsElapsed());
+    }
+
+    if (output) {
+        output->close();
+    }
+}
+
+void EditPipeline::run(const QStringList &filenames) {
+    std::vector<std::unique_ptr<Queue>>       queues;
+    std::vector<std::unique_ptr<StageThread>> workers;
+    QAtomicInt                                next(0);
+    QElapsedTimer                             timer;
+    QHash<QString, int>                       targets;
+    QStringList                               targetOf, pending;
+
+    // find the files that share an output before anything is written, so
+    // neither one ends up silently replaced by the other
+    for (const QString &filename : filenames) {
+        const QString target = QFileInfo(resolveFile(
+            getOutputFilename(filename))).absoluteFilePath();
+
+        targetOf.append(target);
+        ++targets[target];
+    }
+
+    for (int i = 0; i < filenames.size(); ++i) {
+        if (targets.value(targetOf.at(i)) == 1) {
+            pending.append(filenames.at(i));
+        } else if (reporter) {
+            reporter(filenames.at(i), STATUS_CONFLICT);
+        }
+    }
+
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        items[stage].storeRelease(0);
+        nsecs[stage].storeRelease(0);
+    }
+
+    // queues[i] carries files from stage i to stage i + 1
+    for (int stage = 0; stage < STAGE_COUNT - 1; ++stage) {
+        queues.emplace_back(new Queue(queueDepth, threads[stage]));
+    }
+
+    timer.start();
+
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        Queue *input  = (stage > 0) ? queues[stage - 1].get() : nullptr;
+        Queue *output = (stage < STAGE_COUNT - 1) ? queues[stage].get()
+                                                   : nullptr;
+
+        for (int i = 0; i < threads[stage]; ++i) {
+            auto s = static_cast<enum ep_stage>(stage);
+
+            workers.emplace_back(new StageThread(
+                [this, s, &pending, &next, input, output] {
+                    runStage(s, pending, next, input, output);
+                }));
+            workers.back()->start();
+        }
+    }
+
+    for (auto &worker : workers) {
+        worker->wait();
+    }
+
+    elapsed = timer.nsecsElapsed();
+}
@@ -0,0 +1,275 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_EDITPIPELINE_HH_
+#define LOZSRAME_EDITPIPELINE_HH_
+
+#include <functional>
+
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+#include "batch/boundedqueue.hh"
+#include "batch/savebatch.hh"
+#include "model/editscript.hh"
+#include "model/sramfile.hh"
+
+namespace lozsrame {
+    /// the stages of an edit pipeline, in the order files pass through them
+    enum ep_stage {
+        STAGE_READ,
+        STAGE_DECODE,
+        STAGE_EDIT,
+        STAGE_CHECKSUM,
+        STAGE_WRITE,
+        STAGE_COUNT
+    };
+
+    /// what happened to a file sent through an edit pipeline
+    enum ep_status {
+        STATUS_OK,
+        STATUS_UNREADABLE,
+        STATUS_INVALID,
+        STATUS_UNWRITABLE,
+        STATUS_CONFLICT
+    };
+
+    /**
+     * Applies an edit script to many SRAM files, streaming them through
+     * read, decode, edit, checksum, and write stages. Each stage runs on
+     * its own threads and hands files to the next through a bounded queue,
+     * so reading and writing overlap with the work in between instead of
+     * each file waiting on the disk in turn.
+     */
+    class EditPipeline {
+      public:
+        /// called with the result for each file, from a pipeline thread
+        typedef std::function<void(const QString &, enum ep_status)> Reporter;
+
+      private:
+        /// a file moving through the pipeline
+        struct Job {
+            QString                  filename;
+            QByteArray               data;
+            QSharedPointer<SRAMFile> sram;
+            enum ep_status           status = STATUS_OK;
+        };
+
+        /// a queue between two stages
+        typedef BoundedQueue<Job> Queue;
+
+        /// a thread running one of the stages
+        class StageThread : public QThread {
+          private:
+            std::function<void()> body;
+
+          protected:
+            /**
+             * Runs the stage.
+             */
+            void run();
+
+          public:
+            /**
+             * Creates a new StageThread.
+             *
+             * @param body The stage loop to run.
+             */
+            StageThread(std::function<void()> body);
+        };
+
+        const EditScript      &script;
+        QString                outputDirectory;
+        Reporter               reporter;
+        int                    threads[STAGE_COUNT];
+        int                    queueDepth, batchSize;
+        QAtomicInteger<qint64> items[STAGE_COUNT], nsecs[STAGE_COUNT];
+        qint64                 elapsed;
+
+        /**
+         * Gets the file an edited file is written to.
+         *
+         * @param filename The file being edited.
+         *
+         * @return The file to write.
+         */
+        QString getOutputFilename(const QString &filename) const;
+
+        /**
+         * Runs one stage on a file.
+         *
+         * @param stage The stage.
+         * @param job The file.
+         * @param batch The batch the write stage adds the file to.
+         *
+         * @return true to pass the file on; false if it failed.
+         */
+        bool process(enum ep_stage stage, Job &job, SaveBatch &batch);
+
+        /**
+         * Commits the files a write stage thread has batched and reports
+         * their results.
+         *
+         * @param batch The batch.
+         * @param filenames The files being edited, in the batch. Cleared
+         *                  once they have been reported.
+         */
+        void commitBatch(SaveBatch &batch, QStringList &filenames);
+
+        /**
+         * Runs the loop of one stage thread until its input runs out.
+         *
+         * @param stage The stage.
+         * @param filenames The files to edit, for the read stage.
+         * @param next The index of the next file, for the read stage.
+         * @param input The queue to take files from, or nullptr.
+         * @param output The queue to pass files to, or nullptr.
+         */
+        void runStage(enum ep_stage stage, const QStringList &filenames,
+                      QAtomicInt &next, Queue *input, Queue *output);
+
+      public:
+        /**
+         * Creates a new EditPipeline.
+         *
+         * @param script The edits to make. It must outlive the pipeline.
+         */
+        EditPipeline(const EditScript &script);
+
+        /**
+         * Sets the directory edited files are written to. By default, or
+         * if the directory is empty, files are overwritten in place.
+         *
+         * @param directory The output directory.
+         */
+        void setOutputDirectory(const QString &directory);
+
+        /**
+         * Sets the function called with the result for each file. It is
+         * called from the pipeline threads, so it must be thread safe.
+         *
+         * @param reporter The function.
+         */
+        void setReporter(const Reporter &reporter);
+
+        /**
+         * Sets the number of files each queue between stages holds.
+         *
+         * @param depth The queue depth.
+         */
+        void setQueueDepth(int depth);
+
+        /**
+         * Sets the number of files each write thread saves before syncing
+         * them to disk together. Files aren't reported until they have
+         * been synced.
+         *
+         * @param size The batch size.
+         */
+        void setBatchSize(int size);
+
+        /**
+         * Gets the number of threads a stage runs on.
+         *
+         * @param stage The stage.
+         *
+         * @return The number of threads.
+         */
+        int getThreadCount(enum ep_stage stage) const;
+
+        /**
+         * Sets the number of threads a stage runs on.
+         *
+         * @param stage The stage.
+         * @param count The number of threads.
+         */
+        void setThreadCount(enum ep_stage stage, int count);
+
+        /**
+         * Sends files through the pipeline, returning once they have all
+         * been written or have failed. Files are saved crash safely, so an
+         * interrupted run leaves each file either edited or untouched.
+         * Files which would be written to the same output file, such as
+         * two inputs with the same name and an output directory, are
+         * reported as conflicts and left alone.
+         *
+         * @param filenames The files to edit.
+         */
+        void run(const QStringList &filenames);
+
+        /**
+         * Gets the number of files a stage handled in the last run.
+         *
+         * @param stage The stage.
+         *
+         * @return The number of files.
+         */
+        qint64 getStageItems(enum ep_stage stage) const;
+
+        /**
+         * Gets the time the threads of a stage spent working in the last
+         * run, not counting time spent waiting on the queues.
+         *
+         * @param stage The stage.
+         *
+         * @return The total time in nanoseconds.
+         */
+        qint64 getStageTime(enum ep_stage stage) const;
+
+        /**
+         * Gets the wall clock time of the last run.
+         *
+         * @return The time in nanoseconds.
+         */
+        qint64 getElapsedTime() const;
+
+        /**
+         * Gets the name of a stage.
+         *
+         * @param stage The stage.
+         *
+         * @return The name.
+         */
+        static const char *getStageName(enum ep_stage stage);
+    };
+
+    inline int EditPipeline::getThreadCount(enum ep_stage stage) const {
+        return threads[stage];
+    }
+
+    inline qint64 EditPipeline::getStageItems(enum ep_stage stage) const {
+        return items[stage].loadAcquire();
+    }
+
+    inline qint64 EditPipeline::getStageTime(enum ep_stage stage) const {
+        return nsecs[stage].loadAcquire();
+    }
+
+    inline qint64 EditPipeline::getElapsedTime() const {
+        return elapsed;
+    }
+}  // namespace lozsrame
+
+#endif
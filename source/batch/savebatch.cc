@@ -0,0 +1,117 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+
+#include "batch/savebatch.hh"
+#include "model/filesync.hh"
+
+using namespace lozsrame;
+
+SaveBatch::~SaveBatch() {
+    rollback();
+}
+
+auto SaveBatch::add(const QString &filename, const QByteArray &data) -> bool {
+    Entry entry;
+
+    entry.target    = resolveFile(filename);
+    entry.temporary = writeTemporary(entry.target, data, false);
+
+    if (entry.temporary.isEmpty()) {
+        return false;
+    }
+
+    entries.append(entry);
+
+    return true;
+}
+
+auto SaveBatch::add(const QString &filename, SRAMFile &sram) -> bool {
+    return add(filename, sram.toData());
+}
+
+auto SaveBatch::commit(QStringList *failed) -> bool {
+    QHash<QString, quint64> directories;
+    QHash<quint64, bool>    devices;
+    bool                    ok = true;
+
+    for (const Entry &entry : entries) {
+        const QString directory = QFileInfo(entry.target).absolutePath();
+
+        if (!directories.contains(directory)) {
+            directories.insert(directory, getFileSystem(directory));
+        }
+    }
+
+    // the data must be on disk before the renames are, or a crash could
+    // leave an empty file behind; one syncfs flushes every directory on
+    // the same device, and only files on a device that failed to sync are
+    // synced one by one
+    for (auto it = directories.constBegin(); it != directories.constEnd();
+         ++it) {
+        if (!devices.contains(it.value())) {
+            devices.insert(it.value(),
+                           (it.value() != 0) && syncFileSystem(it.key()));
+        }
+    }
+
+    for (const Entry &entry : entries) {
+        const QString directory = QFileInfo(entry.target).absolutePath();
+        bool          replaced  = true;
+
+        if (!devices.value(directories.value(directory))) {
+            QFile file(entry.temporary);
+
+            replaced = file.open(QIODevice::ReadWrite) && syncFile(file);
+        }
+
+        replaced = replaced && replaceFile(entry.temporary, entry.target);
+
+        if (!replaced) {
+            QFile::remove(entry.temporary);
+            ok = false;
+
+            if (failed) {
+                failed->append(entry.target);
+            }
+        }
+    }
+
+    for (auto it = directories.constBegin(); it != directories.constEnd();
+         ++it) {
+        syncDirectory(it.key());
+    }
+
+    entries.clear();
+
+    return ok;
+}
+
+void SaveBatch::rollback() {
+    for (const Entry &entry : entries) {
+        QFile::remove(entry.temporary);
+    }
+
+    entries.clear();
+}
@@ -0,0 +1,118 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_SAVEBATCH_HH_
+#define LOZSRAME_SAVEBATCH_HH_
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "model/sramfile.hh"
+
+namespace lozsrame {
+    /**
+     * Saves many SRAM files at once, crash safely, with as few disk syncs
+     * as possible. Each file added is written to a temporary file next to
+     * it, and commit() then flushes them all with one sync per device
+     * before renaming them over the originals and syncing each of their
+     * directories once. Saving each file atomically on its own would wait
+     * on the disk twice per file instead.
+     *
+     * Files that haven't been committed are discarded when the batch is
+     * destroyed.
+     */
+    class SaveBatch {
+      private:
+        /// a file waiting to be committed
+        struct Entry {
+            QString target, temporary;
+        };
+
+        QVector<Entry> entries;
+
+      public:
+        /**
+         * Creates a new, empty SaveBatch.
+         */
+        SaveBatch() = default;
+
+        SaveBatch(const SaveBatch &) = delete;
+        SaveBatch &operator=(const SaveBatch &) = delete;
+
+        /**
+         * Destroys a SaveBatch, discarding any uncommitted files.
+         */
+        ~SaveBatch();
+
+        /**
+         * Adds a file to the batch. Its data is written to a temporary file
+         * right away, but the file itself is untouched until commit().
+         *
+         * @param filename The file to save to.
+         * @param data The data to save.
+         *
+         * @return true if the data was written; false otherwise.
+         */
+        bool add(const QString &filename, const QByteArray &data);
+
+        /**
+         * Adds an SRAM file to the batch.
+         *
+         * @param filename The file to save to.
+         * @param sram The SRAM file. Unlike SRAMFile::save(), this doesn't
+         *             clear its modified flags.
+         *
+         * @return true if the data was written; false otherwise.
+         */
+        bool add(const QString &filename, SRAMFile &sram);
+
+        /**
+         * Gets the number of files waiting to be committed.
+         *
+         * @return The number of files.
+         */
+        int getCount() const;
+
+        /**
+         * Replaces every file in the batch with its new data, leaving the
+         * batch empty.
+         *
+         * @param failed If not nullptr, the files that couldn't be replaced
+         *               are appended to it. They keep their old data.
+         *
+         * @return true if every file was replaced; false otherwise.
+         */
+        bool commit(QStringList *failed = nullptr);
+
+        /**
+         * Discards every file in the batch without replacing anything.
+         */
+        void rollback();
+    };
+
+    inline int SaveBatch::getCount() const {
+        return entries.size();
+    }
+}  // namespace lozsrame
+
+#endif
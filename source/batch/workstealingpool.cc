@@ -0,0 +1,189 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <QMutexLocker>
+
+#include "batch/workstealingpool.hh"
+
+using namespace lozsrame;
+
+WorkStealingPool::Worker::Worker(WorkStealingPool *pool, int index)
+    : pool(pool), index(index) {}
+
+void WorkStealingPool::Worker::run() {
+    current() = {pool, index};
+
+    Task task;
+
+    for (;;) {
+        if (pool->take(index, task)) {
+            task();
+            task = nullptr;
+
+            if (!pool->outstanding.deref()) {
+                QMutexLocker locker(&pool->mutex);
+                pool->allDone.wakeAll();
+            }
+
+            continue;
+        }
+
+        QMutexLocker locker(&pool->mutex);
+
+        if (pool->stopping) {
+            break;
+        }
+
+        // recheck under the lock so a concurrent submit can't be missed
+        if (pool->queued.loadAcquire() == 0) {
+            pool->workAvailable.wait(&pool->mutex);
+        }
+    }
+}
+
+WorkStealingPool::WorkStealingPool(int threads)
+    : queued(0), outstanding(0), next(0), stopping(false) {
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    for (int i = 0; i < threads; ++i) {
+        queues.emplace_back(new Queue);
+    }
+
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(new Worker(this, i));
+        workers.back()->start();
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    waitForDone();
+
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        workAvailable.wakeAll();
+    }
+
+    for (auto &worker : workers) {
+        worker->wait();
+    }
+}
+
+auto WorkStealingPool::current() -> Current & {
+    static thread_local Current current = {nullptr, -1};
+
+    return current;
+}
+
+auto WorkStealingPool::take(int index, Task &task) -> bool {
+    const int count = static_cast<int>(queues.size());
+
+    // own queue first, newest task (still warm in cache)
+    {
+        Queue       &own = *queues[index];
+        QMutexLocker locker(&own.mutex);
+
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued.deref();
+
+            return true;
+        }
+    }
+
+    // steal the oldest task from someone else
+    for (int i = 1; i < count; ++i) {
+        Queue &victim = *queues[(index + i) % count];
+
+        if (!victim.mutex.tryLock()) {
+            continue;
+        }
+
+        bool stolen = !victim.tasks.empty();
+
+        if (stolen) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued.deref();
+        }
+
+        victim.mutex.unlock();
+
+        if (stolen) {
+            return true;
+        }
+    }
+
+    // every queue was empty or busy; only give up if nothing is queued
+    if (queued.loadAcquire() == 0) {
+        return false;
+    }
+
+    for (int i = 1; i < count; ++i) {
+        Queue       &victim = *queues[(index + i) % count];
+        QMutexLocker locker(&victim.mutex);
+
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued.deref();
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::submit(Task task) {
+    const Current &self  = current();
+    int            index = ((self.owner == this) ? self.index : -1);
+
+    // tasks from outside the pool, including from the workers of other
+    // pools, are dealt out round robin
+    if (index < 0) {
+        index = (next.fetchAndAddRelaxed(1) & 0x7FFFFFFF)
+                % static_cast<int>(queues.size());
+    }
+
+    outstanding.ref();
+
+    {
+        Queue       &queue = *queues[index];
+        QMutexLocker locker(&queue.mutex);
+        queue.tasks.push_back(std::move(task));
+        queued.ref();
+    }
+
+    QMutexLocker locker(&mutex);
+    workAvailable.wakeOne();
+}
+
+void WorkStealingPool::waitForDone() {
+    QMutexLocker locker(&mutex);
+
+    while (outstanding.loadAcquire() != 0) {
+        allDone.wait(&mutex);
+    }
+}
@@ -0,0 +1,153 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_WORKSTEALINGPOOL_HH_
+#define LOZSRAME_WORKSTEALINGPOOL_HH_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+namespace lozsrame {
+    /**
+     * A fixed size thread pool where every worker owns a task queue.
+     *
+     * Tasks submitted from a worker go to that worker's own queue and are
+     * run newest first. Idle workers steal the oldest task from the other
+     * queues, so a task which fans out (like a directory walk) spreads across
+     * the pool without every submission contending on one shared queue.
+     */
+    class WorkStealingPool {
+      public:
+        /// the type of task run by the pool
+        typedef std::function<void()> Task;
+
+      private:
+        /// a worker's task queue
+        struct Queue {
+            QMutex           mutex;
+            std::deque<Task> tasks;
+        };
+
+        /// a thread running tasks from the pool
+        class Worker : public QThread {
+          private:
+            WorkStealingPool *pool;
+            int               index;
+
+          protected:
+            /**
+             * Runs tasks until the pool is stopped.
+             */
+            void run();
+
+          public:
+            /**
+             * Creates a new Worker.
+             *
+             * @param pool The pool to run tasks from.
+             * @param index The worker's queue index.
+             */
+            Worker(WorkStealingPool *pool, int index);
+        };
+
+        std::vector<std::unique_ptr<Queue>>  queues;
+        std::vector<std::unique_ptr<Worker>> workers;
+        QAtomicInt                           queued, outstanding, next;
+        QMutex                               mutex;
+        QWaitCondition                       workAvailable, allDone;
+        bool                                 stopping;
+
+        /**
+         * Takes a task for a worker, stealing from other workers if its
+         * own queue is empty.
+         *
+         * @param index The worker's queue index.
+         * @param task Where to store the task.
+         *
+         * @return true if a task was taken; false otherwise.
+         */
+        bool take(int index, Task &task);
+
+        /// the pool and queue of the worker running a thread
+        struct Current {
+            const WorkStealingPool *owner;
+            int                     index;
+        };
+
+        /**
+         * Gets the pool and queue index of the worker running the calling
+         * thread. A worker of one pool may submit to another, so the index
+         * only means something to its owner.
+         *
+         * @return The pool and queue index, or a null pool and -1 if not
+         *         called from a worker.
+         */
+        static Current &current();
+
+      public:
+        /**
+         * Creates a new WorkStealingPool.
+         *
+         * @param threads The number of worker threads.
+         */
+        explicit WorkStealingPool(int threads = QThread::idealThreadCount());
+
+        /**
+         * Waits for all tasks to finish and stops the workers.
+         */
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool &) = delete;
+        WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+        /**
+         * Gets the number of worker threads.
+         *
+         * @return The thread count.
+         */
+        int getThreadCount() const;
+
+        /**
+         * Submits a task to the pool. Tasks may submit further tasks.
+         *
+         * @param task The task to run.
+         */
+        void submit(Task task);
+
+        /**
+         * Blocks until every submitted task has finished.
+         */
+        void waitForDone();
+    };
+
+    inline int WorkStealingPool::getThreadCount() const {
+        return static_cast<int>(workers.size());
+    }
+}  // namespace lozsrame
+
+#endif
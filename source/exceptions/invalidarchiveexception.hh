@@ -0,0 +1,68 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_INVALIDARCHIVEEXCEPTION_HH_
+#define LOZSRAME_INVALIDARCHIVEEXCEPTION_HH_
+
+#include <stdexcept>
+
+namespace lozsrame {
+    /// The possible InvalidArchiveException error codes
+    enum iae_error {
+        IAE_READERROR,
+        IAE_UNKNOWNFORMAT,
+        IAE_CORRUPT,
+        IAE_UNSUPPORTED
+    };
+
+    /**
+     * Exception thrown when SaveArchiveReader is passed an invalid archive.
+     */
+    class InvalidArchiveException : public std::runtime_error {
+      private:
+        enum iae_error error;
+
+      public:
+        /**
+         * Creates a new InvalidArchiveException.
+         *
+         * @param error The error code that triggered this exception.
+         */
+        InvalidArchiveException(enum iae_error error);
+
+        /**
+         * Gets the error code for this InvalidArchiveException.
+         *
+         * @return The error code.
+         */
+        enum iae_error getError() const;
+    };
+
+    inline InvalidArchiveException::InvalidArchiveException(
+        enum iae_error error)
+        : std::runtime_error("InvalidArchiveException"), error(error) {}
+
+    inline enum iae_error InvalidArchiveException::getError() const {
+        return error;
+    }
+}  // namespace lozsrame
+
+#endif
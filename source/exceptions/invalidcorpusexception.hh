@@ -0,0 +1,63 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_INVALIDCORPUSEXCEPTION_HH_
+#define LOZSRAME_INVALIDCORPUSEXCEPTION_HH_
+
+#include <stdexcept>
+
+namespace lozsrame {
+    /// The possible InvalidCorpusException error codes
+    enum ice_error { ICE_FILENOTFOUND, ICE_INVALIDFORMAT };
+
+    /**
+     * Exception thrown when SaveCorpus is passed an invalid corpus file.
+     */
+    class InvalidCorpusException : public std::runtime_error {
+      private:
+        enum ice_error error;
+
+      public:
+        /**
+         * Creates a new InvalidCorpusException.
+         *
+         * @param error The error code that triggered this exception.
+         */
+        InvalidCorpusException(enum ice_error error);
+
+        /**
+         * Gets the error code for this InvalidCorpusException.
+         *
+         * @return The error code.
+         */
+        enum ice_error getError() const;
+    };
+
+    inline InvalidCorpusException::InvalidCorpusException(
+        enum ice_error error)
+        : std::runtime_error("InvalidCorpusException"), error(error) {}
+
+    inline enum ice_error InvalidCorpusException::getError() const {
+        return error;
+    }
+}  // namespace lozsrame
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_INVALIDEDITSCRIPTEXCEPTION_HH_
+#define LOZSRAME_INVALIDEDITSCRIPTEXCEPTION_HH_
+
+#include <stdexcept>
+
+namespace lozsrame {
+    /// The possible InvalidEditScriptException error codes
+    enum iese_error { IESE_FILENOTFOUND, IESE_SYNTAX };
+
+    /**
+     * Exception thrown when EditScript is passed an invalid script.
+     */
+    class InvalidEditScriptException : public std::runtime_error {
+      private:
+        enum iese_error error;
+        int             line;
+
+      public:
+        /**
+         * Creates a new InvalidEditScriptException.
+         *
+         * @param error The error code that triggered this exception.
+         * @param line The script line with the error, or 0 if none.
+         */
+        InvalidEditScriptException(enum iese_error error, int line = 0);
+
+        /**
+         * Gets the error code for this InvalidEditScriptException.
+         *
+         * @return The error code.
+         */
+        enum iese_error getError() const;
+
+        /**
+         * Gets the script line with the error.
+         *
+         * @return The line number, or 0 if none.
+         */
+        int getLine() const;
+    };
+
+    inline InvalidEditScriptException::InvalidEditScriptException(
+        enum iese_error error, int line)
+        : std::runtime_error("InvalidEditScriptException"), error(error),
+          line(line) {}
+
+    inline enum iese_error InvalidEditScriptException::getError() const {
+        return error;
+    }
+
+    inline int InvalidEditScriptException::getLine() const {
+        return line;
+    }
+}  // namespace lozsrame
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_INVALIDSAVESTOREEXCEPTION_HH_
+#define LOZSRAME_INVALIDSAVESTOREEXCEPTION_HH_
+
+#include <stdexcept>
+
+namespace lozsrame {
+    /// The possible InvalidSaveStoreException error codes
+    enum isse_error { ISSE_COLLISION, ISSE_FILENOTFOUND, ISSE_INVALIDFORMAT };
+
+    /**
+     * Exception thrown when SaveStore is passed an invalid store file, or
+     * two different SRAM images hash to the same key.
+     */
+    class InvalidSaveStoreException : public std::runtime_error {
+      private:
+        enum isse_error error;
+
+      public:
+        /**
+         * Creates a new InvalidSaveStoreException.
+         *
+         * @param error The error code that triggered this exception.
+         */
+        InvalidSaveStoreException(enum isse_error error);
+
+        /**
+         * Gets the error code for this InvalidSaveStoreException.
+         *
+         * @return The error code.
+         */
+        enum isse_error getError() const;
+    };
+
+    inline InvalidSaveStoreException::InvalidSaveStoreException(
+        enum isse_error error)
+        : std::runtime_error("InvalidSaveStoreException"), error(error) {}
+
+    inline enum isse_error InvalidSaveStoreException::getError() const {
+        return error;
+    }
+}  // namespace lozsrame
+
+#endif
@@ -0,0 +1,23 @@
+# shared model sources used by lozsrame and its command line tools
+
+DEPENDPATH += $$PWD $$PWD/exceptions $$PWD/model
+INCLUDEPATH += $$PWD
+CONFIG += c++14
+
+HEADERS += $$PWD/exceptions/invalidsramfileexception.hh \
+	$$PWD/model/checksum.hh \
+	$$PWD/model/filesync.hh \
+	$$PWD/model/mapstate.hh \
+	$$PWD/model/namecodec.hh \
+	$$PWD/model/simd.hh \
+	$$PWD/model/srambatch.hh \
+	$$PWD/model/sramfile.hh \
+	$$PWD/model/sramstats.hh
+
+SOURCES += $$PWD/exceptions/invalidsramfileexception.cc \
+	$$PWD/model/checksum.cc \
+	$$PWD/model/filesync.cc \
+	$$PWD/model/mapstate.cc \
+	$$PWD/model/srambatch.cc \
+	$$PWD/model/sramfile.cc \
+	$$PWD/model/sramstats.cc
@@ -1,17 +1,17 @@
 TEMPLATE = app
 TARGET = lozsrame
-DEPENDPATH += . exceptions model resources view
+DEPENDPATH += . resources view
 INCLUDEPATH += .
-QT += widgets
+QT += concurrent widgets
 
-HEADERS += exceptions/invalidsramfileexception.hh \
-	model/sramfile.hh \
-	view/mainwindow.hh
+include(lozsrame.pri)
+
+HEADERS += view/mainwindow.hh \
+	view/savefoldermodel.hh
 
 SOURCES += lozsrame.cc \
-	exceptions/invalidsramfileexception.cc \
-	model/sramfile.cc \
-	view/mainwindow.cc
+	view/mainwindow.cc \
+	view/savefoldermodel.cc
            
 FORMS += view/mainwindow.ui
 RESOURCES += resources/lozsrame.qrc
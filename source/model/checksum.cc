@@ -0,0 +1,303 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "model/checksum.hh"
+#include "model/simd.hh"
+#include "model/sramfile.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /// a checksum kernel
+    typedef quint16 (*Kernel)(const char *, int);
+
+    /**
+     * Sums the four misc bytes, which are interleaved between the games.
+     *
+     * @param sram The SRAM image.
+     * @param game The game.
+     *
+     * @return The sum.
+     */
+    inline auto miscSum(const char *sram, int game) -> unsigned int {
+        const auto *ptr =
+            reinterpret_cast<const unsigned char *>(sram + MISC_DATA + game);
+
+        return (ptr[0] + ptr[3] + ptr[6] + ptr[9]);
+    }
+
+    /**
+     * The reference kernel, adding one byte at a time like the game does.
+     */
+    auto scalarChecksum(const char *sram, int game) -> quint16 {
+        const auto  *data     = reinterpret_cast<const unsigned char *>(sram);
+        unsigned int checksum = miscSum(sram, game);
+
+        for (int i = 0; i < NAME_DATA_SIZE; ++i) {
+            checksum += data[NAME_DATA + i + (game * NAME_DATA_SIZE)];
+        }
+
+        for (int i = 0; i < INVENTORY_DATA_SIZE; ++i) {
+            checksum += data[INVENTORY_DATA + i + (game * INVENTORY_DATA_SIZE)];
+        }
+
+        for (int i = 0; i < MAP_DATA_SIZE; ++i) {
+            checksum += data[MAP_DATA + i + (game * MAP_DATA_SIZE)];
+        }
+
+        // the game's 16-bit add carries out of the high byte and is lost
+        return static_cast<quint16>(checksum);
+    }
+
+#ifdef LOZSRAME_SIMD
+    /**
+     * Sums 8 bytes into the low lane of a 64-bit pair.
+     *
+     * @param ptr The bytes.
+     *
+     * @return The sum.
+     */
+    LOZSRAME_TARGET("sse2")
+    inline auto sum8(const char *ptr) -> __m128i {
+        return _mm_sad_epu8(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(ptr)),
+            _mm_setzero_si128());
+    }
+
+    /**
+     * Sums 16 bytes into a pair of 64-bit lanes.
+     *
+     * @param ptr The bytes.
+     *
+     * @return The sums.
+     */
+    LOZSRAME_TARGET("sse2")
+    inline auto sum16(const char *ptr) -> __m128i {
+        return _mm_sad_epu8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr)),
+            _mm_setzero_si128());
+    }
+
+    /**
+     * Adds together the two 64-bit lanes of a sum.
+     *
+     * @param sum The lanes.
+     *
+     * @return The total.
+     */
+    LOZSRAME_TARGET("sse2")
+    inline auto total(__m128i sum) -> unsigned int {
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+
+        return static_cast<unsigned int>(_mm_cvtsi128_si32(sum));
+    }
+
+    /**
+     * The SSE2 kernel. PSADBW against zero sums 8 bytes per 64-bit lane, so
+     * the 0x180 map bytes take 24 loads instead of 384 adds.
+     */
+    LOZSRAME_TARGET("sse2")
+    auto sse2Checksum(const char *sram, int game) -> quint16 {
+        const char *name      = sram + NAME_DATA + (game * NAME_DATA_SIZE);
+        const char *inventory =
+            sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE);
+        const char *map = sram + MAP_DATA + (game * MAP_DATA_SIZE);
+
+        // 0x8 + 0x28 = 8 + 16 + 16 + 8
+        __m128i sum = _mm_add_epi64(sum8(name), sum16(inventory));
+        sum         = _mm_add_epi64(sum, sum16(inventory + 16));
+        sum         = _mm_add_epi64(sum, sum8(inventory + 32));
+
+        for (int i = 0; i < MAP_DATA_SIZE; i += 16) {
+            sum = _mm_add_epi64(sum, sum16(map + i));
+        }
+
+        return static_cast<quint16>(total(sum) + miscSum(sram, game));
+    }
+
+    /**
+     * The AVX2 kernel. Same as SSE2, but 32 bytes per load.
+     */
+    LOZSRAME_TARGET("avx2")
+    auto avx2Checksum(const char *sram, int game) -> quint16 {
+        const char *name      = sram + NAME_DATA + (game * NAME_DATA_SIZE);
+        const char *inventory =
+            sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE);
+        const char *map = sram + MAP_DATA + (game * MAP_DATA_SIZE);
+
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i       wide = _mm256_sad_epu8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inventory)),
+            zero);
+
+        for (int i = 0; i < MAP_DATA_SIZE; i += 32) {
+            wide = _mm256_add_epi64(
+                wide,
+                _mm256_sad_epu8(
+                    _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i *>(map + i)),
+                    zero));
+        }
+
+        // 0x28 inventory bytes = 32 + 8, plus the 8 name bytes
+        __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(wide),
+                                    _mm256_extracti128_si256(wide, 1));
+        sum         = _mm_add_epi64(sum, sum8(name));
+        sum         = _mm_add_epi64(sum, sum8(inventory + 32));
+
+        return static_cast<quint16>(total(sum) + miscSum(sram, game));
+    }
+
+    /**
+     * Checks which SIMD extensions the processor and operating system
+     * support.
+     *
+     * @param sse2 Set to true if SSE2 is supported.
+     * @param avx2 Set to true if AVX2 is supported.
+     */
+    void detect(bool &sse2, bool &avx2) {
+    #ifdef _MSC_VER
+        int info[4];
+
+        __cpuid(info, 0);
+        const int max = info[0];
+
+        __cpuid(info, 1);
+        sse2 = (info[3] & (1 << 26));
+
+        // AVX2 needs the OS to save the YMM registers too
+        const bool osxsave = (info[2] & (1 << 27)) && (info[2] & (1 << 28))
+                             && ((_xgetbv(0) & 0x6) == 0x6);
+
+        avx2 = false;
+
+        if (osxsave && (max >= 7)) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5));
+        }
+    #else
+        __builtin_cpu_init();
+        sse2 = __builtin_cpu_supports("sse2");
+        avx2 = __builtin_cpu_supports("avx2");
+    #endif
+    }
+#endif
+
+    /**
+     * Picks the fastest kernel this processor supports.
+     *
+     * @return The kernel.
+     */
+    auto selectKernel() -> enum cs_kernel {
+#ifdef LOZSRAME_SIMD
+        bool sse2, avx2;
+
+        detect(sse2, avx2);
+
+        if (avx2) {
+            return KERNEL_AVX2;
+        }
+
+        if (sse2) {
+            return KERNEL_SSE2;
+        }
+#endif
+
+        return KERNEL_SCALAR;
+    }
+
+    /**
+     * Gets the function implementing a kernel.
+     *
+     * @param kernel The kernel.
+     *
+     * @return The function.
+     */
+    auto kernelFunction(enum cs_kernel kernel) -> Kernel {
+        switch (kernel) {
+#ifdef LOZSRAME_SIMD
+            case KERNEL_AVX2:
+                return avx2Checksum;
+            case KERNEL_SSE2:
+                return sse2Checksum;
+#endif
+            default:
+                return scalarChecksum;
+        }
+    }
+
+    /**
+     * Gets the fastest kernel this processor supports. It is picked the
+     * first time it is needed rather than at startup, so a checksum taken
+     * from another file's static initializer still finds it.
+     *
+     * @return The kernel.
+     */
+    auto getBestKernel() -> enum cs_kernel {
+        static const enum cs_kernel kernel = selectKernel();
+
+        return kernel;
+    }
+
+    /**
+     * Gets the function implementing the fastest kernel.
+     *
+     * @return The function.
+     */
+    auto getDispatch() -> Kernel {
+        static const Kernel dispatch = kernelFunction(getBestKernel());
+
+        return dispatch;
+    }
+}  // namespace
+
+auto lozsrame::getChecksumKernel() -> enum cs_kernel {
+    return getBestKernel();
+}
+
+auto lozsrame::getChecksumKernelName(enum cs_kernel kernel) -> const char * {
+    switch (kernel) {
+        case KERNEL_SSE2:
+            return "sse2";
+        case KERNEL_AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+auto lozsrame::isChecksumKernelSupported(enum cs_kernel kernel) -> bool {
+    return (kernel <= getBestKernel());
+}
+
+auto lozsrame::slotChecksum(const char *sram, int game) -> quint16 {
+    Q_ASSERT((game >= 0) && (game < 3));
+
+    return getDispatch()(sram, game);
+}
+
+auto lozsrame::slotChecksum(const char *sram, int game, enum cs_kernel kernel)
+    -> quint16 {
+    Q_ASSERT((game >= 0) && (game < 3));
+    Q_ASSERT(isChecksumKernelSupported(kernel));
+
+    return kernelFunction(kernel)(sram, game);
+}
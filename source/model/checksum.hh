@@ -0,0 +1,82 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_CHECKSUM_HH_
+#define LOZSRAME_CHECKSUM_HH_
+
+#include <QtGlobal>
+
+namespace lozsrame {
+    /// the checksum kernel implementations
+    enum cs_kernel { KERNEL_SCALAR, KERNEL_SSE2, KERNEL_AVX2 };
+
+    /**
+     * Gets the fastest checksum kernel supported by this processor. This is
+     * detected once at startup.
+     *
+     * @return The kernel.
+     */
+    enum cs_kernel getChecksumKernel();
+
+    /**
+     * Gets the name of a checksum kernel.
+     *
+     * @param kernel The kernel.
+     *
+     * @return The kernel's name.
+     */
+    const char *getChecksumKernelName(enum cs_kernel kernel);
+
+    /**
+     * Checks if this processor can run a checksum kernel.
+     *
+     * @param kernel The kernel to check.
+     *
+     * @return true if supported; false otherwise.
+     */
+    bool isChecksumKernelSupported(enum cs_kernel kernel);
+
+    /**
+     * Calculates the checksum for one of the games in an SRAM image using
+     * the fastest supported kernel. The result matches the game's own
+     * routine documented above SRAMFile::checksum.
+     *
+     * @param sram The SRAM image.
+     * @param game The game to checksum.
+     *
+     * @return The checksum.
+     */
+    quint16 slotChecksum(const char *sram, int game);
+
+    /**
+     * Calculates the checksum for one of the games in an SRAM image using a
+     * specific kernel.
+     *
+     * @param sram The SRAM image.
+     * @param game The game to checksum.
+     * @param kernel The kernel to use. It must be supported.
+     *
+     * @return The checksum.
+     */
+    quint16 slotChecksum(const char *sram, int game, enum cs_kernel kernel);
+}  // namespace lozsrame
+
+#endif
@@ -0,0 +1,317 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <QFile>
+#include <QList>
+
+#include "model/editscript.hh"
+#include "model/namecodec.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /// a word a script may use for a value, ended by a null name
+    struct Keyword {
+        const char *name;
+        int         value;
+    };
+
+    /// a field which takes a level, piece or item before the value
+    struct IndexedField {
+        /// the name used in scripts
+        const char *name;
+
+        /// the kind of edit
+        enum es_edit edit;
+
+        /// names allowed for the argument, or a number between the bounds
+        const Keyword *arguments;
+        int            argumentMin, argumentMax;
+    };
+
+    const Keyword ARROWS[] = {{"none", ARROW_NONE},
+                              {"wooden", ARROW_WOODEN},
+                              {"silver", ARROW_SILVER},
+                              {nullptr, 0}};
+
+    const Keyword CANDLES[] = {{"none", CANDLE_NONE},
+                               {"blue", CANDLE_BLUE},
+                               {"red", CANDLE_RED},
+                               {nullptr, 0}};
+
+    const Keyword ITEMS[] = {{"bow", ITEM_BOW},
+                             {"whistle", ITEM_WHISTLE},
+                             {"bait", ITEM_BAIT},
+                             {"wand", ITEM_WAND},
+                             {"raft", ITEM_RAFT},
+                             {"book", ITEM_BOOK},
+                             {"ladder", ITEM_LADDER},
+                             {"magickey", ITEM_MAGICKEY},
+                             {"powerbracelet", ITEM_POWERBRACELET},
+                             {"boomerang", ITEM_BOOMERANG},
+                             {"magicboomerang", ITEM_MAGICBOOMERANG},
+                             {"magicshield", ITEM_MAGICSHIELD},
+                             {nullptr, 0}};
+
+    const Keyword NOTES[] = {{"oldman", NOTE_OLDMAN},
+                             {"link", NOTE_LINK},
+                             {"oldwoman", NOTE_OLDWOMAN},
+                             {nullptr, 0}};
+
+    const Keyword POTIONS[] = {{"none", POTION_NONE},
+                               {"blue", POTION_BLUE},
+                               {"red", POTION_RED},
+                               {nullptr, 0}};
+
+    const Keyword QUESTS[] = {{"first", QUEST_FIRST},
+                              {"second", QUEST_SECOND},
+                              {nullptr, 0}};
+
+    const Keyword RINGS[] = {{"none", RING_NONE},
+                             {"blue", RING_BLUE},
+                             {"red", RING_RED},
+                             {nullptr, 0}};
+
+    const Keyword SWITCHES[] = {{"off", 0}, {"on", 1}, {nullptr, 0}};
+
+    const Keyword SWORDS[] = {{"none", SWORD_NONE},
+                              {"wooden", SWORD_WOODEN},
+                              {"white", SWORD_WHITE},
+                              {"master", SWORD_MASTER},
+                              {nullptr, 0}};
+
+    /// the indexed fields; items are named, never numbered
+    const IndexedField INDEXED_FIELDS[] = {
+        {"compass", EDIT_COMPASS, nullptr, 1, 9},
+        {"item", EDIT_PROPERTY, ITEMS, 0, -1},
+        {"map", EDIT_MAP, nullptr, 1, 9},
+        {"triforce", EDIT_TRIFORCE, nullptr, 1, 8}};
+
+    /**
+     * Gets the names a script may use for the values of a property.
+     *
+     * @param type The type of the property.
+     *
+     * @return The names, or nullptr if it only takes numbers.
+     */
+    auto getKeywords(enum sf_valuetype type) -> const Keyword * {
+        switch (type) {
+            case VALUE_FLAG:
+                return SWITCHES;
+            case VALUE_ARROW:
+                return ARROWS;
+            case VALUE_CANDLE:
+                return CANDLES;
+            case VALUE_NOTE:
+                return NOTES;
+            case VALUE_POTION:
+                return POTIONS;
+            case VALUE_QUEST:
+                return QUESTS;
+            case VALUE_RING:
+                return RINGS;
+            case VALUE_SWORD:
+                return SWORDS;
+            default:
+                return nullptr;
+        }
+    }
+
+    /**
+     * Parses a script word, either one of a list of names or a number.
+     *
+     * @param word The word.
+     * @param keywords The names allowed, or nullptr for none.
+     * @param min The smallest number allowed.
+     * @param max The largest number allowed.
+     * @param value Set to the value of the word.
+     *
+     * @return true if the word is valid; false otherwise.
+     */
+    auto parseWord(const QByteArray &word, const Keyword *keywords, int min,
+                   int max, int &value) -> bool {
+        for (; keywords && keywords->name; ++keywords) {
+            if (word == keywords->name) {
+                value = keywords->value;
+                return true;
+            }
+        }
+
+        bool ok;
+
+        value = word.toInt(&ok);
+
+        return ok && (value >= min) && (value <= max);
+    }
+
+    /**
+     * Checks that a name only uses characters the game can show.
+     *
+     * @param name The name, in upper case.
+     *
+     * @return true if every character is a letter, digit, space or one of
+     *         ,!'&."?_; false otherwise.
+     */
+    auto isNameText(const QByteArray &name) -> bool {
+        for (int i = 0; i < name.size(); ++i) {
+            const auto ch = static_cast<unsigned char>(name.at(i));
+
+            if ((ch != ' ')
+                && ((ch >= 0x80) || (NAME_TABLES.encode[ch] == NAME_SPACE))) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}  // namespace
+
+EditScript::EditScript() {}
+
+EditScript::EditScript(const QString &filename) {
+    QFile file(filename);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw InvalidEditScriptException(IESE_FILENOTFOUND);
+    }
+
+    parse(file.readAll());
+}
+
+auto EditScript::fromText(const QByteArray &text) -> EditScript {
+    EditScript script;
+
+    script.parse(text);
+
+    return script;
+}
+
+void EditScript::parse(const QByteArray &text) {
+    const QList<QByteArray> lines = text.split('\n');
+
+    for (int number = 0; number < lines.size(); ++number) {
+        QByteArray line    = lines.at(number);
+        const int  comment = line.indexOf('#');
+
+        if (comment >= 0) {
+            line.truncate(comment);
+        }
+
+        const QList<QByteArray> words =
+            line.simplified().toLower().split(' ');
+
+        if (words.first().isEmpty()) {
+            continue;
+        }
+
+        Edit edit = {EDIT_PROPERTY, PROPERTY_COUNT, 0, 0, QString()};
+        bool valid;
+
+        if (words.first() == "name") {
+            // the rest of the line, as written, since a name's spaces count;
+            // only the one space after the keyword and any trailing space
+            // are dropped
+            const QByteArray text =
+                line.trimmed().mid(words.first().size() + 1).toUpper();
+
+            edit.edit = EDIT_NAME;
+            edit.name = QString::fromLatin1(text);
+            valid     = (words.size() > 1) && (text.size() <= NAME_DATA_SIZE)
+                        && isNameText(text);
+        } else if (words.size() == 2) {
+            edit.property = findProperty(words.first().constData());
+            valid         = (edit.property != PROPERTY_COUNT);
+
+            if (valid) {
+                const PropertyDescriptor &property =
+                    SRAM_PROPERTIES[edit.property];
+
+                valid = parseWord(words.last(), getKeywords(property.type),
+                                  property.minimum, property.maximum,
+                                  edit.value);
+            }
+        } else {
+            const IndexedField *field = nullptr;
+
+            for (const IndexedField &candidate : INDEXED_FIELDS) {
+                if (words.first() == candidate.name) {
+                    field = &candidate;
+                    break;
+                }
+            }
+
+            valid = field && (words.size() == 3)
+                    && parseWord(words.at(1), field->arguments,
+                                 field->argumentMin, field->argumentMax,
+                                 edit.argument)
+                    && parseWord(words.last(), SWITCHES, 0, 1, edit.value);
+
+            if (valid) {
+                edit.edit = field->edit;
+
+                if (field->arguments == ITEMS) {
+                    edit.property = getItemProperty(
+                        static_cast<enum sf_item>(edit.argument));
+                }
+            }
+        }
+
+        if (!valid) {
+            throw InvalidEditScriptException(IESE_SYNTAX, number + 1);
+        }
+
+        edits.append(edit);
+    }
+}
+
+void EditScript::apply(SRAMFile &sram) const {
+    const int current = sram.getGame();
+
+    for (int game = 0; game < 3; ++game) {
+        if (!sram.isValid(game)) {
+            continue;
+        }
+
+        sram.setGame(game);
+
+        for (const Edit &edit : edits) {
+            switch (edit.edit) {
+                case EDIT_PROPERTY:
+                    sram.setProperty(edit.property, edit.value);
+                    break;
+                case EDIT_COMPASS:
+                    sram.setCompass(edit.argument, edit.value);
+                    break;
+                case EDIT_MAP:
+                    sram.setMap(edit.argument, edit.value);
+                    break;
+                case EDIT_TRIFORCE:
+                    sram.setTriforce(edit.argument, edit.value);
+                    break;
+                case EDIT_NAME:
+                    sram.setName(edit.name);
+                    break;
+            }
+        }
+    }
+
+    sram.setGame(current);
+}
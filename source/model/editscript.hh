@@ -0,0 +1,131 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_EDITSCRIPT_HH_
+#define LOZSRAME_EDITSCRIPT_HH_
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "exceptions/invalideditscriptexception.hh"
+#include "model/sramfile.hh"
+
+namespace lozsrame {
+    /// the kinds of edits in an edit script
+    enum es_edit {
+        EDIT_PROPERTY,
+        EDIT_COMPASS,
+        EDIT_MAP,
+        EDIT_TRIFORCE,
+        EDIT_NAME
+    };
+
+    /**
+     * A list of edits to make to every valid game of an SRAM file.
+     *
+     * Scripts are plain text with one edit per line, naming the field and
+     * its new value. Blank lines and anything after a # are ignored.
+     *
+     *     hearts 16
+     *     sword master
+     *     item magickey on
+     *     map 9 on
+     *     name Link
+     *
+     * The fields are the properties in SRAM_PROPERTIES, by the same names,
+     * and take a number within the property's bounds. Flags also take on
+     * or off, and the other properties with named values take the names,
+     * like wooden, white or master for the sword. compass, map and
+     * triforce followed by a level or piece number, and item followed by
+     * an item name, take on or off to change just that one. name takes
+     * the rest of the line, spaces included, as the hero's name: up to
+     * eight letters, digits, spaces or ,!'&."?_ characters.
+     */
+    class EditScript {
+      private:
+        /// a single edit
+        struct Edit {
+            enum es_edit     edit;
+            enum sf_property property;
+            int              argument, value;
+            QString          name;
+        };
+
+        QVector<Edit> edits;
+
+        /**
+         * Parses the text of a script, adding its edits.
+         *
+         * @param text The script.
+         *
+         * @throw InvalidEditScriptException if the script is invalid.
+         */
+        void parse(const QByteArray &text);
+
+        /**
+         * Creates an empty EditScript for fromText to fill in.
+         */
+        EditScript();
+
+      public:
+        /**
+         * Creates an EditScript from a script file.
+         *
+         * @param filename The script filename.
+         *
+         * @throw InvalidEditScriptException if the file can't be read or the
+         *        script is invalid.
+         */
+        EditScript(const QString &filename);
+
+        /**
+         * Creates an EditScript from the text of a script.
+         *
+         * @param text The script.
+         *
+         * @return The new EditScript.
+         *
+         * @throw InvalidEditScriptException if the script is invalid.
+         */
+        static EditScript fromText(const QByteArray &text);
+
+        /**
+         * Makes the edits to every valid game of an SRAM file.
+         *
+         * @param sram The SRAM file. Its current game is left unchanged.
+         */
+        void apply(SRAMFile &sram) const;
+
+        /**
+         * Gets the number of edits in the script.
+         *
+         * @return The number of edits.
+         */
+        int getEditCount() const;
+    };
+
+    inline int EditScript::getEditCount() const {
+        return edits.size();
+    }
+}  // namespace lozsrame
+
+#endif
@@ -0,0 +1,167 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
+
+#ifdef Q_OS_WIN
+    #include <io.h>
+    #include <windows.h>
+#else
+    #include <cstdio>
+
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "model/filesync.hh"
+
+using namespace lozsrame;
+
+auto lozsrame::replaceFile(const QString &source, const QString &target)
+    -> bool {
+#ifdef Q_OS_WIN
+    return MoveFileExW(reinterpret_cast<const wchar_t *>(source.utf16()),
+                       reinterpret_cast<const wchar_t *>(target.utf16()),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    // QFile::rename refuses to overwrite, but rename(2) replaces atomically
+    return (std::rename(QFile::encodeName(source).constData(),
+                        QFile::encodeName(target).constData())
+            == 0);
+#endif
+}
+
+auto lozsrame::resolveFile(const QString &filename) -> QString {
+    const QFileInfo info(filename);
+
+    if (info.isSymLink() && info.exists()) {
+        return info.canonicalFilePath();
+    }
+
+    return filename;
+}
+
+auto lozsrame::syncFile(QFileDevice &file) -> bool {
+    if (!file.flush()) {
+        return false;
+    }
+
+#ifdef Q_OS_WIN
+    return FlushFileBuffers(
+        reinterpret_cast<HANDLE>(_get_osfhandle(file.handle())));
+#else
+    #ifdef F_FULLFSYNC
+    // fsync on macOS doesn't flush the drive's own cache
+    if (fcntl(file.handle(), F_FULLFSYNC) == 0) {
+        return true;
+    }
+    #endif
+
+    return (fsync(file.handle()) == 0);
+#endif
+}
+
+auto lozsrame::syncDirectory(const QString &path) -> bool {
+#ifdef Q_OS_WIN
+    // NTFS journals renames itself, and MOVEFILE_WRITE_THROUGH waits on it
+    Q_UNUSED(path);
+
+    return true;
+#else
+    const int fd = open(QFile::encodeName(path).constData(), O_RDONLY);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    const bool synced = (fsync(fd) == 0);
+
+    close(fd);
+
+    return synced;
+#endif
+}
+
+auto lozsrame::syncFileSystem(const QString &path) -> bool {
+#ifdef Q_OS_LINUX
+    const int fd = open(QFile::encodeName(path).constData(), O_RDONLY);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    const bool synced = (syncfs(fd) == 0);
+
+    close(fd);
+
+    return synced;
+#else
+    Q_UNUSED(path);
+
+    return false;
+#endif
+}
+
+auto lozsrame::getFileSystem(const QString &path) -> quint64 {
+#ifdef Q_OS_LINUX
+    struct stat info;
+
+    if (stat(QFile::encodeName(path).constData(), &info) != 0) {
+        return 0;
+    }
+
+    return static_cast<quint64>(info.st_dev);
+#else
+    Q_UNUSED(path);
+
+    return 0;
+#endif
+}
+
+auto lozsrame::writeTemporary(const QString &target, const QByteArray &data,
+                              bool sync) -> QString {
+    const QFileInfo info(target);
+    QTemporaryFile  file(info.absolutePath() + "/." + info.fileName()
+                         + ".XXXXXX");
+
+    file.setAutoRemove(false);
+
+    if (!file.open()) {
+        return QString();
+    }
+
+    if (info.exists()) {
+        file.setPermissions(info.permissions());
+    }
+
+    if ((file.write(data) != data.size()) || (sync && !syncFile(file))) {
+        file.remove();
+
+        return QString();
+    }
+
+    file.close();
+
+    return file.fileName();
+}
@@ -0,0 +1,112 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_FILESYNC_HH_
+#define LOZSRAME_FILESYNC_HH_
+
+#include <QByteArray>
+#include <QString>
+
+class QFileDevice;
+
+namespace lozsrame {
+    /**
+     * Replaces a file with another in one step, so a crash leaves either
+     * the old file or the new one, never a mix.
+     *
+     * @param source The file to move.
+     * @param target The file to replace.
+     *
+     * @return true if the file was replaced; false otherwise.
+     */
+    bool replaceFile(const QString &source, const QString &target);
+
+    /**
+     * Follows symbolic links to the file that saving to a path should
+     * replace, so the link itself isn't replaced by a regular file.
+     *
+     * @param filename The path.
+     *
+     * @return The file to replace, which is the path itself if it isn't a
+     *         link or doesn't exist yet.
+     */
+    QString resolveFile(const QString &filename);
+
+    /**
+     * Waits until an open file's data is on disk.
+     *
+     * @param file The file.
+     *
+     * @return true if the data was flushed; false otherwise.
+     */
+    bool syncFile(QFileDevice &file);
+
+    /**
+     * Waits until the file names in a directory, including any files just
+     * created or renamed, are on disk.
+     *
+     * @param path The directory.
+     *
+     * @return true if the directory was flushed; false otherwise.
+     */
+    bool syncDirectory(const QString &path);
+
+    /**
+     * Waits until everything written to the file system holding a path is
+     * on disk, with one call no matter how many files were written. This is
+     * only supported on Linux.
+     *
+     * @param path A file or directory on the file system.
+     *
+     * @return true if the file system was flushed; false if it failed or
+     *         isn't supported, in which case each file must be synced.
+     */
+    bool syncFileSystem(const QString &path);
+
+    /**
+     * Gets the device a path is on, so paths that share a file system can
+     * be flushed with a single syncFileSystem() call. This is only
+     * supported on Linux.
+     *
+     * @param path A file or directory on the file system.
+     *
+     * @return The device's ID, or 0 if it couldn't be found or this isn't
+     *         supported.
+     */
+    quint64 getFileSystem(const QString &path);
+
+    /**
+     * Writes data to a new temporary file in the same directory as a target
+     * file, ready to replace it with replaceFile(). The temporary file gets
+     * the target's permissions if the target exists.
+     *
+     * @param target The file that will be replaced.
+     * @param data The data to write.
+     * @param sync true to wait until the data is on disk.
+     *
+     * @return The temporary filename, or an empty string if it couldn't be
+     *         written.
+     */
+    QString writeTemporary(const QString &target, const QByteArray &data,
+                           bool sync);
+}  // namespace lozsrame
+
+#endif
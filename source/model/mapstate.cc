@@ -0,0 +1,120 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <QtCore/qendian.h>
+
+#include "model/checksum.hh"
+#include "model/mapstate.hh"
+#include "model/simd.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /**
+     * Splits the flags of one map into bit planes, 8 rooms at a time.
+     * Masking one flag out of 8 room bytes leaves a bit at the bottom of
+     * each byte, and the multiply gathers those 8 bits into the top byte.
+     *
+     * @param map The MAP_ROOMS bytes of room flags.
+     * @param planes Set to the RoomSet for each flag bit.
+     */
+    void scalarDecode(const unsigned char *map, RoomSet *planes) {
+        const quint64 lows   = Q_UINT64_C(0x0101010101010101);
+        const quint64 gather = Q_UINT64_C(0x0102040810204080);
+
+        for (int half = 0; half < 2; ++half) {
+            quint64 bits[8] = {};
+
+            for (int room = 0; room < 64; room += 8) {
+                const auto value =
+                    qFromLittleEndian<quint64>(map + (half * 64) + room);
+
+                for (int flag = 0; flag < 8; ++flag) {
+                    bits[flag] |= ((((value >> flag) & lows) * gather) >> 56)
+                                  << room;
+                }
+            }
+
+            for (int flag = 0; flag < 8; ++flag) {
+                planes[flag].bits[half] = bits[flag];
+            }
+        }
+    }
+
+#ifdef LOZSRAME_SIMD
+    /**
+     * Splits the flags of one map into bit planes, 64 rooms at a time.
+     * PMOVMSKB gathers the top bit of each byte, and adding the bytes to
+     * themselves shifts the next flag up, so each plane of 64 rooms is
+     * four instructions plus the shifts to join them.
+     */
+    LOZSRAME_TARGET("sse2")
+    void sse2Decode(const unsigned char *map, RoomSet *planes) {
+        const auto *rooms = reinterpret_cast<const __m128i *>(map);
+
+        for (int half = 0; half < 2; ++half) {
+            __m128i a = _mm_loadu_si128(rooms + (half * 4));
+            __m128i b = _mm_loadu_si128(rooms + (half * 4) + 1);
+            __m128i c = _mm_loadu_si128(rooms + (half * 4) + 2);
+            __m128i d = _mm_loadu_si128(rooms + (half * 4) + 3);
+
+            for (int flag = 7; flag >= 0; --flag) {
+                planes[flag].bits[half] =
+                    static_cast<quint64>(_mm_movemask_epi8(a))
+                    | (static_cast<quint64>(_mm_movemask_epi8(b)) << 16)
+                    | (static_cast<quint64>(_mm_movemask_epi8(c)) << 32)
+                    | (static_cast<quint64>(_mm_movemask_epi8(d)) << 48);
+
+                a = _mm_add_epi8(a, a);
+                b = _mm_add_epi8(b, b);
+                c = _mm_add_epi8(c, c);
+                d = _mm_add_epi8(d, d);
+            }
+        }
+    }
+#endif
+}  // namespace
+
+MapState::MapState(const char *sram, int game)
+    : triforce(readProperty<PROPERTY_TRIFORCE>(sram, game)) {
+    Q_ASSERT((game >= 0) && (game < 3));
+
+    const auto *data = reinterpret_cast<const unsigned char *>(sram)
+                       + MAP_DATA + (game * MAP_DATA_SIZE);
+
+    switch (getChecksumKernel()) {
+#ifdef LOZSRAME_SIMD
+        case KERNEL_AVX2:
+        case KERNEL_SSE2:
+            for (int map = 0; map < 3; ++map) {
+                sse2Decode(data + (map * MAP_ROOMS), flags[map]);
+            }
+
+            break;
+#endif
+        default:
+            for (int map = 0; map < 3; ++map) {
+                scalarDecode(data + (map * MAP_ROOMS), flags[map]);
+            }
+
+            break;
+    }
+}
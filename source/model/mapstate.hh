@@ -0,0 +1,183 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_MAPSTATE_HH_
+#define LOZSRAME_MAPSTATE_HH_
+
+#include <QtGlobal>
+
+#include "model/sramfile.hh"
+
+namespace lozsrame {
+    /// the number of screens on the overworld, and of rooms on each
+    /// dungeon map
+    const int MAP_ROOMS = 0x80;
+
+    /// the room flag bit for the doors Link has opened, one per side
+    const int ROOMFLAG_DOORS = 0;
+
+    /// the room flag bit set once a room's item has been taken
+    const int ROOMFLAG_ITEMTAKEN = 4;
+
+    /// the room flag bit set once Link has been in a room
+    const int ROOMFLAG_VISITED = 5;
+
+    /// the room flag bit set once a room's enemies have been defeated
+    const int ROOMFLAG_CLEARED = 6;
+
+    /// the maps in a game's map data, each MAP_ROOMS bytes of room flags
+    enum ms_map { MAP_OVERWORLD, MAP_LEVELS1TO6, MAP_LEVELS7TO9 };
+
+    /**
+     * A set of screens or rooms on one map, one bit per room.
+     */
+    struct RoomSet {
+        quint64 bits[2];
+
+        /**
+         * Checks if a room is in the set.
+         *
+         * @param room The room (0-127).
+         *
+         * @return true if it is; false otherwise.
+         */
+        bool contains(int room) const;
+
+        /**
+         * Counts the rooms in the set.
+         *
+         * @return The number of rooms.
+         */
+        int count() const;
+    };
+
+    /**
+     * The map data of a game decoded into one RoomSet per flag bit per
+     * map. Each of the 0x180 bytes of map data holds the flags of one
+     * screen or room, so the sets are the bit planes of those bytes.
+     * Decoding takes one pass over the map data, after which every metric
+     * is a handful of popcounts.
+     */
+    class MapState {
+      private:
+        RoomSet flags[3][8];
+        int     triforce;
+
+      public:
+        /**
+         * Decodes the map data of a game.
+         *
+         * @param sram The SRAM data.
+         * @param game The game. It must be valid.
+         */
+        MapState(const char *sram, int game);
+
+        /**
+         * Gets the rooms on a map with a flag set.
+         *
+         * @param map The map.
+         * @param flag The flag bit (0-7).
+         *
+         * @return The rooms.
+         */
+        const RoomSet &getRooms(enum ms_map map, int flag) const;
+
+        /**
+         * Gets the number of overworld screens Link has been to.
+         *
+         * @return The number of screens.
+         */
+        int getScreensVisited() const;
+
+        /**
+         * Gets the share of the overworld Link has been to.
+         *
+         * @return The percentage.
+         */
+        double getOverworldExplored() const;
+
+        /**
+         * Gets the number of dungeon rooms Link has been in, on both
+         * dungeon maps.
+         *
+         * @return The number of rooms.
+         */
+        int getRoomsVisited() const;
+
+        /**
+         * Gets the number of dungeon rooms whose enemies have been
+         * defeated, on both dungeon maps.
+         *
+         * @return The number of rooms.
+         */
+        int getRoomsCleared() const;
+
+        /**
+         * Gets the number of dungeon bosses defeated. Each of the first
+         * eight levels gives up its piece of the triforce once its boss
+         * falls, so this is the number of pieces held.
+         *
+         * @return The number of bosses.
+         */
+        int getBossesDefeated() const;
+    };
+
+    inline bool RoomSet::contains(int room) const {
+        Q_ASSERT((room >= 0) && (room < MAP_ROOMS));
+
+        return ((bits[room >> 6] >> (room & 63)) & 1);
+    }
+
+    inline int RoomSet::count() const {
+        return (qPopulationCount(bits[0]) + qPopulationCount(bits[1]));
+    }
+
+    inline const RoomSet &MapState::getRooms(enum ms_map map,
+                                             int flag) const {
+        Q_ASSERT((flag >= 0) && (flag < 8));
+
+        return flags[map][flag];
+    }
+
+    inline int MapState::getScreensVisited() const {
+        return flags[MAP_OVERWORLD][ROOMFLAG_VISITED].count();
+    }
+
+    inline double MapState::getOverworldExplored() const {
+        return ((getScreensVisited() * 100.0) / MAP_ROOMS);
+    }
+
+    inline int MapState::getRoomsVisited() const {
+        return (flags[MAP_LEVELS1TO6][ROOMFLAG_VISITED].count()
+                + flags[MAP_LEVELS7TO9][ROOMFLAG_VISITED].count());
+    }
+
+    inline int MapState::getRoomsCleared() const {
+        return (flags[MAP_LEVELS1TO6][ROOMFLAG_CLEARED].count()
+                + flags[MAP_LEVELS7TO9][ROOMFLAG_CLEARED].count());
+    }
+
+    inline int MapState::getBossesDefeated() const {
+        return qPopulationCount(static_cast<quint8>(triforce));
+    }
+}  // namespace lozsrame
+
+#endif
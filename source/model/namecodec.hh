@@ -0,0 +1,114 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_NAMECODEC_HH_
+#define LOZSRAME_NAMECODEC_HH_
+
+namespace lozsrame {
+    /// the game's encoding of a space, also used for unknown characters
+    const unsigned char NAME_SPACE = 0x24;
+
+    /**
+     * Lookup tables translating between the game's name encoding and Latin-1.
+     */
+    struct NameTables {
+        /// name byte to character
+        char decode[256];
+
+        /// 7-bit character to name byte
+        unsigned char encode[128];
+    };
+
+    /**
+     * Builds the name tables at compile time.
+     *
+     * Bytes 0x0 - 0x9 are the digits, 0xA - 0x23 the letters A - Z, 0x24 a
+     * space and 0x28 - 0x2F the punctuation ,!'&."?_. Everything else
+     * decodes to a space, and characters outside the alphabet encode to one.
+     *
+     * @return The tables.
+     */
+    constexpr NameTables makeNameTables() {
+        NameTables tables{};
+
+        const char punctuation[] = ",!'&.\"?_";
+
+        for (int i = 0; i < 256; ++i) {
+            tables.decode[i] = ' ';
+        }
+
+        for (int i = 0; i < 128; ++i) {
+            tables.encode[i] = NAME_SPACE;
+        }
+
+        for (int i = 0; i < 10; ++i) {
+            tables.decode[i]       = static_cast<char>('0' + i);
+            tables.encode['0' + i] = static_cast<unsigned char>(i);
+        }
+
+        for (int i = 0; i < 26; ++i) {
+            tables.decode[0xA + i] = static_cast<char>('A' + i);
+            tables.encode['A' + i] = static_cast<unsigned char>(0xA + i);
+        }
+
+        for (int i = 0; i < 8; ++i) {
+            tables.decode[0x28 + i] = punctuation[i];
+            tables.encode[static_cast<unsigned char>(punctuation[i])] =
+                static_cast<unsigned char>(0x28 + i);
+        }
+
+        return tables;
+    }
+
+    /// the name tables
+    constexpr NameTables NAME_TABLES = makeNameTables();
+
+    /**
+     * Decodes a name from the game's encoding. No terminator is written.
+     *
+     * @param raw The encoded name bytes.
+     * @param length The number of bytes.
+     * @param text Where to store the decoded characters.
+     */
+    inline void decodeName(const char *raw, int length, char *text) {
+        for (int i = 0; i < length; ++i) {
+            text[i] = NAME_TABLES.decode[static_cast<unsigned char>(raw[i])];
+        }
+    }
+
+    /**
+     * Encodes a Latin-1 name in the game's encoding.
+     *
+     * @param text The characters.
+     * @param length The number of characters.
+     * @param raw Where to store the encoded name bytes.
+     */
+    inline void encodeName(const char *text, int length, char *raw) {
+        for (int i = 0; i < length; ++i) {
+            const auto ch = static_cast<unsigned char>(text[i]);
+
+            raw[i] = static_cast<char>((ch < 0x80) ? NAME_TABLES.encode[ch]
+                                                   : NAME_SPACE);
+        }
+    }
+}  // namespace lozsrame
+
+#endif
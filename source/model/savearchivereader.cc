@@ -0,0 +1,640 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cstring>
+
+#include <QFile>
+#include <QIODevice>
+#include <QtCore/qendian.h>
+
+#include <zlib.h>
+
+#include "model/savearchivereader.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /// size of the buffers used to copy and inflate entries
+    const int CHUNK_SIZE = 0x4000;
+
+    /// largest tar long name or pax header we will read
+    const qint64 MAX_METADATA_SIZE = 0x10000;
+
+    /// size of a tar header and of the blocks entries are padded to
+    const int TAR_BLOCK_SIZE = 512;
+
+    /// zip central directory header signature
+    const quint32 ZIP_CENTRAL = 0x02014B50;
+
+    /// zip data descriptor signature
+    const quint32 ZIP_DESCRIPTOR = 0x08074B50;
+
+    /// zip end of central directory signature
+    const quint32 ZIP_END = 0x06054B50;
+
+    /// zip local file header signature
+    const quint32 ZIP_LOCAL = 0x04034B50;
+
+    /// size of a zip local file header
+    const int ZIP_LOCAL_SIZE = 30;
+
+    /// zip general purpose flags
+    enum zip_flag {
+        ZIPFLAG_ENCRYPTED  = 0x1,
+        ZIPFLAG_DESCRIPTOR = 0x8,
+        ZIPFLAG_UTF8       = 0x800
+    };
+
+    /// zip compression methods
+    enum zip_method { ZIPMETHOD_STORED = 0, ZIPMETHOD_DEFLATED = 8 };
+
+    /**
+     * Gets a string field of a tar header, which may fill the field without
+     * a terminating NUL.
+     *
+     * @param field The field.
+     * @param length The length of the field.
+     *
+     * @return The string.
+     */
+    auto tarString(const char *field, int length) -> QByteArray {
+        const void *end = std::memchr(field, '\0', length);
+
+        if (end) {
+            length = static_cast<const char *>(end) - field;
+        }
+
+        return QByteArray(field, length);
+    }
+
+    /**
+     * Parses a numeric field of a tar header. These are octal, or base-256
+     * in GNU archives when the value doesn't fit.
+     *
+     * @param field The field.
+     * @param length The length of the field.
+     *
+     * @return The value, or -1 if the field is invalid.
+     */
+    auto tarNumber(const char *field, int length) -> qint64 {
+        const unsigned char *bytes =
+            reinterpret_cast<const unsigned char *>(field);
+        const qint64 limit = Q_INT64_C(0x7FFFFFFFFFFFFFFF);
+        qint64       value = 0;
+        int          i     = 0;
+
+        if (bytes[0] & 0x80) {
+            if (bytes[0] & 0x40) {
+                return -1;
+            }
+
+            value = bytes[0] & 0x3F;
+
+            for (i = 1; i < length; ++i) {
+                if (value > (limit >> 8)) {
+                    return -1;
+                }
+
+                value = (value << 8) | bytes[i];
+            }
+
+            return value;
+        }
+
+        while ((i < length) && (bytes[i] == ' ')) {
+            ++i;
+        }
+
+        for (; (i < length) && (bytes[i] >= '0') && (bytes[i] <= '7'); ++i) {
+            if (value > (limit >> 3)) {
+                return -1;
+            }
+
+            value = (value << 3) | (bytes[i] - '0');
+        }
+
+        for (; i < length; ++i) {
+            if ((bytes[i] != ' ') && (bytes[i] != '\0')) {
+                return -1;
+            }
+        }
+
+        return value;
+    }
+
+    /**
+     * Checks if a block is a tar header by verifying its checksum.
+     *
+     * @param block The block.
+     *
+     * @return true if it is a tar header; false otherwise.
+     */
+    auto isTarHeader(const char *block) -> bool {
+        const qint64 stored    = tarNumber(block + 148, 8);
+        qint64       sum       = 0;
+        qint64       signedSum = 0;
+
+        for (int i = 0; i < TAR_BLOCK_SIZE; ++i) {
+            // the checksum field itself counts as spaces
+            const char byte = ((i >= 148) && (i < 156)) ? ' ' : block[i];
+
+            sum += static_cast<unsigned char>(byte);
+            signedSum += static_cast<signed char>(byte);
+        }
+
+        // some old tar programs summed signed bytes
+        return (stored >= 0) && ((stored == sum) || (stored == signedSum));
+    }
+
+    /**
+     * Gets the padding after a tar entry that fills out its last block.
+     *
+     * @param size The size of the entry.
+     *
+     * @return The size of the padding.
+     */
+    auto tarPadding(qint64 size) -> qint64 {
+        return (TAR_BLOCK_SIZE - (size % TAR_BLOCK_SIZE)) % TAR_BLOCK_SIZE;
+    }
+
+    /**
+     * Checks if a block is all zeros, which marks the end of a tar archive.
+     *
+     * @param block The block.
+     *
+     * @return true if it is all zeros; false otherwise.
+     */
+    auto isZeroBlock(const char *block) -> bool {
+        for (int i = 0; i < TAR_BLOCK_SIZE; ++i) {
+            if (block[i] != '\0') {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Reads the path and size records of a pax extended header.
+     *
+     * @param records The extended header.
+     * @param path Set to the path, if the header has one.
+     * @param size Set to the size, if the header has one.
+     *
+     * @return true if the header is valid; false otherwise.
+     */
+    auto parsePax(const QByteArray &records, QString &path, qint64 &size)
+        -> bool {
+        int pos = 0;
+
+        // each record is "<length> <key>=<value>\n"
+        while (pos < records.size()) {
+            const int space = records.indexOf(' ', pos);
+
+            if (space < 0) {
+                return false;
+            }
+
+            bool      ok;
+            const int length = records.mid(pos, space - pos).toInt(&ok);
+
+            if (!ok || (length <= (space - pos))
+                || (pos + length > records.size())
+                || (records.at(pos + length - 1) != '\n')) {
+                return false;
+            }
+
+            const QByteArray record =
+                records.mid(space + 1, pos + length - space - 2);
+            const int equals = record.indexOf('=');
+
+            if (equals < 0) {
+                return false;
+            }
+
+            const QByteArray key   = record.left(equals);
+            const QByteArray value = record.mid(equals + 1);
+
+            if (key == "path") {
+                path = QString::fromUtf8(value);
+            } else if (key == "size") {
+                size = value.toLongLong(&ok);
+
+                if (!ok || (size < 0)) {
+                    return false;
+                }
+            }
+
+            pos += length;
+        }
+
+        return true;
+    }
+}  // namespace
+
+SaveArchiveReader::SaveArchiveReader(QIODevice *device)
+    : device(device), size(0), crc(0), format(FORMAT_UNKNOWN),
+      finished(false) {}
+
+auto SaveArchiveReader::readFully(char *buffer, qint64 count) -> qint64 {
+    qint64 total = 0;
+
+    while (total < count) {
+        const qint64 got = device->read(buffer + total, count - total);
+
+        if (got < 0) {
+            throw InvalidArchiveException(IAE_READERROR);
+        } else if (got == 0) {
+            // sockets and pipes may not have the rest yet
+            if (!device->waitForReadyRead(-1)) {
+                break;
+            }
+        }
+
+        total += got;
+    }
+
+    return total;
+}
+
+void SaveArchiveReader::consume(qint64 count) {
+    char buffer[CHUNK_SIZE];
+
+    while (count > 0) {
+        const qint64 chunk = qMin<qint64>(count, CHUNK_SIZE);
+
+        if (readFully(buffer, chunk) != chunk) {
+            throw InvalidArchiveException(IAE_CORRUPT);
+        }
+
+        append(buffer, chunk);
+        count -= chunk;
+    }
+}
+
+void SaveArchiveReader::skip(qint64 count) {
+    char buffer[CHUNK_SIZE];
+
+    while (count > 0) {
+        const qint64 chunk = qMin<qint64>(count, CHUNK_SIZE);
+
+        if (readFully(buffer, chunk) != chunk) {
+            throw InvalidArchiveException(IAE_CORRUPT);
+        }
+
+        count -= chunk;
+    }
+}
+
+void SaveArchiveReader::append(const char *buffer, qint64 count) {
+    const qint64 room = SRAM_SIZE - data.size();
+
+    if (room > 0) {
+        data.append(buffer, qMin(room, count));
+    }
+
+    crc = crc32(crc, reinterpret_cast<const Bytef *>(buffer),
+                static_cast<uInt>(count));
+    size += count;
+}
+
+void SaveArchiveReader::detect() {
+    char   block[TAR_BLOCK_SIZE];
+    qint64 got = device->peek(block, TAR_BLOCK_SIZE);
+
+    while ((got >= 0) && (got < TAR_BLOCK_SIZE)
+           && device->waitForReadyRead(-1)) {
+        got = device->peek(block, TAR_BLOCK_SIZE);
+    }
+
+    if (got < 0) {
+        throw InvalidArchiveException(IAE_READERROR);
+    }
+
+    if (got >= 4) {
+        const quint32 signature = qFromLittleEndian<quint32>(block);
+
+        if ((signature == ZIP_LOCAL) || (signature == ZIP_END)) {
+            format = FORMAT_ZIP;
+            return;
+        }
+    }
+
+    if ((got == TAR_BLOCK_SIZE)
+        && (isZeroBlock(block) || isTarHeader(block))) {
+        format = FORMAT_TAR;
+        return;
+    }
+
+    throw InvalidArchiveException(IAE_UNKNOWNFORMAT);
+}
+
+auto SaveArchiveReader::next() -> bool {
+    if (finished) {
+        return false;
+    }
+
+    if (format == FORMAT_UNKNOWN) {
+        detect();
+    }
+
+    return (format == FORMAT_ZIP) ? nextZip() : nextTar();
+}
+
+auto SaveArchiveReader::readTarMetadata(qint64 count) -> QByteArray {
+    if (count > MAX_METADATA_SIZE) {
+        throw InvalidArchiveException(IAE_UNSUPPORTED);
+    }
+
+    QByteArray metadata(static_cast<int>(count), '\0');
+
+    if (readFully(metadata.data(), count) != count) {
+        throw InvalidArchiveException(IAE_CORRUPT);
+    }
+
+    skip(tarPadding(count));
+
+    return metadata;
+}
+
+auto SaveArchiveReader::nextTar() -> bool {
+    QString longName;
+    qint64  longSize = -1;
+
+    for (;;) {
+        char         header[TAR_BLOCK_SIZE];
+        const qint64 got = readFully(header, TAR_BLOCK_SIZE);
+
+        // some tar programs leave off the two zero blocks at the end
+        if ((got == 0) || ((got == TAR_BLOCK_SIZE) && isZeroBlock(header))) {
+            finished = true;
+            return false;
+        }
+
+        if ((got != TAR_BLOCK_SIZE) || !isTarHeader(header)) {
+            throw InvalidArchiveException(IAE_CORRUPT);
+        }
+
+        qint64 entrySize = tarNumber(header + 124, 12);
+
+        if (entrySize < 0) {
+            throw InvalidArchiveException(IAE_CORRUPT);
+        }
+
+        switch (header[156]) {
+            case 'L':
+                // GNU long name for the next entry
+                longName = QFile::decodeName(
+                    readTarMetadata(entrySize).constData());
+                continue;
+            case 'x':
+                // pax extended header for the next entry
+                if (!parsePax(readTarMetadata(entrySize), longName,
+                              longSize)) {
+                    throw InvalidArchiveException(IAE_CORRUPT);
+                }
+
+                continue;
+            case '0':
+            case '7':
+            case '\0':
+                break;
+            default:
+                // directories, links, devices, and global headers
+                skip(entrySize + tarPadding(entrySize));
+                longName.clear();
+                longSize = -1;
+                continue;
+        }
+
+        if (longSize >= 0) {
+            entrySize = longSize;
+        }
+
+        if (!longName.isEmpty()) {
+            name = longName;
+        } else if (std::memcmp(header + 257, "ustar", 5) == 0) {
+            QByteArray path   = tarString(header, 100);
+            QByteArray prefix = tarString(header + 345, 155);
+
+            if (!prefix.isEmpty()) {
+                path = prefix + '/' + path;
+            }
+
+            name = QFile::decodeName(path);
+        } else {
+            name = QFile::decodeName(tarString(header, 100));
+        }
+
+        data.clear();
+        size = 0;
+        crc  = 0;
+
+        consume(entrySize);
+        skip(tarPadding(entrySize));
+
+        // old tar programs mark directories with a trailing slash
+        if (name.endsWith('/')) {
+            longName.clear();
+            longSize = -1;
+            continue;
+        }
+
+        return true;
+    }
+}
+
+auto SaveArchiveReader::nextZip() -> bool {
+    for (;;) {
+        char         header[ZIP_LOCAL_SIZE];
+        const qint64 got = readFully(header, 4);
+
+        if (got == 0) {
+            finished = true;
+            return false;
+        }
+
+        if (got != 4) {
+            throw InvalidArchiveException(IAE_CORRUPT);
+        }
+
+        const quint32 signature = qFromLittleEndian<quint32>(header);
+
+        // the local entries are followed by the central directory
+        if ((signature == ZIP_CENTRAL) || (signature == ZIP_END)) {
+            finished = true;
+            return false;
+        }
+
+        if ((signature != ZIP_LOCAL)
+            || (readFully(header + 4, ZIP_LOCAL_SIZE - 4)
+                != ZIP_LOCAL_SIZE - 4)) {
+            throw InvalidArchiveException(IAE_CORRUPT);
+        }
+
+        const int  flags        = qFromLittleEndian<quint16>(header + 6);
+        const int  method       = qFromLittleEndian<quint16>(header + 8);
+        quint32    expectedCrc  = qFromLittleEndian<quint32>(header + 14);
+        quint32    compressed   = qFromLittleEndian<quint32>(header + 18);
+        quint32    uncompressed = qFromLittleEndian<quint32>(header + 22);
+        const int  nameLength   = qFromLittleEndian<quint16>(header + 26);
+        const int  extraLength  = qFromLittleEndian<quint16>(header + 28);
+        const bool descriptor   = (flags & ZIPFLAG_DESCRIPTOR);
+        QByteArray rawName(nameLength, '\0');
+
+        if ((flags & ZIPFLAG_ENCRYPTED) || (compressed == 0xFFFFFFFF)
+            || (uncompressed == 0xFFFFFFFF)) {
+            throw InvalidArchiveException(IAE_UNSUPPORTED);
+        }
+
+        if (readFully(rawName.data(), nameLength) != nameLength) {
+            throw InvalidArchiveException(IAE_CORRUPT);
+        }
+
+        skip(extraLength);
+
+        if (flags & ZIPFLAG_UTF8) {
+            name = QString::fromUtf8(rawName);
+        } else {
+            name = QFile::decodeName(rawName);
+        }
+
+        data.clear();
+        size = 0;
+        crc  = 0;
+
+        if ((method == ZIPMETHOD_STORED) && !descriptor) {
+            consume(compressed);
+        } else if (method == ZIPMETHOD_DEFLATED) {
+            inflateEntry(descriptor ? -1 : static_cast<qint64>(compressed));
+        } else {
+            // a stored entry with a data descriptor has no way to find its
+            // end without the central directory
+            throw InvalidArchiveException(IAE_UNSUPPORTED);
+        }
+
+        if (descriptor) {
+            char trailer[16];
+
+            if (readFully(trailer, 12) != 12) {
+                throw InvalidArchiveException(IAE_CORRUPT);
+            }
+
+            // the descriptor signature is optional
+            const char *fields = trailer;
+
+            if (qFromLittleEndian<quint32>(trailer) == ZIP_DESCRIPTOR) {
+                if (readFully(trailer + 12, 4) != 4) {
+                    throw InvalidArchiveException(IAE_CORRUPT);
+                }
+
+                fields += 4;
+            }
+
+            expectedCrc  = qFromLittleEndian<quint32>(fields);
+            uncompressed = qFromLittleEndian<quint32>(fields + 8);
+        }
+
+        if ((crc != expectedCrc) || (size != uncompressed)) {
+            throw InvalidArchiveException(IAE_CORRUPT);
+        }
+
+        if (name.endsWith('/')) {
+            continue;
+        }
+
+        return true;
+    }
+}
+
+void SaveArchiveReader::inflateEntry(qint64 compressed) {
+    z_stream stream;
+
+    std::memset(&stream, 0, sizeof(stream));
+
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+        throw InvalidArchiveException(IAE_READERROR);
+    }
+
+    char input[CHUNK_SIZE], output[CHUNK_SIZE];
+    int  status = Z_OK;
+
+    while (status != Z_STREAM_END) {
+        qint64 want = CHUNK_SIZE;
+
+        if (compressed >= 0) {
+            want = qMin(want, compressed);
+        }
+
+        // peek rather than read so the bytes after the end of the deflate
+        // stream stay in the device for the next header
+        const qint64 got = (want > 0) ? device->peek(input, want) : 0;
+
+        if ((got == 0) && (want > 0) && device->waitForReadyRead(-1)) {
+            continue;
+        }
+
+        if (got <= 0) {
+            inflateEnd(&stream);
+            throw InvalidArchiveException((got < 0) ? IAE_READERROR
+                                                    : IAE_CORRUPT);
+        }
+
+        stream.next_in  = reinterpret_cast<Bytef *>(input);
+        stream.avail_in = static_cast<uInt>(got);
+
+        do {
+            stream.next_out  = reinterpret_cast<Bytef *>(output);
+            stream.avail_out = CHUNK_SIZE;
+            status           = inflate(&stream, Z_NO_FLUSH);
+
+            if ((status != Z_OK) && (status != Z_STREAM_END)
+                && (status != Z_BUF_ERROR)) {
+                inflateEnd(&stream);
+                throw InvalidArchiveException(IAE_CORRUPT);
+            }
+
+            append(output, CHUNK_SIZE - stream.avail_out);
+        } while ((status == Z_OK) && (stream.avail_out == 0));
+
+        const qint64 used = got - stream.avail_in;
+
+        if ((used == 0) && (status != Z_STREAM_END)) {
+            inflateEnd(&stream);
+            throw InvalidArchiveException(IAE_CORRUPT);
+        }
+
+        if (readFully(input, used) != used) {
+            inflateEnd(&stream);
+            throw InvalidArchiveException(IAE_CORRUPT);
+        }
+
+        if (compressed >= 0) {
+            compressed -= used;
+        }
+    }
+
+    inflateEnd(&stream);
+
+    if (compressed > 0) {
+        throw InvalidArchiveException(IAE_CORRUPT);
+    }
+}
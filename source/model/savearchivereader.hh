@@ -0,0 +1,223 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_SAVEARCHIVEREADER_HH_
+#define LOZSRAME_SAVEARCHIVEREADER_HH_
+
+#include <QByteArray>
+#include <QString>
+
+#include "exceptions/invalidarchiveexception.hh"
+#include "model/sramfile.hh"
+
+class QIODevice;
+
+namespace lozsrame {
+    /// the archive formats SaveArchiveReader understands
+    enum sar_format { FORMAT_UNKNOWN, FORMAT_TAR, FORMAT_ZIP };
+
+    /**
+     * Reads the SRAM files in a tar or zip archive one entry at a time,
+     * without extracting them to disk first.
+     *
+     * The archive is read strictly front to back and never seeked, so the
+     * device may be a pipe or a socket as well as a file. Zip entries may be
+     * stored or deflated; tar archives may use the ustar, GNU, or pax
+     * extensions for long names.
+     */
+    class SaveArchiveReader {
+      private:
+        QIODevice      *device;
+        QByteArray      data;
+        QString         name;
+        qint64          size;
+        quint32         crc;
+        enum sar_format format;
+        bool            finished;
+
+        /**
+         * Reads from the device until a buffer is full or the device ends.
+         *
+         * @param buffer The buffer to read into.
+         * @param count The number of bytes to read.
+         *
+         * @return The number of bytes read.
+         *
+         * @throw InvalidArchiveException if the device can't be read.
+         */
+        qint64 readFully(char *buffer, qint64 count);
+
+        /**
+         * Reads part of an entry's contents.
+         *
+         * @param count The number of bytes to read.
+         *
+         * @throw InvalidArchiveException if the archive is truncated.
+         */
+        void consume(qint64 count);
+
+        /**
+         * Reads and discards part of the archive.
+         *
+         * @param count The number of bytes to skip.
+         *
+         * @throw InvalidArchiveException if the archive is truncated.
+         */
+        void skip(qint64 count);
+
+        /**
+         * Adds part of an entry's contents to its size and CRC-32, keeping
+         * as much of it as an SRAM file needs.
+         *
+         * @param buffer The contents.
+         * @param count The number of bytes in the buffer.
+         */
+        void append(const char *buffer, qint64 count);
+
+        /**
+         * Works out the archive format from its first block.
+         *
+         * @throw InvalidArchiveException if the format isn't recognized.
+         */
+        void detect();
+
+        /**
+         * Reads a whole tar metadata entry, such as a long name.
+         *
+         * @param count The size of the entry.
+         *
+         * @return The contents of the entry.
+         *
+         * @throw InvalidArchiveException if the entry is truncated or too
+         *        large.
+         */
+        QByteArray readTarMetadata(qint64 count);
+
+        /**
+         * Moves to the next entry of a tar archive.
+         *
+         * @return true if there was another entry; false otherwise.
+         *
+         * @throw InvalidArchiveException if the archive is invalid.
+         */
+        bool nextTar();
+
+        /**
+         * Moves to the next entry of a zip archive.
+         *
+         * @return true if there was another entry; false otherwise.
+         *
+         * @throw InvalidArchiveException if the archive is invalid.
+         */
+        bool nextZip();
+
+        /**
+         * Inflates a deflated zip entry.
+         *
+         * @param compressed The compressed size, or -1 if it isn't known
+         *                   until the end of the deflate stream.
+         *
+         * @throw InvalidArchiveException if the entry is corrupt.
+         */
+        void inflateEntry(qint64 compressed);
+
+      public:
+        /**
+         * Creates a new SaveArchiveReader.
+         *
+         * @param device The open device to read the archive from.
+         */
+        SaveArchiveReader(QIODevice *device);
+
+        /**
+         * Gets the archive format. This is FORMAT_UNKNOWN until next() has
+         * been called.
+         *
+         * @return The archive format.
+         */
+        enum sar_format getFormat() const;
+
+        /**
+         * Moves to the next file in the archive. Directories and other
+         * special entries are skipped.
+         *
+         * @return true if there was another file; false at the end of the
+         *         archive.
+         *
+         * @throw InvalidArchiveException if the archive is invalid.
+         */
+        bool next();
+
+        /**
+         * Gets the path of the current entry within the archive.
+         *
+         * @return The entry path.
+         */
+        QString getEntryName() const;
+
+        /**
+         * Gets the contents of the current entry. Only the first SRAM_SIZE
+         * bytes are kept, since a larger entry can't be an SRAM file.
+         *
+         * @return The entry contents.
+         */
+        QByteArray getEntryData() const;
+
+        /**
+         * Gets the full size of the current entry.
+         *
+         * @return The entry size.
+         */
+        qint64 getEntrySize() const;
+
+        /**
+         * Creates an SRAMFile object from the current entry.
+         *
+         * @return The new SRAMFile object.
+         *
+         * @throw InvalidSRAMFileException if the entry is not a valid SRAM
+         *        file.
+         */
+        SRAMFile getSRAMFile() const;
+    };
+
+    inline enum sar_format SaveArchiveReader::getFormat() const {
+        return format;
+    }
+
+    inline QString SaveArchiveReader::getEntryName() const {
+        return name;
+    }
+
+    inline QByteArray SaveArchiveReader::getEntryData() const {
+        return data;
+    }
+
+    inline qint64 SaveArchiveReader::getEntrySize() const {
+        return size;
+    }
+
+    inline SRAMFile SaveArchiveReader::getSRAMFile() const {
+        return SRAMFile::fromData(data.constData(), size);
+    }
+}  // namespace lozsrame
+
+#endif
@@ -0,0 +1,618 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cstring>
+#include <fstream>
+
+#include <QFile>
+#include <QtCore/qendian.h>
+
+#include "model/mapstate.hh"
+#include "model/savecorpus.hh"
+#include "model/simd.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /// columns start on multiples of this, for aligned SIMD loads
+    const int CORPUS_ALIGNMENT = 64;
+
+    /// size of each column directory entry
+    const int CORPUS_ENTRY_SIZE = 16;
+
+    /// size of the file header
+    const int CORPUS_HEADER_SIZE = 24;
+
+    /// the file magic
+    const char CORPUS_MAGIC[4] = {'L', 'Z', 'S', 'C'};
+
+    /**
+     * Rounds an offset up to the next column boundary.
+     *
+     * @param offset The offset.
+     *
+     * @return The aligned offset.
+     */
+    inline auto align(qint64 offset) -> qint64 {
+        return (offset + CORPUS_ALIGNMENT - 1) & ~qint64(CORPUS_ALIGNMENT - 1);
+    }
+
+    /**
+     * Counts the one byte values where (value & mask) == match.
+     *
+     * @param data The values.
+     * @param rows The number of values.
+     * @param mask The bits to compare.
+     * @param match The value to compare against.
+     *
+     * @return The number of matching values.
+     */
+    auto scalarCount8(const quint8 *data, qint64 rows, quint8 mask,
+                      quint8 match) -> qint64 {
+        qint64 count = 0;
+
+        for (qint64 i = 0; i < rows; ++i) {
+            count += ((data[i] & mask) == match);
+        }
+
+        return count;
+    }
+
+    /**
+     * Counts the two byte values where (value & mask) == match.
+     *
+     * @param data The values.
+     * @param rows The number of values.
+     * @param mask The bits to compare.
+     * @param match The value to compare against.
+     *
+     * @return The number of matching values.
+     */
+    auto scalarCount16(const quint16 *data, qint64 rows, quint16 mask,
+                       quint16 match) -> qint64 {
+        qint64 count = 0;
+
+        for (qint64 i = 0; i < rows; ++i) {
+            count += ((qFromLittleEndian(data[i]) & mask) == match);
+        }
+
+        return count;
+    }
+
+    /**
+     * Adds together one byte values.
+     *
+     * @param data The values.
+     * @param rows The number of values.
+     *
+     * @return The sum.
+     */
+    auto scalarSum8(const quint8 *data, qint64 rows) -> qint64 {
+        qint64 sum = 0;
+
+        for (qint64 i = 0; i < rows; ++i) {
+            sum += data[i];
+        }
+
+        return sum;
+    }
+
+#ifdef LOZSRAME_SIMD
+    /**
+     * Adds together the two 64-bit lanes of a sum.
+     *
+     * @param sum The lanes.
+     *
+     * @return The total.
+     */
+    LOZSRAME_TARGET("sse2")
+    inline auto total(__m128i sum) -> qint64 {
+        quint64 lanes[2];
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), sum);
+
+        return static_cast<qint64>(lanes[0] + lanes[1]);
+    }
+
+    /**
+     * The SSE2 one byte count. Each match subtracts -1 from a byte counter,
+     * and the counters are folded with PSADBW before they can overflow, so
+     * there is no per-vector popcount.
+     */
+    LOZSRAME_TARGET("sse2")
+    auto sse2Count8(const quint8 *data, qint64 rows, quint8 mask,
+                    quint8 match) -> qint64 {
+        const __m128i zero    = _mm_setzero_si128();
+        const __m128i masks   = _mm_set1_epi8(static_cast<char>(mask));
+        const __m128i matches = _mm_set1_epi8(static_cast<char>(match));
+        __m128i       sum     = zero;
+        qint64        i       = 0;
+
+        while (rows - i >= 16) {
+            const qint64 end = i + 16 * qMin<qint64>((rows - i) / 16, 255);
+            __m128i      counters = zero;
+
+            for (; i < end; i += 16) {
+                const __m128i values = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(data + i));
+
+                counters = _mm_sub_epi8(
+                    counters,
+                    _mm_cmpeq_epi8(_mm_and_si128(values, masks), matches));
+            }
+
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(counters, zero));
+        }
+
+        return total(sum) + scalarCount8(data + i, rows - i, mask, match);
+    }
+
+    /**
+     * The SSE2 two byte count. The 16-bit counters are folded with PMADDWD
+     * every 32767 vectors so they stay positive.
+     */
+    LOZSRAME_TARGET("sse2")
+    auto sse2Count16(const quint16 *data, qint64 rows, quint16 mask,
+                     quint16 match) -> qint64 {
+        const __m128i zero    = _mm_setzero_si128();
+        const __m128i ones    = _mm_set1_epi16(1);
+        const __m128i masks   = _mm_set1_epi16(static_cast<short>(mask));
+        const __m128i matches = _mm_set1_epi16(static_cast<short>(match));
+        __m128i       sum     = zero;
+        qint64        i       = 0;
+
+        while (rows - i >= 8) {
+            const qint64 end = i + 8 * qMin<qint64>((rows - i) / 8, 32767);
+            __m128i      counters = zero;
+
+            for (; i < end; i += 8) {
+                const __m128i values = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(data + i));
+
+                counters = _mm_sub_epi16(
+                    counters,
+                    _mm_cmpeq_epi16(_mm_and_si128(values, masks), matches));
+            }
+
+            const __m128i pairs = _mm_madd_epi16(counters, ones);
+
+            sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(pairs, zero));
+            sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(pairs, zero));
+        }
+
+        return total(sum) + scalarCount16(data + i, rows - i, mask, match);
+    }
+
+    /**
+     * The SSE2 one byte sum, using PSADBW against zero.
+     */
+    LOZSRAME_TARGET("sse2")
+    auto sse2Sum8(const quint8 *data, qint64 rows) -> qint64 {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i       sum  = zero;
+        qint64        i    = 0;
+
+        for (; rows - i >= 16; i += 16) {
+            const __m128i values =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(values, zero));
+        }
+
+        return total(sum) + scalarSum8(data + i, rows - i);
+    }
+
+    /**
+     * Adds together the four 64-bit lanes of a sum.
+     *
+     * @param sum The lanes.
+     *
+     * @return The total.
+     */
+    LOZSRAME_TARGET("avx2")
+    inline auto total(__m256i sum) -> qint64 {
+        return total(_mm_add_epi64(_mm256_castsi256_si128(sum),
+                                   _mm256_extracti128_si256(sum, 1)));
+    }
+
+    /**
+     * The AVX2 one byte count. Same as SSE2, but 32 bytes per load.
+     */
+    LOZSRAME_TARGET("avx2")
+    auto avx2Count8(const quint8 *data, qint64 rows, quint8 mask,
+                    quint8 match) -> qint64 {
+        const __m256i zero    = _mm256_setzero_si256();
+        const __m256i masks   = _mm256_set1_epi8(static_cast<char>(mask));
+        const __m256i matches = _mm256_set1_epi8(static_cast<char>(match));
+        __m256i       sum     = zero;
+        qint64        i       = 0;
+
+        while (rows - i >= 32) {
+            const qint64 end = i + 32 * qMin<qint64>((rows - i) / 32, 255);
+            __m256i      counters = zero;
+
+            for (; i < end; i += 32) {
+                const __m256i values = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(data + i));
+
+                counters = _mm256_sub_epi8(
+                    counters, _mm256_cmpeq_epi8(
+                                  _mm256_and_si256(values, masks), matches));
+            }
+
+            sum = _mm256_add_epi64(sum, _mm256_sad_epu8(counters, zero));
+        }
+
+        return total(sum) + scalarCount8(data + i, rows - i, mask, match);
+    }
+
+    /**
+     * The AVX2 two byte count. Same as SSE2, but 32 bytes per load.
+     */
+    LOZSRAME_TARGET("avx2")
+    auto avx2Count16(const quint16 *data, qint64 rows, quint16 mask,
+                     quint16 match) -> qint64 {
+        const __m256i zero    = _mm256_setzero_si256();
+        const __m256i ones    = _mm256_set1_epi16(1);
+        const __m256i masks   = _mm256_set1_epi16(static_cast<short>(mask));
+        const __m256i matches = _mm256_set1_epi16(static_cast<short>(match));
+        __m256i       sum     = zero;
+        qint64        i       = 0;
+
+        while (rows - i >= 16) {
+            const qint64 end = i + 16 * qMin<qint64>((rows - i) / 16, 32767);
+            __m256i      counters = zero;
+
+            for (; i < end; i += 16) {
+                const __m256i values = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(data + i));
+
+                counters = _mm256_sub_epi16(
+                    counters, _mm256_cmpeq_epi16(
+                                  _mm256_and_si256(values, masks), matches));
+            }
+
+            const __m256i pairs = _mm256_madd_epi16(counters, ones);
+
+            sum = _mm256_add_epi64(sum, _mm256_unpacklo_epi32(pairs, zero));
+            sum = _mm256_add_epi64(sum, _mm256_unpackhi_epi32(pairs, zero));
+        }
+
+        return total(sum) + scalarCount16(data + i, rows - i, mask, match);
+    }
+
+    /**
+     * The AVX2 one byte sum. Same as SSE2, but 32 bytes per load.
+     */
+    LOZSRAME_TARGET("avx2")
+    auto avx2Sum8(const quint8 *data, qint64 rows) -> qint64 {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i       sum  = zero;
+        qint64        i    = 0;
+
+        for (; rows - i >= 32; i += 32) {
+            const __m256i values = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(data + i));
+
+            sum = _mm256_add_epi64(sum, _mm256_sad_epu8(values, zero));
+        }
+
+        return total(sum) + scalarSum8(data + i, rows - i);
+    }
+#endif
+}  // namespace
+
+auto lozsrame::getColumnWidth(enum sc_column column) -> int {
+    switch (column) {
+        case COLUMN_COMPASSES:
+        case COLUMN_ITEMS:
+        case COLUMN_MAPS:
+        case COLUMN_ROOMS:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+auto lozsrame::getItemBit(enum sf_item item) -> int {
+    for (int i = 0; i < CORPUS_ITEM_COUNT; ++i) {
+        if (CORPUS_ITEMS[i] == item) {
+            return (1 << i);
+        }
+    }
+
+    Q_ASSERT(false);
+
+    return 0;
+}
+
+SaveCorpusWriter::SaveCorpusWriter() : rows(0) {}
+
+void SaveCorpusWriter::append(enum sc_column column, int value) {
+    columns[column].append(static_cast<char>(value & 0xFF));
+
+    if (getColumnWidth(column) == 2) {
+        columns[column].append(static_cast<char>((value >> 8) & 0xFF));
+    }
+}
+
+void SaveCorpusWriter::add(SRAMFile &sram) {
+    const int current = sram.getGame();
+
+    for (int game = 0; game < 3; ++game) {
+        if (!sram.isValid(game)) {
+            continue;
+        }
+
+        sram.setGame(game);
+
+        const MapState state     = sram.getMapState();
+        int            compasses = 0, items = 0, maps = 0, triforce = 0;
+
+        for (int level = 1; level <= 9; ++level) {
+            if (sram.hasCompass(level)) {
+                compasses |= (1 << (level - 1));
+            }
+
+            if (sram.hasMap(level)) {
+                maps |= (1 << (level - 1));
+            }
+        }
+
+        for (int i = 0; i < CORPUS_ITEM_COUNT; ++i) {
+            if (sram.hasItem(CORPUS_ITEMS[i])) {
+                items |= (1 << i);
+            }
+        }
+
+        for (int piece = 1; piece <= 8; ++piece) {
+            if (sram.hasTriforce(piece)) {
+                triforce |= (1 << (piece - 1));
+            }
+        }
+
+        append(COLUMN_ARROWS, sram.getArrows());
+        append(COLUMN_BOMBCAPACITY, sram.getBombCapacity());
+        append(COLUMN_BOMBS, sram.getBombs());
+        append(COLUMN_CANDLE, sram.getCandle());
+        append(COLUMN_COMPASSES, compasses);
+        append(COLUMN_HEARTCONTAINERS, sram.getHeartContainers());
+        append(COLUMN_ITEMS, items);
+        append(COLUMN_KEYS, sram.getKeys());
+        append(COLUMN_MAPS, maps);
+        append(COLUMN_NOTE, sram.getNote());
+        append(COLUMN_PLAYCOUNT, sram.getPlayCount());
+        append(COLUMN_POTION, sram.getPotion());
+        append(COLUMN_QUEST, sram.getQuest());
+        append(COLUMN_RING, sram.getRing());
+        append(COLUMN_ROOMS, state.getRoomsCleared());
+        append(COLUMN_RUPEES, sram.getRupees());
+        append(COLUMN_SCREENS, state.getScreensVisited());
+        append(COLUMN_SWORD, sram.getSword());
+        append(COLUMN_TRIFORCE, triforce);
+
+        ++rows;
+    }
+
+    sram.setGame(current);
+}
+
+auto SaveCorpusWriter::save(const QString &filename) const -> bool {
+    QByteArray header(CORPUS_HEADER_SIZE + (COLUMN_COUNT * CORPUS_ENTRY_SIZE),
+                      '\0');
+    char      *ptr = header.data();
+    qint64     offsets[COLUMN_COUNT];
+    qint64     offset = align(header.size());
+
+    std::memcpy(ptr, CORPUS_MAGIC, sizeof(CORPUS_MAGIC));
+    qToLittleEndian<quint32>(CORPUS_VERSION, ptr + 4);
+    qToLittleEndian<quint64>(rows, ptr + 8);
+    qToLittleEndian<quint32>(COLUMN_COUNT, ptr + 16);
+
+    for (int i = 0; i < COLUMN_COUNT; ++i) {
+        char *entry = ptr + CORPUS_HEADER_SIZE + (i * CORPUS_ENTRY_SIZE);
+
+        offsets[i] = offset;
+        offset     = align(offset + columns[i].size());
+
+        qToLittleEndian<quint32>(getColumnWidth(static_cast<sc_column>(i)),
+                                 entry);
+        qToLittleEndian<quint64>(offsets[i], entry + 8);
+    }
+
+    std::ofstream file(filename.toLatin1().data(),
+                       std::ios_base::out | std::ios_base::binary);
+
+    if (!file) {
+        return false;
+    }
+
+    const char padding[CORPUS_ALIGNMENT] = {};
+    qint64     written = header.size();
+
+    file.write(header.constData(), header.size());
+
+    for (int i = 0; i < COLUMN_COUNT; ++i) {
+        file.write(padding, offsets[i] - written);
+        file.write(columns[i].constData(), columns[i].size());
+        written = offsets[i] + columns[i].size();
+    }
+
+    file.write(padding, offset - written);
+
+    if (file.tellp() != static_cast<std::streampos>(offset)) {
+        return false;
+    }
+
+    file.close();
+
+    return true;
+}
+
+SaveCorpus::SaveCorpus(const QString &filename)
+    : file(new QFile(filename)), rows(0), kernel(getChecksumKernel()) {
+    if (!file->open(QIODevice::ReadOnly)) {
+        throw InvalidCorpusException(ICE_FILENOTFOUND);
+    }
+
+    const qint64 size = file->size();
+    const char  *data = nullptr;
+
+    if (size >= CORPUS_HEADER_SIZE + (COLUMN_COUNT * CORPUS_ENTRY_SIZE)) {
+        data = reinterpret_cast<const char *>(file->map(0, size));
+
+        if (!data) {
+            // some file systems can't be mapped, so fall back to a copy
+            buffer = file->readAll();
+            data   = buffer.constData();
+
+            if (buffer.size() != size) {
+                throw InvalidCorpusException(ICE_FILENOTFOUND);
+            }
+        }
+    }
+
+    // the mapping outlives the descriptor
+    file->close();
+
+    if (!data || (std::memcmp(data, CORPUS_MAGIC, sizeof(CORPUS_MAGIC)) != 0)
+        || (qFromLittleEndian<quint32>(data + 4) != CORPUS_VERSION)
+        || (qFromLittleEndian<quint32>(data + 16) != COLUMN_COUNT)) {
+        throw InvalidCorpusException(ICE_INVALIDFORMAT);
+    }
+
+    rows = static_cast<qint64>(qFromLittleEndian<quint64>(data + 8));
+
+    const char *entry = data + CORPUS_HEADER_SIZE;
+
+    for (int i = 0; i < COLUMN_COUNT; ++i, entry += CORPUS_ENTRY_SIZE) {
+        const int    width  = getColumnWidth(static_cast<sc_column>(i));
+        const qint64 offset = qFromLittleEndian<quint64>(entry + 8);
+
+        if ((qFromLittleEndian<quint32>(entry) != static_cast<quint32>(width))
+            || (rows < 0) || (offset < 0) || (offset > size)
+            || (rows > (size - offset) / width)) {
+            throw InvalidCorpusException(ICE_INVALIDFORMAT);
+        }
+
+        columns[i] = data + offset;
+    }
+}
+
+auto SaveCorpus::countMatches(enum sc_column column, int mask, int match) const
+    -> qint64 {
+    if (getColumnWidth(column) == 2) {
+        const auto *data = static_cast<const quint16 *>(getColumn(column));
+
+        switch (kernel) {
+#ifdef LOZSRAME_SIMD
+            case KERNEL_AVX2:
+                return avx2Count16(data, rows, mask, match);
+            case KERNEL_SSE2:
+                return sse2Count16(data, rows, mask, match);
+#endif
+            default:
+                return scalarCount16(data, rows, mask, match);
+        }
+    }
+
+    const auto *data = static_cast<const quint8 *>(getColumn(column));
+
+    switch (kernel) {
+#ifdef LOZSRAME_SIMD
+        case KERNEL_AVX2:
+            return avx2Count8(data, rows, mask, match);
+        case KERNEL_SSE2:
+            return sse2Count8(data, rows, mask, match);
+#endif
+        default:
+            return scalarCount8(data, rows, mask, match);
+    }
+}
+
+auto SaveCorpus::count(enum sc_column column, int value) const -> qint64 {
+    const int largest = (1 << (8 * getColumnWidth(column))) - 1;
+
+    // the kernels only compare the column's width, so a value that doesn't
+    // fit would match its truncated bits instead of nothing
+    if ((value < 0) || (value > largest)) {
+        return 0;
+    }
+
+    return countMatches(column, largest, value);
+}
+
+auto SaveCorpus::countAll(enum sc_column column, int bits) const -> qint64 {
+    return countMatches(column, bits, bits);
+}
+
+void SaveCorpus::histogram(enum sc_column column, qint64 *counts) const {
+    Q_ASSERT(getColumnWidth(column) == 1);
+
+    const auto *data = static_cast<const quint8 *>(getColumn(column));
+    qint64      partial[4][256] = {};
+    qint64      i               = 0;
+
+    // four tables so runs of the same value don't serialize on one counter
+    for (; rows - i >= 4; i += 4) {
+        ++partial[0][data[i]];
+        ++partial[1][data[i + 1]];
+        ++partial[2][data[i + 2]];
+        ++partial[3][data[i + 3]];
+    }
+
+    for (; i < rows; ++i) {
+        ++partial[0][data[i]];
+    }
+
+    for (int value = 0; value < 256; ++value) {
+        counts[value] = partial[0][value] + partial[1][value]
+                        + partial[2][value] + partial[3][value];
+    }
+}
+
+auto SaveCorpus::sum(enum sc_column column) const -> qint64 {
+    if (getColumnWidth(column) == 2) {
+        const auto *data  = static_cast<const quint16 *>(getColumn(column));
+        qint64      total = 0;
+
+        // the compass, item and map columns are bits, not amounts, so only
+        // the room counts are ever summed, and that isn't worth a kernel
+        for (qint64 i = 0; i < rows; ++i) {
+            total += qFromLittleEndian(data[i]);
+        }
+
+        return total;
+    }
+
+    const auto *data = static_cast<const quint8 *>(getColumn(column));
+
+    switch (kernel) {
+#ifdef LOZSRAME_SIMD
+        case KERNEL_AVX2:
+            return avx2Sum8(data, rows);
+        case KERNEL_SSE2:
+            return sse2Sum8(data, rows);
+#endif
+        default:
+            return scalarSum8(data, rows);
+    }
+}
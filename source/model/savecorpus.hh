@@ -0,0 +1,293 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_SAVECORPUS_HH_
+#define LOZSRAME_SAVECORPUS_HH_
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QString>
+
+#include "exceptions/invalidcorpusexception.hh"
+#include "model/checksum.hh"
+#include "model/sramfile.hh"
+
+class QFile;
+
+namespace lozsrame {
+    /// the number of items in the COLUMN_ITEMS bitset
+    const int CORPUS_ITEM_COUNT = 12;
+
+    /// the items in the COLUMN_ITEMS bitset, lowest bit first
+    const enum sf_item CORPUS_ITEMS[CORPUS_ITEM_COUNT] = {
+        ITEM_BOW,
+        ITEM_WHISTLE,
+        ITEM_BAIT,
+        ITEM_WAND,
+        ITEM_RAFT,
+        ITEM_BOOK,
+        ITEM_LADDER,
+        ITEM_MAGICKEY,
+        ITEM_POWERBRACELET,
+        ITEM_BOOMERANG,
+        ITEM_MAGICBOOMERANG,
+        ITEM_MAGICSHIELD,
+    };
+
+    /// the version of the corpus file format written by SaveCorpusWriter
+    const int CORPUS_VERSION = 2;
+
+    /**
+     * The columns of a save corpus. There is one row for each valid game
+     * in the SRAM files the corpus was built from. COLUMN_COMPASSES and
+     * COLUMN_MAPS hold one bit per level (bit 0 is level 1), COLUMN_ITEMS
+     * holds one bit per entry in CORPUS_ITEMS, and COLUMN_TRIFORCE holds
+     * one bit per piece. COLUMN_SCREENS and COLUMN_ROOMS hold the number
+     * of overworld screens visited and dungeon rooms cleared, from the
+     * game's MapState. The rest hold the value of the matching SRAMFile
+     * getter.
+     */
+    enum sc_column {
+        COLUMN_ARROWS,
+        COLUMN_BOMBCAPACITY,
+        COLUMN_BOMBS,
+        COLUMN_CANDLE,
+        COLUMN_COMPASSES,
+        COLUMN_HEARTCONTAINERS,
+        COLUMN_ITEMS,
+        COLUMN_KEYS,
+        COLUMN_MAPS,
+        COLUMN_NOTE,
+        COLUMN_PLAYCOUNT,
+        COLUMN_POTION,
+        COLUMN_QUEST,
+        COLUMN_RING,
+        COLUMN_ROOMS,
+        COLUMN_RUPEES,
+        COLUMN_SCREENS,
+        COLUMN_SWORD,
+        COLUMN_TRIFORCE,
+        COLUMN_COUNT
+    };
+
+    /**
+     * Gets the size of each value in a column.
+     *
+     * @param column The column.
+     *
+     * @return The size in bytes (1 or 2).
+     */
+    int getColumnWidth(enum sc_column column);
+
+    /**
+     * Gets the COLUMN_ITEMS bit for an item.
+     *
+     * @param item The item.
+     *
+     * @return The bit mask.
+     */
+    int getItemBit(enum sf_item item);
+
+    /**
+     * Builds a save corpus file from SRAM files.
+     *
+     * The file starts with a 24 byte header: the magic "LZSC", the version,
+     * the row count, and the column count. A directory of COLUMN_COUNT
+     * entries follows, each holding the column's width and the offset of
+     * its data. Each column is stored contiguously, starting on a 64 byte
+     * boundary so it can be mapped and scanned in place. All values are
+     * little-endian.
+     */
+    class SaveCorpusWriter {
+      private:
+        QByteArray columns[COLUMN_COUNT];
+        qint64     rows;
+
+        /**
+         * Adds a value to the end of a column.
+         *
+         * @param column The column.
+         * @param value The value.
+         */
+        void append(enum sc_column column, int value);
+
+      public:
+        /**
+         * Creates a new, empty SaveCorpusWriter.
+         */
+        SaveCorpusWriter();
+
+        /**
+         * Adds a row for each valid game in an SRAM file.
+         *
+         * @param sram The SRAM file. Its current game is left unchanged.
+         */
+        void add(SRAMFile &sram);
+
+        /**
+         * Gets the number of rows added so far.
+         *
+         * @return The number of rows.
+         */
+        qint64 getRowCount() const;
+
+        /**
+         * Saves the corpus to a file.
+         *
+         * @param filename The file to save to.
+         *
+         * @return true if the save succeeded; false otherwise.
+         */
+        bool save(const QString &filename) const;
+    };
+
+    /**
+     * A save corpus file, mapped read-only into memory, with aggregate
+     * queries that scan its columns using the fastest SIMD kernel the
+     * processor supports.
+     */
+    class SaveCorpus {
+      private:
+        QSharedPointer<QFile> file;
+        QByteArray            buffer;
+        const char           *columns[COLUMN_COUNT];
+        qint64                rows;
+        enum cs_kernel        kernel;
+
+        /**
+         * Counts the rows where (value & mask) == match.
+         *
+         * @param column The column.
+         * @param mask The bits to compare.
+         * @param match The value to compare against.
+         *
+         * @return The number of rows.
+         */
+        qint64 countMatches(enum sc_column column, int mask, int match) const;
+
+      public:
+        /**
+         * Opens a save corpus file.
+         *
+         * @param filename The corpus filename.
+         *
+         * @throw InvalidCorpusException if the file can't be read or is not
+         *        a valid corpus.
+         */
+        SaveCorpus(const QString &filename);
+
+        /**
+         * Gets the raw values of a column.
+         *
+         * @param column The column.
+         *
+         * @return The values, getRowCount() of getColumnWidth(column)
+         *         bytes each.
+         */
+        const void *getColumn(enum sc_column column) const;
+
+        /**
+         * Gets the kernel used to scan the columns.
+         *
+         * @return The kernel.
+         */
+        enum cs_kernel getKernel() const;
+
+        /**
+         * Sets the kernel used to scan the columns. This is the fastest
+         * supported kernel by default.
+         *
+         * @param kernel The kernel. It must be supported.
+         */
+        void setKernel(enum cs_kernel kernel);
+
+        /**
+         * Gets the number of rows in the corpus.
+         *
+         * @return The number of rows.
+         */
+        qint64 getRowCount() const;
+
+        /**
+         * Counts the rows where a column has a value.
+         *
+         * @param column The column.
+         * @param value The value.
+         *
+         * @return The number of rows, which is 0 if the value doesn't fit
+         *         in the column.
+         */
+        qint64 count(enum sc_column column, int value) const;
+
+        /**
+         * Counts the rows where a bitset column has every one of some bits
+         * set, such as the games with the magic key.
+         *
+         * @param column The column.
+         * @param bits The bits.
+         *
+         * @return The number of rows.
+         */
+        qint64 countAll(enum sc_column column, int bits) const;
+
+        /**
+         * Counts the rows for each value of a one byte column.
+         *
+         * @param column The column.
+         * @param counts Set to the number of rows with each value. It must
+         *               have room for 256 values.
+         */
+        void histogram(enum sc_column column, qint64 *counts) const;
+
+        /**
+         * Adds together the values of a column.
+         *
+         * @param column The column.
+         *
+         * @return The sum.
+         */
+        qint64 sum(enum sc_column column) const;
+    };
+
+    inline qint64 SaveCorpusWriter::getRowCount() const {
+        return rows;
+    }
+
+    inline const void *SaveCorpus::getColumn(enum sc_column column) const {
+        return columns[column];
+    }
+
+    inline enum cs_kernel SaveCorpus::getKernel() const {
+        return kernel;
+    }
+
+    inline void SaveCorpus::setKernel(enum cs_kernel kernel) {
+        Q_ASSERT(isChecksumKernelSupported(kernel));
+
+        this->kernel = kernel;
+    }
+
+    inline qint64 SaveCorpus::getRowCount() const {
+        return rows;
+    }
+}  // namespace lozsrame
+
+#endif
@@ -0,0 +1,331 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cstring>
+
+#include <QFile>
+#include <QtCore/qendian.h>
+
+#include "model/filesync.hh"
+#include "model/savestore.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /// size of the file header
+    const int STORE_HEADER_SIZE = 16;
+
+    /// size of each image record: the hash followed by the SRAM data
+    const int STORE_IMAGE_SIZE = 16 + SRAM_SIZE;
+
+    /// size of the fixed part of each path record
+    const int STORE_PATH_SIZE = 8;
+
+    /// the file magic
+    const char STORE_MAGIC[4] = {'L', 'Z', 'S', 'S'};
+
+    /**
+     * Rotates a 64-bit value left.
+     *
+     * @param value The value.
+     * @param bits The number of bits to rotate by.
+     *
+     * @return The rotated value.
+     */
+    inline auto rotl(quint64 value, int bits) -> quint64 {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    /**
+     * Mixes the bits of a 64-bit value so each affects all the others.
+     *
+     * @param value The value.
+     *
+     * @return The mixed value.
+     */
+    inline auto fmix(quint64 value) -> quint64 {
+        value ^= value >> 33;
+        value *= Q_UINT64_C(0xFF51AFD7ED558CCD);
+        value ^= value >> 33;
+        value *= Q_UINT64_C(0xC4CEB9FE1A85EC53);
+        value ^= value >> 33;
+
+        return value;
+    }
+}  // namespace
+
+auto SaveHash::toString() const -> QString {
+    return QString("%1%2")
+        .arg(high, 16, 16, QChar('0'))
+        .arg(low, 16, 16, QChar('0'));
+}
+
+SaveStore::SaveStore() : validations(0), reuses(0) {}
+
+SaveStore::SaveStore(const QString &filename) : validations(0), reuses(0) {
+    QFile file(filename);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw InvalidSaveStoreException(ISSE_FILENOTFOUND);
+    }
+
+    const QByteArray buffer = file.readAll();
+    const char      *data   = buffer.constData();
+    const qint64     size   = buffer.size();
+
+    if ((size < STORE_HEADER_SIZE)
+        || (std::memcmp(data, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0)
+        || (qFromLittleEndian<quint32>(data + 4) != STORE_VERSION)) {
+        throw InvalidSaveStoreException(ISSE_INVALIDFORMAT);
+    }
+
+    const qint64    imageCount = qFromLittleEndian<quint32>(data + 8);
+    const qint64    pathCount  = qFromLittleEndian<quint32>(data + 12);
+    qint64          offset     = STORE_HEADER_SIZE;
+    QList<SaveHash> hashes;
+
+    if (imageCount > (size - offset) / STORE_IMAGE_SIZE) {
+        throw InvalidSaveStoreException(ISSE_INVALIDFORMAT);
+    }
+
+    for (qint64 i = 0; i < imageCount; ++i, offset += STORE_IMAGE_SIZE) {
+        const char *image = data + offset + 16;
+        SaveHash    key   = {qFromLittleEndian<quint64>(data + offset),
+                             qFromLittleEndian<quint64>(data + offset + 8)};
+
+        if (!(hash(image) == key) || images.contains(key)) {
+            throw InvalidSaveStoreException(ISSE_INVALIDFORMAT);
+        }
+
+        images[key].data = QByteArray(image, SRAM_SIZE);
+        hashes.append(key);
+    }
+
+    for (qint64 i = 0; i < pathCount; ++i) {
+        if (size - offset < STORE_PATH_SIZE) {
+            throw InvalidSaveStoreException(ISSE_INVALIDFORMAT);
+        }
+
+        const qint64 index  = qFromLittleEndian<quint32>(data + offset);
+        const qint64 length = qFromLittleEndian<quint32>(data + offset + 4);
+
+        offset += STORE_PATH_SIZE;
+
+        if ((index >= imageCount) || (length > size - offset)) {
+            throw InvalidSaveStoreException(ISSE_INVALIDFORMAT);
+        }
+
+        const QString  path = QString::fromUtf8(data + offset, length);
+        const SaveHash key  = hashes.at(index);
+
+        offset += length;
+
+        if (paths.contains(path)) {
+            throw InvalidSaveStoreException(ISSE_INVALIDFORMAT);
+        }
+
+        paths.insert(path, key);
+        ++images[key].refs;
+    }
+
+    if (offset != size) {
+        throw InvalidSaveStoreException(ISSE_INVALIDFORMAT);
+    }
+}
+
+auto SaveStore::add(const QString &path, const char *data, qint64 size)
+    -> SaveHash {
+    if (size != SRAM_SIZE) {
+        throw InvalidSRAMFileException(ISFE_INVALIDSIZE);
+    }
+
+    const SaveHash key   = hash(data);
+    Image         &image = images[key];
+
+    if (image.data.isEmpty()) {
+        image.data = QByteArray(data, SRAM_SIZE);
+    } else if (std::memcmp(image.data.constData(), data, SRAM_SIZE) != 0) {
+        // the hash isn't cryptographic, so a crafted file could collide
+        throw InvalidSaveStoreException(ISSE_COLLISION);
+    }
+
+    // take the reference before dropping the old one, in case they match
+    ++image.refs;
+    remove(path);
+    paths.insert(path, key);
+
+    return key;
+}
+
+auto SaveStore::addFile(const QString &filename) -> SaveHash {
+    QFile file(filename);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw InvalidSRAMFileException(ISFE_FILENOTFOUND);
+    }
+
+    const QByteArray data = file.read(SRAM_SIZE + 1);
+
+    return add(filename, data.constData(), data.size());
+}
+
+auto SaveStore::remove(const QString &path) -> bool {
+    auto it = paths.find(path);
+
+    if (it == paths.end()) {
+        return false;
+    }
+
+    auto image = images.find(it.value());
+
+    if (--image->refs == 0) {
+        images.erase(image);
+    }
+
+    paths.erase(it);
+
+    return true;
+}
+
+auto SaveStore::validate(const SaveHash &hash) -> const Image & {
+    Q_ASSERT(images.contains(hash));
+
+    Image &image = images[hash];
+
+    if (image.checked) {
+        ++reuses;
+
+        return image;
+    }
+
+    try {
+        image.validation =
+            SRAMFile::fromData(image.data.constData(), SRAM_SIZE)
+                .getValidation();
+        image.valid = true;
+    } catch (InvalidSRAMFileException &) {
+        image.valid = false;
+    }
+
+    image.checked = true;
+    ++validations;
+
+    return image;
+}
+
+auto SaveStore::isValid(const SaveHash &hash) -> bool {
+    return validate(hash).valid;
+}
+
+auto SaveStore::load(const QString &path) -> SRAMFile {
+    if (!paths.contains(path)) {
+        throw InvalidSRAMFileException(ISFE_FILENOTFOUND);
+    }
+
+    const Image &image = validate(paths.value(path));
+
+    if (!image.valid) {
+        throw InvalidSRAMFileException(ISFE_NOVALIDGAMES);
+    }
+
+    return SRAMFile::fromData(image.data.constData(), SRAM_SIZE,
+                              image.validation);
+}
+
+auto SaveStore::save(const QString &filename) const -> bool {
+    QByteArray           data(STORE_HEADER_SIZE, '\0');
+    QHash<SaveHash, int> indexes;
+    char                 record[STORE_PATH_SIZE];
+
+    std::memcpy(data.data(), STORE_MAGIC, sizeof(STORE_MAGIC));
+    qToLittleEndian<quint32>(STORE_VERSION, data.data() + 4);
+    qToLittleEndian<quint32>(images.size(), data.data() + 8);
+    qToLittleEndian<quint32>(paths.size(), data.data() + 12);
+
+    data.reserve(STORE_HEADER_SIZE + (images.size() * (16 + SRAM_SIZE))
+                 + (paths.size() * (STORE_PATH_SIZE + 64)));
+
+    for (auto it = images.constBegin(); it != images.constEnd(); ++it) {
+        char key[16];
+
+        qToLittleEndian<quint64>(it.key().low, key);
+        qToLittleEndian<quint64>(it.key().high, key + 8);
+
+        indexes.insert(it.key(), indexes.size());
+        data.append(key, sizeof(key));
+        data.append(it.value().data.constData(), SRAM_SIZE);
+    }
+
+    for (auto it = paths.constBegin(); it != paths.constEnd(); ++it) {
+        const QByteArray path = it.key().toUtf8();
+
+        qToLittleEndian<quint32>(indexes.value(it.value()), record);
+        qToLittleEndian<quint32>(path.size(), record + 4);
+
+        data.append(record, sizeof(record));
+        data.append(path);
+    }
+
+    // written beside the old store and renamed over it, so a failed or
+    // interrupted save leaves the old store intact
+    const QString target    = resolveFile(filename);
+    const QString temporary = writeTemporary(target, data, true);
+
+    if (temporary.isEmpty()) {
+        return false;
+    }
+
+    if (!replaceFile(temporary, target)) {
+        QFile::remove(temporary);
+
+        return false;
+    }
+
+    return true;
+}
+
+auto SaveStore::hash(const char *image) -> SaveHash {
+    // MurmurHash3 x64 128, unrolled for the fixed image size
+    const quint64 c1 = Q_UINT64_C(0x87C37B91114253D5);
+    const quint64 c2 = Q_UINT64_C(0x4CF5AD432745937F);
+    quint64       h1 = 0, h2 = 0;
+
+    for (int i = 0; i < SRAM_SIZE; i += 16) {
+        quint64 k1 = qFromLittleEndian<quint64>(image + i);
+        quint64 k2 = qFromLittleEndian<quint64>(image + i + 8);
+
+        h1 ^= rotl(k1 * c1, 31) * c2;
+        h1  = (rotl(h1, 27) + h2) * 5 + 0x52DCE729;
+        h2 ^= rotl(k2 * c2, 33) * c1;
+        h2  = (rotl(h2, 31) + h1) * 5 + 0x38495AB5;
+    }
+
+    h1 ^= SRAM_SIZE;
+    h2 ^= SRAM_SIZE;
+    h1 += h2;
+    h2 += h1;
+    h1  = fmix(h1);
+    h2  = fmix(h2);
+    h1 += h2;
+    h2 += h1;
+
+    return {h1, h2};
+}
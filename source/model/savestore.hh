@@ -0,0 +1,326 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_SAVESTORE_HH_
+#define LOZSRAME_SAVESTORE_HH_
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include "exceptions/invalidsavestoreexception.hh"
+#include "model/sramfile.hh"
+
+namespace lozsrame {
+    /// the SaveStore file format version
+    const int STORE_VERSION = 1;
+
+    /**
+     * A 128-bit hash of an SRAM image, used as its key in a SaveStore.
+     */
+    struct SaveHash {
+        quint64 low, high;
+
+        /**
+         * Gets the hash as 32 hexadecimal digits.
+         *
+         * @return The hash.
+         */
+        QString toString() const;
+    };
+
+    /**
+     * Compares two hashes.
+     *
+     * @param a The first hash.
+     * @param b The second hash.
+     *
+     * @return true if they are the same; false otherwise.
+     */
+    bool operator==(const SaveHash &a, const SaveHash &b);
+
+    /**
+     * Hashes a hash, for QHash.
+     *
+     * @param hash The hash.
+     * @param seed The QHash seed.
+     *
+     * @return The hash of the hash.
+     */
+    uint qHash(const SaveHash &hash, uint seed = 0);
+
+    /**
+     * A content addressed store of SRAM files. Each distinct SRAM image is
+     * kept once, keyed by its hash, and each path added maps to the hash of
+     * its image, so a thousand copies of the same file cost one image.
+     *
+     * Validation is remembered per image too. The first time an image is
+     * loaded or checked it is checksummed, and every other path with the
+     * same image reuses that result instead of checksumming it again.
+     *
+     * A SaveStore is not thread safe.
+     */
+    class SaveStore {
+      private:
+        /// a distinct SRAM image and what is known about it
+        struct Image {
+            QByteArray     data;
+            int            refs    = 0;
+            bool           checked = false, valid = false;
+            SRAMValidation validation;
+        };
+
+        QHash<SaveHash, Image>   images;
+        QHash<QString, SaveHash> paths;
+        qint64                   validations, reuses;
+
+        /**
+         * Gets an image, checksumming it if this is the first time it has
+         * been validated.
+         *
+         * @param hash The image's hash.
+         *
+         * @return The image.
+         */
+        const Image &validate(const SaveHash &hash);
+
+      public:
+        /**
+         * Creates a new, empty SaveStore.
+         */
+        SaveStore();
+
+        /**
+         * Creates a SaveStore from a file written by save(). Each image is
+         * hashed again as it is read, to catch corrupted files.
+         *
+         * @param filename The store file.
+         *
+         * @throw InvalidSaveStoreException if the file can't be read or is
+         *        not a valid store file.
+         */
+        SaveStore(const QString &filename);
+
+        /**
+         * Adds SRAM data to the store under a path, replacing whatever the
+         * path held before. The data is only copied if no identical image
+         * is already in the store.
+         *
+         * @param path The path.
+         * @param data The SRAM data.
+         * @param size The size of the data.
+         *
+         * @return The hash of the data.
+         *
+         * @throw InvalidSRAMFileException if the data is the wrong size.
+         * @throw InvalidSaveStoreException if the data's hash matches a
+         *        different image already in the store.
+         */
+        SaveHash add(const QString &path, const char *data, qint64 size);
+
+        /**
+         * Adds an SRAM file to the store under its own filename.
+         *
+         * @param filename The SRAM file.
+         *
+         * @return The hash of the file.
+         *
+         * @throw InvalidSRAMFileException if the file can't be read or is
+         *        the wrong size.
+         * @throw InvalidSaveStoreException if the file's hash matches a
+         *        different image already in the store.
+         */
+        SaveHash addFile(const QString &filename);
+
+        /**
+         * Removes a path from the store, and its image too if no other path
+         * uses it.
+         *
+         * @param path The path.
+         *
+         * @return true if the path was removed; false if it wasn't there.
+         */
+        bool remove(const QString &path);
+
+        /**
+         * Checks if a path is in the store.
+         *
+         * @param path The path.
+         *
+         * @return true if it is; false otherwise.
+         */
+        bool contains(const QString &path) const;
+
+        /**
+         * Gets the hash of the image stored under a path.
+         *
+         * @param path The path, which must be in the store.
+         *
+         * @return The hash.
+         */
+        SaveHash getHash(const QString &path) const;
+
+        /**
+         * Gets every path in the store, in no particular order.
+         *
+         * @return The paths.
+         */
+        QStringList getPaths() const;
+
+        /**
+         * Gets the hash of every image in the store, in no particular order.
+         *
+         * @return The hashes.
+         */
+        QList<SaveHash> getHashes() const;
+
+        /**
+         * Gets the SRAM data of an image.
+         *
+         * @param hash The image's hash, which must be in the store.
+         *
+         * @return The SRAM data.
+         */
+        QByteArray getData(const SaveHash &hash) const;
+
+        /**
+         * Checks if an image has any valid games, checksumming it only if
+         * it hasn't been validated before.
+         *
+         * @param hash The image's hash, which must be in the store.
+         *
+         * @return true if it is valid; false otherwise.
+         */
+        bool isValid(const SaveHash &hash);
+
+        /**
+         * Loads the SRAM file stored under a path, checksumming it only if
+         * its image hasn't been validated before.
+         *
+         * @param path The path.
+         *
+         * @return The SRAM file.
+         *
+         * @throw InvalidSRAMFileException if the path isn't in the store or
+         *        has no valid games.
+         */
+        SRAMFile load(const QString &path);
+
+        /**
+         * Gets the number of distinct images in the store.
+         *
+         * @return The number of images.
+         */
+        int getImageCount() const;
+
+        /**
+         * Gets the number of paths in the store.
+         *
+         * @return The number of paths.
+         */
+        int getPathCount() const;
+
+        /**
+         * Gets the number of times an image was checksummed.
+         *
+         * @return The number of validations.
+         */
+        qint64 getValidationCount() const;
+
+        /**
+         * Gets the number of times a remembered validation was used instead
+         * of checksumming an image again.
+         *
+         * @return The number of reused validations.
+         */
+        qint64 getReuseCount() const;
+
+        /**
+         * Saves the store to a file.
+         *
+         * @param filename The file to save to.
+         *
+         * @return true if the save succeeded; false otherwise.
+         */
+        bool save(const QString &filename) const;
+
+        /**
+         * Hashes an SRAM image.
+         *
+         * @param image The SRAM_SIZE bytes of SRAM data.
+         *
+         * @return The hash.
+         */
+        static SaveHash hash(const char *image);
+    };
+
+    inline bool operator==(const SaveHash &a, const SaveHash &b) {
+        return (a.low == b.low) && (a.high == b.high);
+    }
+
+    inline uint qHash(const SaveHash &hash, uint seed) {
+        // the bits are already well mixed
+        return static_cast<uint>(hash.low) ^ seed;
+    }
+
+    inline bool SaveStore::contains(const QString &path) const {
+        return paths.contains(path);
+    }
+
+    inline SaveHash SaveStore::getHash(const QString &path) const {
+        Q_ASSERT(paths.contains(path));
+
+        return paths.value(path);
+    }
+
+    inline QStringList SaveStore::getPaths() const {
+        return paths.keys();
+    }
+
+    inline QList<SaveHash> SaveStore::getHashes() const {
+        return images.keys();
+    }
+
+    inline QByteArray SaveStore::getData(const SaveHash &hash) const {
+        Q_ASSERT(images.contains(hash));
+
+        return images.value(hash).data;
+    }
+
+    inline int SaveStore::getImageCount() const {
+        return images.size();
+    }
+
+    inline int SaveStore::getPathCount() const {
+        return paths.size();
+    }
+
+    inline qint64 SaveStore::getValidationCount() const {
+        return validations;
+    }
+
+    inline qint64 SaveStore::getReuseCount() const {
+        return reuses;
+    }
+}  // namespace lozsrame
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_SIMD_HH_
+#define LOZSRAME_SIMD_HH_
+
+// LOZSRAME_SIMD is defined when the x86 intrinsics are available, and
+// LOZSRAME_TARGET(isa) marks a function as compiled for an extension the
+// rest of the program can't assume. Such functions must only be called
+// after checking getChecksumKernel().
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define LOZSRAME_SIMD
+    #define LOZSRAME_TARGET(isa) __attribute__((target(isa)))
+
+    #include <cpuid.h>
+    #include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #define LOZSRAME_SIMD
+    #define LOZSRAME_TARGET(isa)
+
+    #include <immintrin.h>
+    #include <intrin.h>
+#endif
+
+#endif
@@ -0,0 +1,307 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cstring>
+#include <new>
+
+#include <QFile>
+#include <QtCore/qendian.h>
+
+#include "model/checksum.hh"
+#include "model/srambatch.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /// images start on multiples of this, for aligned SIMD loads
+    const int SRAMBATCH_ALIGNMENT = 64;
+
+    /// files the batch makes room for the first time it grows
+    const int SRAMBATCH_MINIMUM = 16;
+}  // namespace
+
+SRAMBatch::SRAMBatch() : arena(nullptr), fileCount(0), capacity(0) {}
+
+SRAMBatch::~SRAMBatch() {
+    qFreeAligned(arena);
+}
+
+void SRAMBatch::reserve(int files) {
+    if (files <= capacity) {
+        return;
+    }
+
+    void *grown = qReallocAligned(arena, static_cast<size_t>(files) * SRAM_SIZE,
+                                  static_cast<size_t>(capacity) * SRAM_SIZE,
+                                  SRAMBATCH_ALIGNMENT);
+
+    if (!grown) {
+        throw std::bad_alloc();
+    }
+
+    arena    = static_cast<char *>(grown);
+    capacity = files;
+
+    valid.reserve(files);
+    dirty.reserve(files);
+}
+
+auto SRAMBatch::admit() -> int {
+    const char *data = arena + (static_cast<qint64>(fileCount) * SRAM_SIZE);
+    const SRAMValidation validation = SRAMFile::validateData(data);
+
+    int games = 0;
+
+    for (int game = 0; game < 3; ++game) {
+        games |= (validation.valid[game] ? (1 << game) : 0);
+    }
+
+    if (games == 0) {
+        throw InvalidSRAMFileException(ISFE_NOVALIDGAMES);
+    }
+
+    valid.append(static_cast<quint8>(games));
+    dirty.append(0);
+
+    return fileCount++;
+}
+
+auto SRAMBatch::append(const char *data, qint64 size) -> int {
+    if (size != SRAM_SIZE) {
+        throw InvalidSRAMFileException(ISFE_INVALIDSIZE);
+    }
+
+    if (fileCount == capacity) {
+        reserve(qMax(capacity * 2, SRAMBATCH_MINIMUM));
+    }
+
+    std::memcpy(arena + (static_cast<qint64>(fileCount) * SRAM_SIZE), data,
+                SRAM_SIZE);
+
+    return admit();
+}
+
+auto SRAMBatch::append(const QString &filename) -> int {
+    QFile file(filename);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw InvalidSRAMFileException(ISFE_FILENOTFOUND);
+    }
+
+    if (file.size() != SRAM_SIZE) {
+        throw InvalidSRAMFileException(ISFE_INVALIDSIZE);
+    }
+
+    if (fileCount == capacity) {
+        reserve(qMax(capacity * 2, SRAMBATCH_MINIMUM));
+    }
+
+    // read straight into place rather than through a buffer
+    char *target = arena + (static_cast<qint64>(fileCount) * SRAM_SIZE);
+
+    if (file.read(target, SRAM_SIZE) != SRAM_SIZE) {
+        throw InvalidSRAMFileException(ISFE_INVALIDSIZE);
+    }
+
+    return admit();
+}
+
+void SRAMBatch::clear() {
+    fileCount = 0;
+
+    valid.clear();
+    dirty.clear();
+}
+
+void SRAMBatch::setByte(int file, int game, int offset, int value) {
+    Q_ASSERT(isValid(file, game));
+    Q_ASSERT((offset >= 0) && (offset < SRAM_SIZE));
+
+    arena[(static_cast<qint64>(file) * SRAM_SIZE) + offset] =
+        static_cast<char>(value);
+    dirty[file] |= (1 << game);
+}
+
+void SRAMBatch::updateChecksums(int file) {
+    const int games = dirty[file];
+
+    if (games == 0) {
+        return;
+    }
+
+    char *data = arena + (static_cast<qint64>(file) * SRAM_SIZE);
+    auto *ptr  = reinterpret_cast<quint16 *>(data + CHECKSUM_OFFSET);
+
+    for (int game = 0; game < 3; ++game) {
+        if (games & (1 << game)) {
+            ptr[game] = qToBigEndian(slotChecksum(data, game));
+        }
+    }
+
+    dirty[file] = 0;
+}
+
+void SRAMBatch::updateChecksums() {
+    for (int file = 0; file < fileCount; ++file) {
+        updateChecksums(file);
+    }
+}
+
+auto SRAMBatch::toData(int file) -> QByteArray {
+    updateChecksums(file);
+
+    return QByteArray(image(file), SRAM_SIZE);
+}
+
+void SRAMBatch::setProperty(int file, int game, enum sf_property property,
+                            int value) {
+    Q_ASSERT(isPropertyInRange(SRAM_PROPERTIES[property], value));
+
+    const PropertyDescriptor &descriptor = SRAM_PROPERTIES[property];
+
+    setByte(file, game, getPropertyOffset(descriptor, game),
+            mergeProperty(image(file), game, descriptor, value));
+}
+
+void SRAMBatch::setArrows(int file, int game, enum sf_arrow arrows) {
+    setProperty<PROPERTY_ARROWS>(file, game, arrows);
+}
+
+void SRAMBatch::setBombCapacity(int file, int game, int capacity) {
+    setProperty<PROPERTY_BOMBCAPACITY>(file, game, capacity);
+}
+
+void SRAMBatch::setBombs(int file, int game, int bombs) {
+    setProperty<PROPERTY_BOMBS>(file, game, bombs);
+}
+
+void SRAMBatch::setCandle(int file, int game, enum sf_candle candle) {
+    setProperty<PROPERTY_CANDLE>(file, game, candle);
+}
+
+void SRAMBatch::setCompass(int file, int game, int level, bool give) {
+    Q_ASSERT((level >= 1) && (level <= 9));
+
+    if (level == 9) {
+        setProperty<PROPERTY_COMPASS9>(file, game, (give ? 1 : 0));
+
+        return;
+    }
+
+    const int bit  = (1 << (level - 1));
+    const int bits = getProperty<PROPERTY_COMPASSES>(file, game);
+
+    setProperty<PROPERTY_COMPASSES>(file, game,
+                                    (give ? (bits | bit) : (bits & ~bit)));
+}
+
+void SRAMBatch::setHeartContainers(int file, int game, int containers) {
+    setProperty<PROPERTY_HEARTCONTAINERS>(file, game, containers);
+}
+
+void SRAMBatch::setItem(int file, int game, enum sf_item item, bool give) {
+    setProperty(file, game, getItemProperty(item), (give ? 1 : 0));
+}
+
+void SRAMBatch::setKeys(int file, int game, int keys) {
+    setProperty<PROPERTY_KEYS>(file, game, keys);
+}
+
+void SRAMBatch::setMap(int file, int game, int level, bool give) {
+    Q_ASSERT((level >= 1) && (level <= 9));
+
+    if (level == 9) {
+        setProperty<PROPERTY_MAP9>(file, game, (give ? 1 : 0));
+
+        return;
+    }
+
+    const int bit  = (1 << (level - 1));
+    const int bits = getProperty<PROPERTY_MAPS>(file, game);
+
+    setProperty<PROPERTY_MAPS>(file, game,
+                               (give ? (bits | bit) : (bits & ~bit)));
+}
+
+auto SRAMBatch::getName(int file, int game) const -> QString {
+    char name[NAME_DATA_SIZE];
+
+    getName(file, game, name);
+
+    return QString::fromLatin1(name, NAME_DATA_SIZE);
+}
+
+void SRAMBatch::setName(int file, int game, const QString &name) {
+    const int offset = NAME_DATA + (game * NAME_DATA_SIZE);
+    const int length = qMin(name.length(), NAME_DATA_SIZE);
+    char      text[NAME_DATA_SIZE], raw[NAME_DATA_SIZE];
+
+    // pad with spaces
+    std::memset(text, ' ', NAME_DATA_SIZE);
+
+    for (int i = 0; i < length; ++i) {
+        text[i] = name[i].toLatin1();
+    }
+
+    encodeName(text, NAME_DATA_SIZE, raw);
+
+    for (int i = 0; i < NAME_DATA_SIZE; ++i) {
+        setByte(file, game, offset + i, raw[i]);
+    }
+}
+
+void SRAMBatch::setNote(int file, int game, enum sf_note note) {
+    setProperty<PROPERTY_NOTE>(file, game, note);
+}
+
+void SRAMBatch::setPlayCount(int file, int game, int count) {
+    setProperty<PROPERTY_PLAYCOUNT>(file, game, count);
+}
+
+void SRAMBatch::setPotion(int file, int game, enum sf_potion potion) {
+    setProperty<PROPERTY_POTION>(file, game, potion);
+}
+
+void SRAMBatch::setQuest(int file, int game, enum sf_quest quest) {
+    setProperty<PROPERTY_QUEST>(file, game, quest);
+}
+
+void SRAMBatch::setRing(int file, int game, enum sf_ring ring) {
+    setProperty<PROPERTY_RING>(file, game, ring);
+}
+
+void SRAMBatch::setRupees(int file, int game, int rupees) {
+    setProperty<PROPERTY_RUPEES>(file, game, rupees);
+}
+
+void SRAMBatch::setSword(int file, int game, enum sf_sword sword) {
+    setProperty<PROPERTY_SWORD>(file, game, sword);
+}
+
+void SRAMBatch::setTriforce(int file, int game, int piece, bool give) {
+    Q_ASSERT((piece >= 1) && (piece <= 8));
+
+    const int bit  = (1 << (piece - 1));
+    const int bits = getProperty<PROPERTY_TRIFORCE>(file, game);
+
+    setProperty<PROPERTY_TRIFORCE>(file, game,
+                                   (give ? (bits | bit) : (bits & ~bit)));
+}
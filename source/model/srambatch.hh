@@ -0,0 +1,772 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_SRAMBATCH_HH_
+#define LOZSRAME_SRAMBATCH_HH_
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "model/mapstate.hh"
+#include "model/namecodec.hh"
+#include "model/sramfile.hh"
+
+namespace lozsrame {
+    /**
+     * Many SRAM images held back to back in one aligned block of memory,
+     * with the same typed accessors as SRAMFile addressed by file and game.
+     * Scanning or editing a whole batch walks the block front to back, so
+     * the hardware prefetcher can stream it, where thousands of SRAMFile
+     * objects would each be a separate heap allocation.
+     *
+     * The setters don't keep the checksums up to date as they go. They
+     * mark the game instead, and updateChecksums() or toData() recompute
+     * only the games that changed.
+     */
+    class SRAMBatch {
+      private:
+        char           *arena;
+        int             fileCount, capacity;
+        QVector<quint8> valid, dirty;
+
+        /**
+         * Gets one of the images.
+         *
+         * @param file The file.
+         *
+         * @return The SRAM data.
+         */
+        const char *image(int file) const;
+
+        /**
+         * Changes one byte of a game and marks its checksum stale.
+         *
+         * @param file The file.
+         * @param game The game the byte belongs to.
+         * @param offset The offset of the byte in the image.
+         * @param value The new value.
+         */
+        void setByte(int file, int game, int offset, int value);
+
+        /**
+         * Validates the image after the last one and adds it to the batch.
+         *
+         * @return The index of the new file.
+         *
+         * @throw InvalidSRAMFileException if none of the games are valid.
+         */
+        int admit();
+
+        /**
+         * Recomputes the stale checksums of one file.
+         *
+         * @param file The file.
+         */
+        void updateChecksums(int file);
+
+      public:
+        /**
+         * Creates a new, empty SRAMBatch.
+         */
+        SRAMBatch();
+
+        SRAMBatch(const SRAMBatch &) = delete;
+        SRAMBatch &operator=(const SRAMBatch &) = delete;
+
+        /**
+         * Destroys an SRAMBatch.
+         */
+        ~SRAMBatch();
+
+        /**
+         * Makes room for a number of files, so appending that many doesn't
+         * have to move the batch.
+         *
+         * @param files The number of files.
+         */
+        void reserve(int files);
+
+        /**
+         * Adds SRAM data already in memory to the batch. The data is
+         * copied.
+         *
+         * @param data The SRAM data.
+         * @param size The size of the data.
+         *
+         * @return The index of the new file.
+         *
+         * @throw InvalidSRAMFileException if the data is not valid SRAM data.
+         */
+        int append(const char *data, qint64 size);
+
+        /**
+         * Reads an SRAM file straight into the batch.
+         *
+         * @param filename The SRAM filename.
+         *
+         * @return The index of the new file.
+         *
+         * @throw InvalidSRAMFileException if the file is not a valid SRAM file.
+         */
+        int append(const QString &filename);
+
+        /**
+         * Removes every file from the batch, keeping its memory.
+         */
+        void clear();
+
+        /**
+         * Gets the number of files in the batch.
+         *
+         * @return The number of files.
+         */
+        int getCount() const;
+
+        /**
+         * Returns true if a game slot of a file is valid; false otherwise.
+         *
+         * @param file The file.
+         * @param game The game slot to check.
+         *
+         * @return true if valid; false otherwise.
+         */
+        bool isValid(int file, int game) const;
+
+        /**
+         * Brings the checksums of every changed game up to date.
+         */
+        void updateChecksums();
+
+        /**
+         * Gets the SRAM data of a file, with its checksums brought up to
+         * date.
+         *
+         * @param file The file.
+         *
+         * @return The SRAM data.
+         */
+        QByteArray toData(int file);
+
+        /**
+         * Calls a function with each valid game, in the order the files sit
+         * in memory. The function may call the setters, but not append().
+         *
+         * @param visit Called as visit(file, game).
+         */
+        template <typename Visitor>
+        void forEach(Visitor visit) const;
+
+        /**
+         * Counts the valid games matching a predicate, in the order the
+         * files sit in memory.
+         *
+         * @param match Called as match(file, game), returning a bool.
+         *
+         * @return The number of matching games.
+         */
+        template <typename Predicate>
+        qint64 count(Predicate match) const;
+
+        /**
+         * Decodes the map data of a game.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The map state.
+         */
+        MapState getMapState(int file, int game) const;
+
+        /**
+         * Gets a property of a game.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The value.
+         */
+        template <enum sf_property P>
+        int getProperty(int file, int game) const;
+
+        /**
+         * Gets a property of a game, chosen at run time.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param property The property.
+         *
+         * @return The value.
+         */
+        int getProperty(int file, int game, enum sf_property property) const;
+
+        /**
+         * Sets a property of a game.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param value The new value. It must be in the property's range.
+         */
+        template <enum sf_property P>
+        void setProperty(int file, int game, int value);
+
+        /**
+         * Sets a property of a game, chosen at run time.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param property The property.
+         * @param value The new value. It must be in the property's range.
+         */
+        void setProperty(int file, int game, enum sf_property property,
+                         int value);
+
+        /**
+         * Gets the type of arrows a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The arrow type.
+         */
+        enum sf_arrow getArrows(int file, int game) const;
+
+        /**
+         * Sets the type of arrows a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param arrows The new arrow type.
+         */
+        void setArrows(int file, int game, enum sf_arrow arrows);
+
+        /**
+         * Gets the bomb carrying capacity of a game.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The capacity.
+         */
+        int getBombCapacity(int file, int game) const;
+
+        /**
+         * Sets the bomb carrying capacity of a game.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param capacity The new capacity.
+         */
+        void setBombCapacity(int file, int game, int capacity);
+
+        /**
+         * Gets the number of bombs a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The number of bombs.
+         */
+        int getBombs(int file, int game) const;
+
+        /**
+         * Sets the number of bombs a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param bombs The new number of bombs.
+         */
+        void setBombs(int file, int game, int bombs);
+
+        /**
+         * Gets the type of candle a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The candle type.
+         */
+        enum sf_candle getCandle(int file, int game) const;
+
+        /**
+         * Sets the type of candle a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param candle The new candle type.
+         */
+        void setCandle(int file, int game, enum sf_candle candle);
+
+        /**
+         * Checks if a game has the compass for a level.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param level The level (1-9).
+         *
+         * @return true if it does; false otherwise.
+         */
+        bool hasCompass(int file, int game, int level) const;
+
+        /**
+         * Gives or takes the compass for a level.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param level The level (1-9).
+         * @param give true to give; false to take.
+         */
+        void setCompass(int file, int game, int level, bool give);
+
+        /**
+         * Gets the number of heart containers a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The number of heart containers.
+         */
+        int getHeartContainers(int file, int game) const;
+
+        /**
+         * Sets the number of heart containers a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param containers The new number of heart containers.
+         */
+        void setHeartContainers(int file, int game, int containers);
+
+        /**
+         * Checks if a game has an item.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param item The item.
+         *
+         * @return true if it does; false otherwise.
+         */
+        bool hasItem(int file, int game, enum sf_item item) const;
+
+        /**
+         * Gives or takes an item.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param item The item.
+         * @param give true to give; false to take.
+         */
+        void setItem(int file, int game, enum sf_item item, bool give);
+
+        /**
+         * Gets the number of keys a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The number of keys.
+         */
+        int getKeys(int file, int game) const;
+
+        /**
+         * Sets the number of keys a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param keys The new number of keys.
+         */
+        void setKeys(int file, int game, int keys);
+
+        /**
+         * Checks if a game has the map for a level.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param level The level (1-9).
+         *
+         * @return true if it does; false otherwise.
+         */
+        bool hasMap(int file, int game, int level) const;
+
+        /**
+         * Gives or takes the map for a level.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param level The level (1-9).
+         * @param give true to give; false to take.
+         */
+        void setMap(int file, int game, int level, bool give);
+
+        /**
+         * Gets the name of the hero of a game.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The name.
+         */
+        QString getName(int file, int game) const;
+
+        /**
+         * Gets the name of the hero of a game without allocating.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param buffer Where to store the NAME_DATA_SIZE Latin-1 characters
+         *               of the name. No terminator is written.
+         */
+        void getName(int file, int game, char *buffer) const;
+
+        /**
+         * Sets the name of the hero of a game.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param name The new name.
+         */
+        void setName(int file, int game, const QString &name);
+
+        /**
+         * Gets the location of the potion note in a game.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The location.
+         */
+        enum sf_note getNote(int file, int game) const;
+
+        /**
+         * Sets the location of the potion note in a game.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param note The new location.
+         */
+        void setNote(int file, int game, enum sf_note note);
+
+        /**
+         * Gets the play count of a game.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The play count.
+         */
+        int getPlayCount(int file, int game) const;
+
+        /**
+         * Sets the play count of a game.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param count The new play count.
+         */
+        void setPlayCount(int file, int game, int count);
+
+        /**
+         * Gets the type of potion a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The potion type.
+         */
+        enum sf_potion getPotion(int file, int game) const;
+
+        /**
+         * Sets the type of potion a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param potion The new potion type.
+         */
+        void setPotion(int file, int game, enum sf_potion potion);
+
+        /**
+         * Gets the quest a game is on.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The quest.
+         */
+        enum sf_quest getQuest(int file, int game) const;
+
+        /**
+         * Sets the quest a game is on.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param quest The new quest.
+         */
+        void setQuest(int file, int game, enum sf_quest quest);
+
+        /**
+         * Gets the type of ring a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The ring type.
+         */
+        enum sf_ring getRing(int file, int game) const;
+
+        /**
+         * Sets the type of ring a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param ring The new ring type.
+         */
+        void setRing(int file, int game, enum sf_ring ring);
+
+        /**
+         * Gets the number of rupees a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The number of rupees.
+         */
+        int getRupees(int file, int game) const;
+
+        /**
+         * Sets the number of rupees a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param rupees The new number of rupees.
+         */
+        void setRupees(int file, int game, int rupees);
+
+        /**
+         * Gets the type of sword a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         *
+         * @return The sword type.
+         */
+        enum sf_sword getSword(int file, int game) const;
+
+        /**
+         * Sets the type of sword a game has.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param sword The new sword type.
+         */
+        void setSword(int file, int game, enum sf_sword sword);
+
+        /**
+         * Checks if a game has a piece of the triforce.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param piece The piece (1-8).
+         *
+         * @return true if it does; false otherwise.
+         */
+        bool hasTriforce(int file, int game, int piece) const;
+
+        /**
+         * Gives or takes a piece of the triforce.
+         *
+         * @param file The file.
+         * @param game The game.
+         * @param piece The piece (1-8).
+         * @param give true to give; false to take.
+         */
+        void setTriforce(int file, int game, int piece, bool give);
+    };
+
+    inline const char *SRAMBatch::image(int file) const {
+        Q_ASSERT((file >= 0) && (file < fileCount));
+
+        return (arena + (static_cast<qint64>(file) * SRAM_SIZE));
+    }
+
+    inline int SRAMBatch::getCount() const {
+        return fileCount;
+    }
+
+    inline bool SRAMBatch::isValid(int file, int game) const {
+        Q_ASSERT((file >= 0) && (file < fileCount));
+        Q_ASSERT((game >= 0) && (game <= 2));
+
+        return (valid[file] & (1 << game));
+    }
+
+    template <typename Visitor>
+    inline void SRAMBatch::forEach(Visitor visit) const {
+        for (int file = 0; file < fileCount; ++file) {
+            const int games = valid[file];
+
+            for (int game = 0; game < 3; ++game) {
+                if (games & (1 << game)) {
+                    visit(file, game);
+                }
+            }
+        }
+    }
+
+    template <typename Predicate>
+    inline qint64 SRAMBatch::count(Predicate match) const {
+        qint64 matches = 0;
+
+        forEach([&matches, &match](int file, int game) {
+            matches += (match(file, game) ? 1 : 0);
+        });
+
+        return matches;
+    }
+
+    inline MapState SRAMBatch::getMapState(int file, int game) const {
+        Q_ASSERT(isValid(file, game));
+
+        return MapState(image(file), game);
+    }
+
+    template <enum sf_property P>
+    inline int SRAMBatch::getProperty(int file, int game) const {
+        Q_ASSERT(isValid(file, game));
+
+        return readProperty<P>(image(file), game);
+    }
+
+    inline int SRAMBatch::getProperty(int file, int game,
+                                      enum sf_property property) const {
+        Q_ASSERT(isValid(file, game));
+
+        return readProperty(image(file), game, SRAM_PROPERTIES[property]);
+    }
+
+    template <enum sf_property P>
+    inline void SRAMBatch::setProperty(int file, int game, int value) {
+        Q_ASSERT(isPropertyInRange(SRAM_PROPERTIES[P], value));
+
+        setByte(file, game, getPropertyOffset(SRAM_PROPERTIES[P], game),
+                mergeProperty<P>(image(file), game, value));
+    }
+
+    inline enum sf_arrow SRAMBatch::getArrows(int file, int game) const {
+        return static_cast<enum sf_arrow>(
+            getProperty<PROPERTY_ARROWS>(file, game));
+    }
+
+    inline int SRAMBatch::getBombCapacity(int file, int game) const {
+        return getProperty<PROPERTY_BOMBCAPACITY>(file, game);
+    }
+
+    inline int SRAMBatch::getBombs(int file, int game) const {
+        return getProperty<PROPERTY_BOMBS>(file, game);
+    }
+
+    inline enum sf_candle SRAMBatch::getCandle(int file, int game) const {
+        return static_cast<enum sf_candle>(
+            getProperty<PROPERTY_CANDLE>(file, game));
+    }
+
+    inline bool SRAMBatch::hasCompass(int file, int game, int level) const {
+        Q_ASSERT((level >= 1) && (level <= 9));
+
+        if (level == 9) {
+            return (getProperty<PROPERTY_COMPASS9>(file, game) == 1);
+        }
+
+        return (getProperty<PROPERTY_COMPASSES>(file, game)
+                & (1 << (level - 1)));
+    }
+
+    inline int SRAMBatch::getHeartContainers(int file, int game) const {
+        return getProperty<PROPERTY_HEARTCONTAINERS>(file, game);
+    }
+
+    inline bool SRAMBatch::hasItem(int file, int game,
+                                   enum sf_item item) const {
+        return (getProperty(file, game, getItemProperty(item)) == 1);
+    }
+
+    inline int SRAMBatch::getKeys(int file, int game) const {
+        return getProperty<PROPERTY_KEYS>(file, game);
+    }
+
+    inline bool SRAMBatch::hasMap(int file, int game, int level) const {
+        Q_ASSERT((level >= 1) && (level <= 9));
+
+        if (level == 9) {
+            return (getProperty<PROPERTY_MAP9>(file, game) == 1);
+        }
+
+        return (getProperty<PROPERTY_MAPS>(file, game) & (1 << (level - 1)));
+    }
+
+    inline void SRAMBatch::getName(int file, int game, char *buffer) const {
+        Q_ASSERT(isValid(file, game));
+
+        decodeName(image(file) + NAME_DATA + (game * NAME_DATA_SIZE),
+                   NAME_DATA_SIZE, buffer);
+    }
+
+    inline enum sf_note SRAMBatch::getNote(int file, int game) const {
+        return static_cast<enum sf_note>(
+            getProperty<PROPERTY_NOTE>(file, game));
+    }
+
+    inline int SRAMBatch::getPlayCount(int file, int game) const {
+        return getProperty<PROPERTY_PLAYCOUNT>(file, game);
+    }
+
+    inline enum sf_potion SRAMBatch::getPotion(int file, int game) const {
+        return static_cast<enum sf_potion>(
+            getProperty<PROPERTY_POTION>(file, game));
+    }
+
+    inline enum sf_quest SRAMBatch::getQuest(int file, int game) const {
+        return static_cast<enum sf_quest>(
+            getProperty<PROPERTY_QUEST>(file, game));
+    }
+
+    inline enum sf_ring SRAMBatch::getRing(int file, int game) const {
+        return static_cast<enum sf_ring>(
+            getProperty<PROPERTY_RING>(file, game));
+    }
+
+    inline int SRAMBatch::getRupees(int file, int game) const {
+        return getProperty<PROPERTY_RUPEES>(file, game);
+    }
+
+    inline enum sf_sword SRAMBatch::getSword(int file, int game) const {
+        return static_cast<enum sf_sword>(
+            getProperty<PROPERTY_SWORD>(file, game));
+    }
+
+    inline bool SRAMBatch::hasTriforce(int file, int game, int piece) const {
+        Q_ASSERT((piece >= 1) && (piece <= 8));
+
+        return (getProperty<PROPERTY_TRIFORCE>(file, game)
+                & (1 << (piece - 1)));
+    }
+}  // namespace lozsrame
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <iterator>
+
+#include <QFile>
+
+#ifdef Q_OS_WIN
+    #include <windows.h>
+#else
+    #include <sys/stat.h>
+#endif
+
+#include "model/sramcache.hh"
+
+using namespace lozsrame;
+
+SRAMCache::SRAMCache(int capacity)
+    : capacity(qMax(capacity, 1)), hits(0), misses(0) {}
+
+auto SRAMCache::identify(const QString &filename) -> SRAMCacheKey {
+    SRAMCacheKey key;
+
+#ifdef Q_OS_WIN
+    const HANDLE file = CreateFileW(
+        reinterpret_cast<const wchar_t *>(filename.utf16()),
+        FILE_READ_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        throw InvalidSRAMFileException(ISFE_FILENOTFOUND);
+    }
+
+    BY_HANDLE_FILE_INFORMATION info;
+    const bool                 found = GetFileInformationByHandle(file, &info);
+
+    CloseHandle(file);
+
+    if (!found) {
+        throw InvalidSRAMFileException(ISFE_FILENOTFOUND);
+    }
+
+    key.device   = info.dwVolumeSerialNumber;
+    key.inode    = (static_cast<quint64>(info.nFileIndexHigh) << 32)
+                | info.nFileIndexLow;
+    key.modified = (static_cast<qint64>(info.ftLastWriteTime.dwHighDateTime)
+                    << 32)
+                   | info.ftLastWriteTime.dwLowDateTime;
+    key.size     = (static_cast<qint64>(info.nFileSizeHigh) << 32)
+               | info.nFileSizeLow;
+#else
+    struct stat info;
+
+    if (stat(QFile::encodeName(filename).constData(), &info) != 0) {
+        throw InvalidSRAMFileException(ISFE_FILENOTFOUND);
+    }
+
+    key.device = static_cast<quint64>(info.st_dev);
+    key.inode  = static_cast<quint64>(info.st_ino);
+    key.size   = static_cast<qint64>(info.st_size);
+
+    // to the nanosecond where the system keeps it, so a file rewritten
+    // within the same second still looks changed
+    #if defined(Q_OS_LINUX)
+    key.modified = (static_cast<qint64>(info.st_mtim.tv_sec) * 1000000000)
+                   + info.st_mtim.tv_nsec;
+    #elif defined(Q_OS_DARWIN)
+    key.modified =
+        (static_cast<qint64>(info.st_mtimespec.tv_sec) * 1000000000)
+        + info.st_mtimespec.tv_nsec;
+    #else
+    key.modified = static_cast<qint64>(info.st_mtime) * 1000000000;
+    #endif
+#endif
+
+    return key;
+}
+
+void SRAMCache::drop(std::list<Entry>::iterator entry) {
+    index.remove(entry->key);
+
+    // the path may have been cached again under a newer identity
+    if (paths.value(entry->filename) == entry->key) {
+        paths.remove(entry->filename);
+    }
+
+    entries.erase(entry);
+}
+
+auto SRAMCache::find(const QString &filename) -> SRAMFile * {
+    const SRAMCacheKey key   = identify(filename);
+    const auto         found = index.constFind(key);
+
+    if (found != index.constEnd()) {
+        ++hits;
+        entries.splice(entries.begin(), entries, found.value());
+
+        return &entries.front().sram;
+    }
+
+    ++misses;
+
+    // the file changed since it was cached, so its old copy is useless
+    const auto previous = paths.constFind(filename);
+
+    if (previous != paths.constEnd()) {
+        drop(index.value(previous.value()));
+    }
+
+    return nullptr;
+}
+
+auto SRAMCache::insert(const QString &filename, const SRAMCacheKey &key,
+                       const SRAMFile &sram) -> SRAMFile & {
+    const auto found = index.constFind(key);
+
+    if (found != index.constEnd()) {
+        drop(found.value());
+    }
+
+    const auto previous = paths.constFind(filename);
+
+    if (previous != paths.constEnd()) {
+        drop(index.value(previous.value()));
+    }
+
+    entries.push_front({filename, key, sram});
+    index.insert(key, entries.begin());
+    paths.insert(filename, key);
+
+    if (index.size() > capacity) {
+        drop(std::prev(entries.end()));
+    }
+
+    return entries.front().sram;
+}
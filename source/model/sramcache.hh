@@ -0,0 +1,201 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_SRAMCACHE_HH_
+#define LOZSRAME_SRAMCACHE_HH_
+
+#include <list>
+
+#include <QHash>
+#include <QString>
+
+#include "model/sramfile.hh"
+
+namespace lozsrame {
+    /**
+     * What identifies the contents of a file without reading it. A file
+     * rewritten in place gets a new modification time, and one replaced by
+     * renaming another over it gets a new inode.
+     */
+    struct SRAMCacheKey {
+        quint64 device, inode;
+        qint64  modified, size;
+    };
+
+    /**
+     * Compares two keys.
+     *
+     * @param a The first key.
+     * @param b The second key.
+     *
+     * @return true if they are the same; false otherwise.
+     */
+    bool operator==(const SRAMCacheKey &a, const SRAMCacheKey &b);
+
+    /**
+     * Hashes a key, for QHash.
+     *
+     * @param key The key.
+     * @param seed The QHash seed.
+     *
+     * @return The hash of the key.
+     */
+    uint qHash(const SRAMCacheKey &key, uint seed = 0);
+
+    /**
+     * A cache of loaded SRAM files, keyed by the identity of the file on
+     * disk rather than its path. Looking a file up costs one stat; it is
+     * only read and checksummed again once it has changed, which drops the
+     * copy cached for the old identity. When the cache is full, the file
+     * used least recently is dropped.
+     *
+     * The cache only holds files; reading them is left to the caller, so it
+     * can happen on another thread. An SRAMCache is not thread safe.
+     */
+    class SRAMCache {
+      private:
+        /// a cached file
+        struct Entry {
+            QString      filename;
+            SRAMCacheKey key;
+            SRAMFile     sram;
+        };
+
+        std::list<Entry>                                 entries;
+        QHash<SRAMCacheKey, std::list<Entry>::iterator> index;
+        QHash<QString, SRAMCacheKey>                     paths;
+        int                                              capacity;
+        qint64                                           hits, misses;
+
+        /**
+         * Removes a file from the cache.
+         *
+         * @param entry The file.
+         */
+        void drop(std::list<Entry>::iterator entry);
+
+      public:
+        /**
+         * Creates a new, empty SRAMCache.
+         *
+         * @param capacity The most files to keep.
+         */
+        explicit SRAMCache(int capacity);
+
+        SRAMCache(const SRAMCache &) = delete;
+        SRAMCache &operator=(const SRAMCache &) = delete;
+
+        /**
+         * Identifies a file as it is on disk now.
+         *
+         * @param filename The filename.
+         *
+         * @return The key.
+         *
+         * @throw InvalidSRAMFileException if the file can't be found.
+         */
+        static SRAMCacheKey identify(const QString &filename);
+
+        /**
+         * Looks up a file in the cache, provided it hasn't changed since it
+         * was cached. A changed file is dropped.
+         *
+         * @param filename The SRAM filename.
+         *
+         * @return The SRAM file, valid until the cache is next changed, or
+         *         nullptr if the file isn't cached.
+         *
+         * @throw InvalidSRAMFileException if the file can't be found.
+         */
+        SRAMFile *find(const QString &filename);
+
+        /**
+         * Caches a file, replacing any copy cached under the same name or
+         * identity. The file should be identified before it is read, so a
+         * change made while reading it is noticed by the next find().
+         *
+         * @param filename The SRAM filename.
+         * @param key The identity of the file when it was read.
+         * @param sram The SRAM file.
+         *
+         * @return The cached SRAM file, valid until the cache is next
+         *         changed.
+         */
+        SRAMFile &insert(const QString &filename, const SRAMCacheKey &key,
+                         const SRAMFile &sram);
+
+        /**
+         * Gets the number of files cached.
+         *
+         * @return The number of files.
+         */
+        int getCount() const;
+
+        /**
+         * Gets the most files the cache keeps.
+         *
+         * @return The number of files.
+         */
+        int getCapacity() const;
+
+        /**
+         * Gets the number of loads answered from the cache.
+         *
+         * @return The number of loads.
+         */
+        qint64 getHits() const;
+
+        /**
+         * Gets the number of loads that had to read the file.
+         *
+         * @return The number of loads.
+         */
+        qint64 getMisses() const;
+    };
+
+    inline bool operator==(const SRAMCacheKey &a, const SRAMCacheKey &b) {
+        return (a.inode == b.inode) && (a.modified == b.modified)
+               && (a.device == b.device) && (a.size == b.size);
+    }
+
+    inline uint qHash(const SRAMCacheKey &key, uint seed) {
+        return ::qHash(key.inode ^ (key.device << 32), seed)
+               ^ ::qHash(key.modified, seed);
+    }
+
+    inline int SRAMCache::getCount() const {
+        return static_cast<int>(index.size());
+    }
+
+    inline int SRAMCache::getCapacity() const {
+        return capacity;
+    }
+
+    inline qint64 SRAMCache::getHits() const {
+        return hits;
+    }
+
+    inline qint64 SRAMCache::getMisses() const {
+        return misses;
+    }
+}  // namespace lozsrame
+
+#endif
@@ -22,53 +22,107 @@
 #include <cstring>
 #include <fstream>
 
+#include <QFile>
+#include <QFileInfo>
 #include <QtCore/qendian.h>
 
+#include "model/checksum.hh"
+#include "model/filesync.hh"
+#include "model/mapstate.hh"
+#include "model/namecodec.hh"
 #include "model/sramfile.hh"
+#include "model/sramstats.hh"
 
 using namespace lozsrame;
 
-SRAMFile::SRAMFile(const QString &filename) : modified(false) {
-    std::ifstream file(filename.toLatin1().data(),
-                       std::ios_base::in | std::ios_base::binary);
+namespace {
+    /**
+     * Counts a file that failed to load, then throws the failure.
+     *
+     * @param error The reason it failed.
+     *
+     * @throw InvalidSRAMFileException always.
+     */
+    [[noreturn]] void fail(enum isfe_error error) {
+        SRAMStats::countFailure(error);
+
+        throw InvalidSRAMFileException(error);
+    }
 
-    if (!file) {
-        throw InvalidSRAMFileException(ISFE_FILENOTFOUND);
+    /// the dirty field bits of the fields held by each byte, in any game
+    struct FieldTable {
+        quint64 fields[SRAM_SIZE];
+    };
+
+    /**
+     * Builds the table of the fields held by each byte.
+     *
+     * @return The table.
+     */
+    constexpr FieldTable makeFieldTable() {
+        FieldTable table = {};
+
+        for (int offset = NAME_DATA; offset < NAME_DATA + (3 * NAME_DATA_SIZE);
+             ++offset) {
+            table.fields[offset] = DIRTY_NAME;
+        }
+
+        for (const PropertyDescriptor &property : SRAM_PROPERTIES) {
+            for (int game = 0; game < 3; ++game) {
+                table.fields[getPropertyOffset(property, game)] |=
+                    getDirtyBit(property.property);
+            }
+        }
+
+        return table;
     }
 
-    file.seekg(0, std::ios_base::end);
+    constexpr FieldTable FIELD_TABLE = makeFieldTable();
+}  // namespace
 
-    if (file.tellg() != static_cast<std::streampos>(SRAM_SIZE)) {
-        throw InvalidSRAMFileException(ISFE_INVALIDSIZE);
+auto lozsrame::findProperty(const char *name) -> enum sf_property {
+    for (const PropertyDescriptor &property : SRAM_PROPERTIES) {
+        if (std::strcmp(property.name, name) == 0) {
+            return property.property;
+        }
     }
 
-    file.seekg(0, std::ios_base::beg);
-    file.read(sram, SRAM_SIZE);
-    file.close();
+    return PROPERTY_COUNT;
+}
 
-    // checksum to determine valid games
-    std::memset(valid, 0, 3 * sizeof(bool));
+SRAMFile::SRAMFile()
+    : mapping(nullptr), step(0), cleanStep(0), dirty(DIRTY_ALL) {}
 
-    bool    foundValid = false;
-    QString emptyName("        ");
+SRAMFile::SRAMFile(const QString &filename, enum sf_loadmode mode)
+    : SRAMFile() {
+    const qint64 start = SRAMStats::startTimer(HISTOGRAM_OPEN);
 
-    for (int game = 2; game >= 0; --game) {
-        if (checksum(game) == getChecksum(game)) {
-            valid[game] = true;
-            setGame(game);
-
-            if (getName() == emptyName) {
-                // empty slot
-                valid[game] = false;
-            } else {
-                foundValid = true;
-            }
+    SRAMStats::count(COUNTER_OPENS);
+
+    if (mode == LOAD_MAP) {
+        map(filename);
+    } else {
+        std::ifstream file(filename.toLatin1().data(),
+                           std::ios_base::in | std::ios_base::binary);
+
+        if (!file) {
+            fail(ISFE_FILENOTFOUND);
         }
-    }
 
-    if (!foundValid) {
-        throw InvalidSRAMFileException(ISFE_NOVALIDGAMES);
+        file.seekg(0, std::ios_base::end);
+
+        if (file.tellg() != static_cast<std::streampos>(SRAM_SIZE)) {
+            fail(ISFE_INVALIDSIZE);
+        }
+
+        file.seekg(0, std::ios_base::beg);
+        file.read(sram, SRAM_SIZE);
+        file.close();
     }
+
+    SRAMStats::count(COUNTER_BYTESREAD, SRAM_SIZE);
+    validate();
+    SRAMStats::record(HISTOGRAM_OPEN, start);
 }
 
 /*
@@ -134,42 +188,371 @@ SRAMFile::SRAMFile(const QString &filename) : modified(false) {
 auto SRAMFile::checksum(int game) const -> quint16 {
     Q_ASSERT((game >= 0) && (game < 3));
 
-    quint16 checksum = 0;
+    // see checksum.cc for the scalar and vectorized kernels
+    return slotChecksum(image(), game);
+}
 
-    // name data
-    for (int i = 0; i < NAME_DATA_SIZE; ++i) {
-        checksum += static_cast<unsigned char>(
-            sram[NAME_DATA + i + (game * NAME_DATA_SIZE)]);
+void SRAMFile::detach() {
+    if (mapping) {
+        std::memcpy(sram, mapping, SRAM_SIZE);
+        mapping = nullptr;
+        mappedFile.reset();
     }
+}
 
-    // inventory data
-    for (int i = 0; i < INVENTORY_DATA_SIZE; ++i) {
-        checksum += static_cast<unsigned char>(
-            sram[INVENTORY_DATA + i + (game * INVENTORY_DATA_SIZE)]);
+auto SRAMFile::fromData(const char *data, qint64 size) -> SRAMFile {
+    if (size != SRAM_SIZE) {
+        fail(ISFE_INVALIDSIZE);
     }
 
-    // map data
-    for (int i = 0; i < MAP_DATA_SIZE; ++i) {
-        checksum += static_cast<unsigned char>(
-            sram[MAP_DATA + i + (game * MAP_DATA_SIZE)]);
+    SRAMFile sram;
+
+    std::memcpy(sram.sram, data, SRAM_SIZE);
+    sram.validate();
+
+    return sram;
+}
+
+auto SRAMFile::fromData(const char *data, qint64 size,
+                        const SRAMValidation &validation) -> SRAMFile {
+    if (size != SRAM_SIZE) {
+        fail(ISFE_INVALIDSIZE);
     }
 
-    // misc data (0x512, 0x515, 0x518, 0x51B)
-    for (int i = 0; i < MISC_DATA_SIZE; ++i) {
-        checksum +=
-            static_cast<unsigned char>(sram[MISC_DATA + (i * 3) + game]);
+    SRAMFile sram;
+
+    std::memcpy(sram.sram, data, SRAM_SIZE);
+    sram.validate(validation);
+
+    return sram;
+}
+
+auto SRAMFile::getValidation() const -> SRAMValidation {
+    SRAMValidation validation;
+
+    for (int game = 0; game < 3; ++game) {
+        validation.sums[game]  = sums[game];
+        validation.valid[game] = valid[game];
     }
 
-    return checksum;
+    return validation;
 }
 
-auto SRAMFile::save(const QString &filename) -> bool {
-    for (int i = 0; i < 3; ++i) {
-        if (isValid(i)) {
-            setChecksum(i, checksum(i));
+auto SRAMFile::validateData(const char *data) -> SRAMValidation {
+    const auto *stored =
+        reinterpret_cast<const quint16 *>(data + CHECKSUM_OFFSET);
+
+    const qint64   start = SRAMStats::startTimer(HISTOGRAM_CHECKSUM);
+    SRAMValidation validation;
+
+    // checksum to determine valid games
+    for (int game = 0; game < 3; ++game) {
+        validation.sums[game]  = slotChecksum(data, game);
+        validation.valid[game] =
+            ((validation.sums[game] == qFromBigEndian(stored[game]))
+             && !isEmpty(data, game));
+    }
+
+    SRAMStats::count(COUNTER_CHECKSUMS, 3);
+    SRAMStats::record(HISTOGRAM_CHECKSUM, start);
+
+    return validation;
+}
+
+auto SRAMFile::isEmpty(const char *data, int game) -> bool {
+    static_assert(NAME_DATA_SIZE == sizeof(quint64), "name is not 64 bits");
+
+    // an empty slot's name is all spaces
+    const quint64 empty = Q_UINT64_C(0x2424242424242424);
+    quint64       name;
+
+    std::memcpy(&name, data + NAME_DATA + (game * NAME_DATA_SIZE),
+                sizeof(name));
+
+    return (name == empty);
+}
+
+void SRAMFile::map(const QString &filename) {
+    QSharedPointer<QFile> file(new QFile(filename));
+
+    if (!file->open(QIODevice::ReadOnly)) {
+        fail(ISFE_FILENOTFOUND);
+    }
+
+    if (file->size() != SRAM_SIZE) {
+        fail(ISFE_INVALIDSIZE);
+    }
+
+    uchar *page = file->map(0, SRAM_SIZE);
+
+    if (page) {
+        mapping    = reinterpret_cast<const char *>(page);
+        mappedFile = file;
+    } else if (file->read(sram, SRAM_SIZE) != SRAM_SIZE) {
+        // some file systems can't be mapped, so fall back to a copy
+        fail(ISFE_INVALIDSIZE);
+    }
+
+    // the mapping outlives the descriptor
+    file->close();
+}
+
+void SRAMFile::setByte(int offset, int value) {
+    const char byte = static_cast<char>(value);
+
+    setBytes(offset, &byte, 1);
+}
+
+void SRAMFile::setBytes(int offset, const char *data, int count) {
+    Q_ASSERT((offset >= 0) && (offset + count <= SRAM_SIZE));
+
+    const char *current = image();
+    int         first   = 0;
+
+    // an edit that changes nothing must leave the redo history alone
+    while ((first < count) && (current[offset + first] == data[first])) {
+        ++first;
+    }
+
+    if (first == count) {
+        return;
+    }
+
+    // a new edit replaces whatever was undone
+    if (step < steps.size()) {
+        journal.resize((step > 0) ? steps[step - 1].end : 0);
+        steps.resize(step);
+
+        if (cleanStep > step) {
+            cleanStep = -1;
         }
     }
 
+    const int start = journal.size();
+
+    for (int i = first; i < count; ++i) {
+        const auto before = static_cast<quint8>(current[offset + i]);
+        const auto after  = static_cast<quint8>(data[i]);
+
+        if (before != after) {
+            journal.append({static_cast<quint16>(offset + i), before, after});
+        }
+    }
+
+    for (int i = start; i < journal.size(); ++i) {
+        writeByte(journal[i].offset, journal[i].after);
+    }
+
+    steps.append({journal.size(), game});
+    ++step;
+}
+
+void SRAMFile::writeByte(int offset, int value) {
+    Q_ASSERT((offset >= 0) && (offset < SRAM_SIZE));
+
+    detach();
+
+    const int slot = slotOf(offset);
+    const int old  = static_cast<unsigned char>(sram[offset]);
+
+    sram[offset] = static_cast<char>(value);
+    dirty       |= getFieldsAt(offset);
+
+    // the checksum is a plain sum, so only the difference matters
+    if (slot >= 0) {
+        sums[slot] += static_cast<unsigned char>(value) - old;
+    }
+}
+
+void SRAMFile::undo() {
+    Q_ASSERT(canUndo());
+
+    const JournalStep &last  = steps[--step];
+    const int          begin = (step > 0) ? steps[step - 1].end : 0;
+
+    for (int i = last.end - 1; i >= begin; --i) {
+        writeByte(journal[i].offset, journal[i].before);
+    }
+
+    if (game != last.game) {
+        game  = last.game;
+        dirty = DIRTY_ALL;
+    }
+}
+
+void SRAMFile::redo() {
+    Q_ASSERT(canRedo());
+
+    const int          begin = (step > 0) ? steps[step - 1].end : 0;
+    const JournalStep &next  = steps[step++];
+
+    for (int i = begin; i < next.end; ++i) {
+        writeByte(journal[i].offset, journal[i].after);
+    }
+
+    if (game != next.game) {
+        game  = next.game;
+        dirty = DIRTY_ALL;
+    }
+}
+
+auto SRAMFile::reload(const char *data) -> int {
+    // block size for skipping the parts that didn't change
+    const int BLOCK_SIZE = 64;
+
+    const SRAMValidation validation = validateData(data);
+
+    if (!validation.valid[0] && !validation.valid[1] && !validation.valid[2]) {
+        fail(ISFE_NOVALIDGAMES);
+    }
+
+    int changed = 0;
+
+    for (int block = 0; block < SRAM_SIZE; block += BLOCK_SIZE) {
+        if (std::memcmp(image() + block, data + block, BLOCK_SIZE) == 0) {
+            continue;
+        }
+
+        for (int offset = block; offset < block + BLOCK_SIZE; ++offset) {
+            if (image()[offset] != data[offset]) {
+                writeByte(offset, static_cast<unsigned char>(data[offset]));
+                ++changed;
+            }
+        }
+    }
+
+    // the undo history still applies if nothing changed
+    if (changed == 0) {
+        return 0;
+    }
+
+    journal.clear();
+    steps.clear();
+    step      = 0;
+    cleanStep = 0;
+
+    for (int game = 0; game < 3; ++game) {
+        sums[game]  = validation.sums[game];
+        valid[game] = validation.valid[game];
+    }
+
+    if (!valid[game]) {
+        game  = (valid[0] ? 0 : (valid[1] ? 1 : 2));
+        dirty = DIRTY_ALL;
+    }
+
+    return changed;
+}
+
+auto SRAMFile::getMapState() const -> MapState {
+    Q_ASSERT(isValid(game));
+
+    return MapState(image(), game);
+}
+
+void SRAMFile::setProperty(enum sf_property property, int value) {
+    Q_ASSERT(isValid(game));
+    Q_ASSERT(isPropertyInRange(SRAM_PROPERTIES[property], value));
+
+    const PropertyDescriptor &descriptor = SRAM_PROPERTIES[property];
+
+    setByte(getPropertyOffset(descriptor, game),
+            mergeProperty(image(), game, descriptor, value));
+}
+
+auto SRAMFile::getFieldsAt(int offset) -> quint64 {
+    Q_ASSERT((offset >= 0) && (offset < SRAM_SIZE));
+
+    return FIELD_TABLE.fields[offset];
+}
+
+auto SRAMFile::slotOf(int offset) -> int {
+    if (offset < NAME_DATA) {
+        return -1;
+    }
+
+    if (offset < INVENTORY_DATA) {
+        return ((offset - NAME_DATA) / NAME_DATA_SIZE);
+    }
+
+    if (offset < MAP_DATA) {
+        return ((offset - INVENTORY_DATA) / INVENTORY_DATA_SIZE);
+    }
+
+    if (offset < MISC_DATA) {
+        return ((offset - MAP_DATA) / MAP_DATA_SIZE);
+    }
+
+    if (offset < (MISC_DATA + (MISC_DATA_SIZE * 3))) {
+        // the misc bytes are interleaved between the games
+        return ((offset - MISC_DATA) % 3);
+    }
+
+    return -1;
+}
+
+void SRAMFile::validate() {
+    validate(validateData(image()));
+}
+
+void SRAMFile::validate(const SRAMValidation &validation) {
+    bool foundValid = false;
+
+    for (int game = 2; game >= 0; --game) {
+        sums[game]  = validation.sums[game];
+        valid[game] = validation.valid[game];
+
+        if (valid[game]) {
+            this->game = game;
+            foundValid = true;
+        }
+    }
+
+    if (!foundValid) {
+        fail(ISFE_NOVALIDGAMES);
+    }
+}
+
+auto SRAMFile::save(const QString &filename, enum sf_savemode mode) -> bool {
+    const qint64 start = SRAMStats::startTimer(HISTOGRAM_SAVE);
+    const bool   saved = ((mode == SAVE_ATOMIC) ? saveAtomic(filename)
+                                                : saveInPlace(filename));
+
+    if (saved) {
+        SRAMStats::count(COUNTER_SAVES);
+        SRAMStats::count(COUNTER_BYTESWRITTEN, SRAM_SIZE);
+        SRAMStats::record(HISTOGRAM_SAVE, start);
+    } else {
+        SRAMStats::count(COUNTER_SAVEFAILURES);
+    }
+
+    return saved;
+}
+
+auto SRAMFile::saveAtomic(const QString &filename) -> bool {
+    // write through symlinks rather than replacing them
+    const QString target    = resolveFile(filename);
+    const QString temporary = writeTemporary(target, toData(), true);
+
+    if (temporary.isEmpty()) {
+        return false;
+    }
+
+    if (!replaceFile(temporary, target)) {
+        QFile::remove(temporary);
+
+        return false;
+    }
+
+    syncDirectory(QFileInfo(target).absolutePath());
+    cleanStep = step;
+
+    return true;
+}
+
+auto SRAMFile::saveInPlace(const QString &filename) -> bool {
+    updateChecksums();
+
     std::ofstream file(filename.toLatin1().data(),
                        std::ios_base::out | std::ios_base::binary);
 
@@ -184,85 +567,54 @@ auto SRAMFile::save(const QString &filename) -> bool {
     }
 
     file.close();
-    modified = false;
+    cleanStep = step;
 
     return true;
 }
 
-auto SRAMFile::getArrows() const -> enum sf_arrow {
-    Q_ASSERT(isValid(game));
+auto SRAMFile::toData() -> QByteArray {
+    updateChecksums();
 
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
+    return QByteArray(image(), SRAM_SIZE);
+}
 
-    return static_cast<enum sf_arrow>(ptr[ARROWS_OFFSET]);
+auto SRAMFile::getArrows() const -> enum sf_arrow {
+    return static_cast<enum sf_arrow>(getProperty<PROPERTY_ARROWS>());
 }
 
 void SRAMFile::setArrows(sf_arrow arrows) {
-    Q_ASSERT(isValid(game));
-
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    ptr[ARROWS_OFFSET] = arrows;
-    modified           = true;
+    setProperty<PROPERTY_ARROWS>(arrows);
 }
 
 auto SRAMFile::getBombCapacity() const -> int {
-    Q_ASSERT(isValid(game));
-
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    return ptr[BOMBCAPACITY_OFFSET];
+    return getProperty<PROPERTY_BOMBCAPACITY>();
 }
 
 void SRAMFile::setBombCapacity(int capacity) {
-    Q_ASSERT(isValid(game));
-    Q_ASSERT((capacity >= 0) && (capacity <= 16));
-
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    ptr[BOMBCAPACITY_OFFSET] = capacity;
-    modified                 = true;
+    setProperty<PROPERTY_BOMBCAPACITY>(capacity);
 }
 
 auto SRAMFile::getBombs() const -> int {
-    Q_ASSERT(isValid(game));
-
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    return ptr[BOMBS_OFFSET];
+    return getProperty<PROPERTY_BOMBS>();
 }
 
 void SRAMFile::setBombs(int bombs) {
-    Q_ASSERT(isValid(game));
-    Q_ASSERT((bombs >= 0) && (bombs <= 16));
-
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    ptr[BOMBS_OFFSET] = bombs;
-    modified          = true;
+    setProperty<PROPERTY_BOMBS>(bombs);
 }
 
 auto SRAMFile::getCandle() const -> enum sf_candle {
-    Q_ASSERT(isValid(game));
-
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    return static_cast<enum sf_candle>(ptr[CANDLE_OFFSET]);
+    return static_cast<enum sf_candle>(getProperty<PROPERTY_CANDLE>());
 }
 
 void SRAMFile::setCandle(enum sf_candle candle) {
-    Q_ASSERT(isValid(game));
-
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    ptr[CANDLE_OFFSET] = candle;
-    modified           = true;
+    setProperty<PROPERTY_CANDLE>(candle);
 }
 
 auto SRAMFile::getChecksum(int game) const -> quint16 {
     Q_ASSERT((game >= 0) && (game < 3));
 
-    const auto *ptr = reinterpret_cast<const quint16 *>(sram + CHECKSUM_OFFSET);
+    const auto *ptr =
+        reinterpret_cast<const quint16 *>(image() + CHECKSUM_OFFSET);
 
     return qFromBigEndian(ptr[game]);
 }
@@ -270,358 +622,197 @@ auto SRAMFile::getChecksum(int game) const -> quint16 {
 void SRAMFile::setChecksum(int game, quint16 checksum) {
     Q_ASSERT((game >= 0) && (game < 3));
 
+    detach();
+
     auto *ptr = reinterpret_cast<quint16 *>(sram + CHECKSUM_OFFSET);
 
     ptr[game] = qToBigEndian(checksum);
 }
 
+void SRAMFile::updateChecksums() {
+    for (int i = 0; i < 3; ++i) {
+        if (isValid(i)) {
+            Q_ASSERT(sums[i] == checksum(i));
+
+            setChecksum(i, sums[i]);
+        }
+    }
+}
+
 auto SRAMFile::hasCompass(int level) const -> bool {
-    Q_ASSERT(isValid(game));
     Q_ASSERT((level >= 1) && (level <= 9));
 
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
     if (level == 9) {
-        return (ptr[COMPASS9_OFFSET] == 1);
+        return (getProperty<PROPERTY_COMPASS9>() == 1);
     }
 
-    return (ptr[COMPASS_OFFSET] & (1 << (level - 1)));
+    return (getProperty<PROPERTY_COMPASSES>() & (1 << (level - 1)));
 }
 
 void SRAMFile::setCompass(int level, bool give) {
-    Q_ASSERT(isValid(game));
     Q_ASSERT((level >= 1) && (level <= 9));
 
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
     if (level == 9) {
-        ptr[COMPASS9_OFFSET] = (give ? 1 : 0);
-    }
+        setProperty<PROPERTY_COMPASS9>(give ? 1 : 0);
 
-    if (give) {
-        ptr[COMPASS_OFFSET] |= (1 << (level - 1));
-    } else {
-        ptr[COMPASS_OFFSET] &= ~(1 << (level - 1));
+        return;
     }
 
-    modified = true;
+    const int bit  = (1 << (level - 1));
+    const int bits = getProperty<PROPERTY_COMPASSES>();
+
+    setProperty<PROPERTY_COMPASSES>(give ? (bits | bit) : (bits & ~bit));
 }
 
 auto SRAMFile::getHeartContainers() const -> int {
-    Q_ASSERT(isValid(game));
-
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    return ((static_cast<unsigned char>(ptr[HEARTCONTAINERS_OFFSET]) >> 4) + 1);
+    return getProperty<PROPERTY_HEARTCONTAINERS>();
 }
 
 void SRAMFile::setHeartContainers(int containers) {
-    Q_ASSERT(isValid(game));
-    Q_ASSERT((containers > 0) && (containers <= 16));
-
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    ptr[HEARTCONTAINERS_OFFSET] &= 0x0F;
-    ptr[HEARTCONTAINERS_OFFSET] |= ((containers - 1) << 4);
-    modified = true;
+    setProperty<PROPERTY_HEARTCONTAINERS>(containers);
 }
 
 auto SRAMFile::hasItem(enum sf_item item) const -> bool {
-    Q_ASSERT(isValid(game));
-
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    return (ptr[item] == 1);
+    return (getProperty(getItemProperty(item)) == 1);
 }
 
 void SRAMFile::setItem(enum sf_item item, bool give) {
-    Q_ASSERT(isValid(game));
-
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    ptr[item] = (give ? 1 : 0);
-    modified  = true;
+    setProperty(getItemProperty(item), (give ? 1 : 0));
 }
 
 auto SRAMFile::getKeys() const -> int {
-    Q_ASSERT(isValid(game));
-
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    return ptr[KEYS_OFFSET];
+    return getProperty<PROPERTY_KEYS>();
 }
 
 void SRAMFile::setKeys(int keys) {
-    Q_ASSERT(isValid(game));
-    Q_ASSERT((keys >= 0) && (keys <= 99));
-
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    ptr[KEYS_OFFSET] = keys;
-    modified         = true;
+    setProperty<PROPERTY_KEYS>(keys);
 }
 
 auto SRAMFile::hasMap(int level) const -> bool {
-    Q_ASSERT(isValid(game));
     Q_ASSERT((level >= 1) && (level <= 9));
 
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
     if (level == 9) {
-        return (ptr[MAP9_OFFSET] == 1);
+        return (getProperty<PROPERTY_MAP9>() == 1);
     }
 
-    return (ptr[MAP_OFFSET] & (1 << (level - 1)));
+    return (getProperty<PROPERTY_MAPS>() & (1 << (level - 1)));
 }
 
 void SRAMFile::setMap(int level, bool give) {
-    Q_ASSERT(isValid(game));
     Q_ASSERT((level >= 1) && (level <= 9));
 
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
     if (level == 9) {
-        ptr[MAP9_OFFSET] = (give ? 1 : 0);
-    }
+        setProperty<PROPERTY_MAP9>(give ? 1 : 0);
 
-    if (give) {
-        ptr[MAP_OFFSET] |= (1 << (level - 1));
-    } else {
-        ptr[MAP_OFFSET] &= ~(1 << (level - 1));
+        return;
     }
 
-    modified = true;
+    const int bit  = (1 << (level - 1));
+    const int bits = getProperty<PROPERTY_MAPS>();
+
+    setProperty<PROPERTY_MAPS>(give ? (bits | bit) : (bits & ~bit));
 }
 
 auto SRAMFile::getName() const -> QString {
-    Q_ASSERT(isValid(game));
+    char name[NAME_DATA_SIZE];
 
-    QString     name;
-    const char *ptr = (sram + NAME_DATA + (game * NAME_DATA_SIZE));
-
-    for (int i = 0; i < NAME_DATA_SIZE; ++i) {
-        char ch = ptr[i];
-
-        if ((ch >= 0) && (ch <= 9)) {
-            name += ('0' + ch);
-        } else if ((ch >= 0xA) && (ch <= 0x23)) {
-            name += ('A' + ch - 0xA);
-        } else if (ch == 0x24) {
-            name += ' ';
-        } else if (ch == 0x28) {
-            name += ',';
-        } else if (ch == 0x29) {
-            name += '!';
-        } else if (ch == 0x2A) {
-            name += '\'';
-        } else if (ch == 0x2B) {
-            name += '&';
-        } else if (ch == 0x2C) {
-            name += '.';
-        } else if (ch == 0x2D) {
-            name += '\"';
-        } else if (ch == 0x2E) {
-            name += '?';
-        } else if (ch == 0x2F) {
-            name += '_';
-        } else {
-            // invalid character
-            Q_ASSERT(false);
-        }
-    }
+    getName(name);
 
-    return name;
+    return QString::fromLatin1(name, NAME_DATA_SIZE);
+}
+
+void SRAMFile::getName(char *buffer) const {
+    Q_ASSERT(isValid(game));
+
+    decodeName(image() + NAME_DATA + (game * NAME_DATA_SIZE), NAME_DATA_SIZE,
+               buffer);
 }
 
 void SRAMFile::setName(const QString &name) {
     Q_ASSERT(isValid(game));
 
-    char *ptr = (sram + NAME_DATA + (game * NAME_DATA_SIZE));
-
-    for (int count = 0; count < 8; ++count) {
-        if (name.length() > count) {
-            char ch = name[count].toLatin1();
-
-            if ((ch >= '0') && (ch <= '9')) {
-                ptr[count] = (ch - '0');
-            } else if ((ch >= 'A') && (ch <= 'Z')) {
-                ptr[count] = (ch - 'A' + 0xA);
-            } else if (ch == ' ') {
-                ptr[count] = 0x24;
-            } else if (ch == ',') {
-                ptr[count] = 0x28;
-            } else if (ch == '!') {
-                ptr[count] = 0x29;
-            } else if (ch == '\'') {
-                ptr[count] = 0x2A;
-            } else if (ch == '&') {
-                ptr[count] = 0x2B;
-            } else if (ch == '.') {
-                ptr[count] = 0x2C;
-            } else if (ch == '\"') {
-                ptr[count] = 0x2D;
-            } else if (ch == '?') {
-                ptr[count] = 0x2E;
-            } else if (ch == '_') {
-                ptr[count] = 0x2F;
-            } else {
-                Q_ASSERT(false);
-            }
-        } else {
-            // pad with spaces
-            ptr[count] = 0x24;
-        }
+    const int offset = NAME_DATA + (game * NAME_DATA_SIZE);
+    const int length = qMin(name.length(), NAME_DATA_SIZE);
+    char      text[NAME_DATA_SIZE], raw[NAME_DATA_SIZE];
+
+    // pad with spaces
+    std::memset(text, ' ', NAME_DATA_SIZE);
+
+    for (int i = 0; i < length; ++i) {
+        text[i] = name[i].toLatin1();
     }
 
-    modified = true;
+    encodeName(text, NAME_DATA_SIZE, raw);
+    setBytes(offset, raw, NAME_DATA_SIZE);
 }
 
 auto SRAMFile::getNote() const -> enum sf_note {
-    Q_ASSERT(isValid(game));
-
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    return static_cast<enum sf_note>(ptr[NOTE_OFFSET]);
+    return static_cast<enum sf_note>(getProperty<PROPERTY_NOTE>());
 }
 
 void SRAMFile::setNote(enum sf_note note) {
-    Q_ASSERT(isValid(game));
-
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    ptr[NOTE_OFFSET] = note;
-    modified         = true;
+    setProperty<PROPERTY_NOTE>(note);
 }
 
 auto SRAMFile::getPlayCount() const -> int {
-    Q_ASSERT(isValid(game));
-
-    const unsigned char *ptr = (reinterpret_cast<const unsigned char *>(sram)
-                                + MISC_DATA + PLAYCOUNT_OFFSET);
-
-    return ptr[game];
+    return getProperty<PROPERTY_PLAYCOUNT>();
 }
 
 void SRAMFile::setPlayCount(int count) {
-    Q_ASSERT(isValid(game));
-    Q_ASSERT((count >= 0) && (count <= 255));
-
-    unsigned char *ptr = (reinterpret_cast<unsigned char *>(sram) + MISC_DATA
-                          + PLAYCOUNT_OFFSET);
-
-    ptr[game] = count;
-    modified  = true;
+    setProperty<PROPERTY_PLAYCOUNT>(count);
 }
 
 auto SRAMFile::getPotion() const -> enum sf_potion {
-    Q_ASSERT(isValid(game));
-
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    return static_cast<sf_potion>(ptr[POTION_OFFSET]);
+    return static_cast<enum sf_potion>(getProperty<PROPERTY_POTION>());
 }
 
 void SRAMFile::setPotion(enum sf_potion potion) {
-    Q_ASSERT(isValid(game));
-
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    ptr[POTION_OFFSET] = potion;
-    modified           = true;
+    setProperty<PROPERTY_POTION>(potion);
 }
 
 auto SRAMFile::getQuest() const -> enum sf_quest {
-    Q_ASSERT(isValid(game));
-
-    const char *ptr = (sram + MISC_DATA + QUEST_OFFSET);
-
-    return static_cast<enum sf_quest>(ptr[game]);
+    return static_cast<enum sf_quest>(getProperty<PROPERTY_QUEST>());
 }
 
 void SRAMFile::setQuest(enum sf_quest quest) {
-    Q_ASSERT(isValid(game));
-
-    char *ptr = (sram + MISC_DATA + QUEST_OFFSET);
-
-    ptr[game] = quest;
-    modified  = true;
+    setProperty<PROPERTY_QUEST>(quest);
 }
 
 auto SRAMFile::getRing() const -> enum sf_ring {
-    Q_ASSERT(isValid(game));
-
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    return static_cast<enum sf_ring>(ptr[RING_OFFSET]);
+    return static_cast<enum sf_ring>(getProperty<PROPERTY_RING>());
 }
 
 void SRAMFile::setRing(enum sf_ring ring) {
-    Q_ASSERT(isValid(game));
-
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    ptr[RING_OFFSET] = ring;
-    modified         = true;
+    setProperty<PROPERTY_RING>(ring);
 }
 
 auto SRAMFile::getRupees() const -> int {
-    Q_ASSERT(isValid(game));
-
-    const unsigned char *ptr =
-        (reinterpret_cast<const unsigned char *>(sram) + INVENTORY_DATA
-         + (game * INVENTORY_DATA_SIZE));
-
-    return ptr[RUPEES_OFFSET];
+    return getProperty<PROPERTY_RUPEES>();
 }
 
 void SRAMFile::setRupees(int rupees) {
-    Q_ASSERT(isValid(game));
-    Q_ASSERT((rupees >= 0) && (rupees <= 255));
-
-    unsigned char *ptr = (reinterpret_cast<unsigned char *>(sram)
-                          + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    ptr[RUPEES_OFFSET] = rupees;
-    modified           = true;
+    setProperty<PROPERTY_RUPEES>(rupees);
 }
 
 auto SRAMFile::getSword() const -> enum sf_sword {
-    Q_ASSERT(isValid(game));
-
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    return static_cast<enum sf_sword>(ptr[SWORD_OFFSET]);
+    return static_cast<enum sf_sword>(getProperty<PROPERTY_SWORD>());
 }
 
 void SRAMFile::setSword(enum sf_sword sword) {
-    Q_ASSERT(isValid(game));
-
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    ptr[SWORD_OFFSET] = sword;
-    modified          = true;
+    setProperty<PROPERTY_SWORD>(sword);
 }
 
 auto SRAMFile::hasTriforce(int piece) const -> bool {
-    Q_ASSERT(isValid(game));
     Q_ASSERT((piece >= 1) && (piece <= 8));
 
-    const char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    return (ptr[TRIFORCE_OFFSET] & (1 << (piece - 1)));
+    return (getProperty<PROPERTY_TRIFORCE>() & (1 << (piece - 1)));
 }
 
 void SRAMFile::setTriforce(int piece, bool give) {
-    Q_ASSERT(isValid(game));
     Q_ASSERT((piece >= 1) && (piece <= 8));
 
-    char *ptr = (sram + INVENTORY_DATA + (game * INVENTORY_DATA_SIZE));
-
-    if (give) {
-        ptr[TRIFORCE_OFFSET] |= (1 << (piece - 1));
-    } else {
-        ptr[TRIFORCE_OFFSET] &= ~(1 << (piece - 1));
-    }
+    const int bit  = (1 << (piece - 1));
+    const int bits = getProperty<PROPERTY_TRIFORCE>();
 
-    modified = true;
+    setProperty<PROPERTY_TRIFORCE>(give ? (bits | bit) : (bits & ~bit));
 }
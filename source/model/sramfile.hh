@@ -22,11 +22,18 @@
 #ifndef LOZSRAME_SRAMFILE_HH_
 #define LOZSRAME_SRAMFILE_HH_
 
+#include <QByteArray>
+#include <QSharedPointer>
 #include <QString>
+#include <QVector>
 
 #include "exceptions/invalidsramfileexception.hh"
 
+class QFile;
+
 namespace lozsrame {
+    class MapState;
+
     /// offset of the arrow data
     const int ARROWS_OFFSET = 0x2;
 
@@ -133,6 +140,9 @@ namespace lozsrame {
         ITEM_MAGICSHIELD
     };
 
+    /// the ways an SRAM file can be loaded
+    enum sf_loadmode { LOAD_COPY, LOAD_MAP };
+
     /// locations of the potion note
     enum sf_note { NOTE_OLDMAN, NOTE_LINK, NOTE_OLDWOMAN };
 
@@ -145,17 +155,355 @@ namespace lozsrame {
     /// the types of rings
     enum sf_ring { RING_NONE, RING_BLUE, RING_RED };
 
+    /// the ways to save SRAM files
+    enum sf_savemode { SAVE_ATOMIC, SAVE_INPLACE };
+
     /// the types of swords
     enum sf_sword { SWORD_NONE, SWORD_WOODEN, SWORD_WHITE, SWORD_MASTER };
 
+    /**
+     * The result of checksumming SRAM data, which can be reused to load
+     * identical data again without checksumming it.
+     */
+    struct SRAMValidation {
+        quint16 sums[3];
+        bool    valid[3];
+    };
+
+    /// the parts of a game's data a property can live in
+    enum sf_region { REGION_INVENTORY, REGION_MISC };
+
+    /// the kinds of values a property holds
+    enum sf_valuetype {
+        VALUE_NUMBER,
+        VALUE_FLAG,
+        VALUE_BITS,
+        VALUE_ARROW,
+        VALUE_CANDLE,
+        VALUE_NOTE,
+        VALUE_POTION,
+        VALUE_QUEST,
+        VALUE_RING,
+        VALUE_SWORD
+    };
+
+    /// the properties of a game, each described in SRAM_PROPERTIES
+    enum sf_property {
+        PROPERTY_ARROWS,
+        PROPERTY_BOMBCAPACITY,
+        PROPERTY_BOMBS,
+        PROPERTY_CANDLE,
+        PROPERTY_COMPASSES,
+        PROPERTY_COMPASS9,
+        PROPERTY_HEARTCONTAINERS,
+        PROPERTY_KEYS,
+        PROPERTY_MAPS,
+        PROPERTY_MAP9,
+        PROPERTY_NOTE,
+        PROPERTY_PLAYCOUNT,
+        PROPERTY_POTION,
+        PROPERTY_QUEST,
+        PROPERTY_RING,
+        PROPERTY_RUPEES,
+        PROPERTY_SWORD,
+        PROPERTY_TRIFORCE,
+        PROPERTY_BOW,
+        PROPERTY_WHISTLE,
+        PROPERTY_BAIT,
+        PROPERTY_WAND,
+        PROPERTY_RAFT,
+        PROPERTY_BOOK,
+        PROPERTY_LADDER,
+        PROPERTY_MAGICKEY,
+        PROPERTY_POWERBRACELET,
+        PROPERTY_BOOMERANG,
+        PROPERTY_MAGICBOOMERANG,
+        PROPERTY_MAGICSHIELD,
+        PROPERTY_COUNT
+    };
+
+    /**
+     * Where a property of a game is stored and what it may hold. A property
+     * is a run of bits within one byte. The value is the bits plus the
+     * bias, and must be between the minimum and maximum.
+     */
+    struct PropertyDescriptor {
+        enum sf_property  property;
+        const char       *name;
+        enum sf_region    region;
+        int               offset, shift, width, bias, minimum, maximum;
+        enum sf_valuetype type;
+    };
+
+    /// every property of a game, indexed by sf_property
+    constexpr PropertyDescriptor SRAM_PROPERTIES[PROPERTY_COUNT] = {
+        {PROPERTY_ARROWS, "arrows", REGION_INVENTORY, ARROWS_OFFSET, 0, 8, 0,
+         0, 2, VALUE_ARROW},
+        {PROPERTY_BOMBCAPACITY, "bombcapacity", REGION_INVENTORY,
+         BOMBCAPACITY_OFFSET, 0, 8, 0, 0, 16, VALUE_NUMBER},
+        {PROPERTY_BOMBS, "bombs", REGION_INVENTORY, BOMBS_OFFSET, 0, 8, 0, 0,
+         16, VALUE_NUMBER},
+        {PROPERTY_CANDLE, "candle", REGION_INVENTORY, CANDLE_OFFSET, 0, 8, 0,
+         0, 2, VALUE_CANDLE},
+        {PROPERTY_COMPASSES, "compasses", REGION_INVENTORY, COMPASS_OFFSET, 0,
+         8, 0, 0, 255, VALUE_BITS},
+        {PROPERTY_COMPASS9, "compass9", REGION_INVENTORY, COMPASS9_OFFSET, 0,
+         8, 0, 0, 1, VALUE_FLAG},
+        {PROPERTY_HEARTCONTAINERS, "hearts", REGION_INVENTORY,
+         HEARTCONTAINERS_OFFSET, 4, 4, 1, 1, 16, VALUE_NUMBER},
+        {PROPERTY_KEYS, "keys", REGION_INVENTORY, KEYS_OFFSET, 0, 8, 0, 0, 99,
+         VALUE_NUMBER},
+        {PROPERTY_MAPS, "maps", REGION_INVENTORY, MAP_OFFSET, 0, 8, 0, 0, 255,
+         VALUE_BITS},
+        {PROPERTY_MAP9, "map9", REGION_INVENTORY, MAP9_OFFSET, 0, 8, 0, 0, 1,
+         VALUE_FLAG},
+        {PROPERTY_NOTE, "note", REGION_INVENTORY, NOTE_OFFSET, 0, 8, 0, 0, 2,
+         VALUE_NOTE},
+        {PROPERTY_PLAYCOUNT, "playcount", REGION_MISC, PLAYCOUNT_OFFSET, 0, 8,
+         0, 0, 255, VALUE_NUMBER},
+        {PROPERTY_POTION, "potion", REGION_INVENTORY, POTION_OFFSET, 0, 8, 0,
+         0, 2, VALUE_POTION},
+        {PROPERTY_QUEST, "quest", REGION_MISC, QUEST_OFFSET, 0, 8, 0, 0, 1,
+         VALUE_QUEST},
+        {PROPERTY_RING, "ring", REGION_INVENTORY, RING_OFFSET, 0, 8, 0, 0, 2,
+         VALUE_RING},
+        {PROPERTY_RUPEES, "rupees", REGION_INVENTORY, RUPEES_OFFSET, 0, 8, 0,
+         0, 255, VALUE_NUMBER},
+        {PROPERTY_SWORD, "sword", REGION_INVENTORY, SWORD_OFFSET, 0, 8, 0, 0,
+         3, VALUE_SWORD},
+        {PROPERTY_TRIFORCE, "triforce", REGION_INVENTORY, TRIFORCE_OFFSET, 0,
+         8, 0, 0, 255, VALUE_BITS},
+        {PROPERTY_BOW, "bow", REGION_INVENTORY, ITEM_BOW, 0, 8, 0, 0, 1,
+         VALUE_FLAG},
+        {PROPERTY_WHISTLE, "whistle", REGION_INVENTORY, ITEM_WHISTLE, 0, 8, 0,
+         0, 1, VALUE_FLAG},
+        {PROPERTY_BAIT, "bait", REGION_INVENTORY, ITEM_BAIT, 0, 8, 0, 0, 1,
+         VALUE_FLAG},
+        {PROPERTY_WAND, "wand", REGION_INVENTORY, ITEM_WAND, 0, 8, 0, 0, 1,
+         VALUE_FLAG},
+        {PROPERTY_RAFT, "raft", REGION_INVENTORY, ITEM_RAFT, 0, 8, 0, 0, 1,
+         VALUE_FLAG},
+        {PROPERTY_BOOK, "book", REGION_INVENTORY, ITEM_BOOK, 0, 8, 0, 0, 1,
+         VALUE_FLAG},
+        {PROPERTY_LADDER, "ladder", REGION_INVENTORY, ITEM_LADDER, 0, 8, 0, 0,
+         1, VALUE_FLAG},
+        {PROPERTY_MAGICKEY, "magickey", REGION_INVENTORY, ITEM_MAGICKEY, 0, 8,
+         0, 0, 1, VALUE_FLAG},
+        {PROPERTY_POWERBRACELET, "powerbracelet", REGION_INVENTORY,
+         ITEM_POWERBRACELET, 0, 8, 0, 0, 1, VALUE_FLAG},
+        {PROPERTY_BOOMERANG, "boomerang", REGION_INVENTORY, ITEM_BOOMERANG, 0,
+         8, 0, 0, 1, VALUE_FLAG},
+        {PROPERTY_MAGICBOOMERANG, "magicboomerang", REGION_INVENTORY,
+         ITEM_MAGICBOOMERANG, 0, 8, 0, 0, 1, VALUE_FLAG},
+        {PROPERTY_MAGICSHIELD, "magicshield", REGION_INVENTORY,
+         ITEM_MAGICSHIELD, 0, 8, 0, 0, 1, VALUE_FLAG}};
+
+    /**
+     * Checks that SRAM_PROPERTIES is in sf_property order.
+     *
+     * @return true if it is; false otherwise.
+     */
+    constexpr bool isPropertyTableOrdered() {
+        for (int i = 0; i < PROPERTY_COUNT; ++i) {
+            if (SRAM_PROPERTIES[i].property != i) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static_assert(isPropertyTableOrdered(), "SRAM_PROPERTIES is out of order");
+
+    /**
+     * Gets the property holding an item.
+     *
+     * @param item The item.
+     *
+     * @return The property.
+     */
+    constexpr enum sf_property getItemProperty(enum sf_item item) {
+        switch (item) {
+            case ITEM_BOW:
+                return PROPERTY_BOW;
+            case ITEM_WHISTLE:
+                return PROPERTY_WHISTLE;
+            case ITEM_BAIT:
+                return PROPERTY_BAIT;
+            case ITEM_WAND:
+                return PROPERTY_WAND;
+            case ITEM_RAFT:
+                return PROPERTY_RAFT;
+            case ITEM_BOOK:
+                return PROPERTY_BOOK;
+            case ITEM_LADDER:
+                return PROPERTY_LADDER;
+            case ITEM_MAGICKEY:
+                return PROPERTY_MAGICKEY;
+            case ITEM_POWERBRACELET:
+                return PROPERTY_POWERBRACELET;
+            case ITEM_BOOMERANG:
+                return PROPERTY_BOOMERANG;
+            case ITEM_MAGICBOOMERANG:
+                return PROPERTY_MAGICBOOMERANG;
+            default:
+                return PROPERTY_MAGICSHIELD;
+        }
+    }
+
+    /**
+     * Finds a property by its name in SRAM_PROPERTIES.
+     *
+     * @param name The name.
+     *
+     * @return The property, or PROPERTY_COUNT if no property has the name.
+     */
+    enum sf_property findProperty(const char *name);
+
+    /// the dirty field bit for the hero's name, after those of the properties
+    const quint64 DIRTY_NAME = Q_UINT64_C(1) << PROPERTY_COUNT;
+
+    /// every dirty field bit
+    const quint64 DIRTY_ALL = (DIRTY_NAME << 1) - 1;
+
+    /**
+     * Gets the dirty field bit for a property.
+     *
+     * @param property The property.
+     *
+     * @return The bit.
+     */
+    constexpr quint64 getDirtyBit(enum sf_property property) {
+        return (Q_UINT64_C(1) << property);
+    }
+
+    /**
+     * Gets the offset of the byte holding a property of a game.
+     *
+     * @param property The property.
+     * @param game The game.
+     *
+     * @return The offset in the SRAM data.
+     */
+    constexpr int getPropertyOffset(const PropertyDescriptor &property,
+                                    int game) {
+        // the misc bytes are interleaved between the games
+        return (property.region == REGION_INVENTORY)
+                   ? (INVENTORY_DATA + (game * INVENTORY_DATA_SIZE)
+                      + property.offset)
+                   : (MISC_DATA + property.offset + game);
+    }
+
+    /**
+     * Checks if a value is allowed for a property.
+     *
+     * @param property The property.
+     * @param value The value.
+     *
+     * @return true if allowed; false otherwise.
+     */
+    constexpr bool isPropertyInRange(const PropertyDescriptor &property,
+                                     int value) {
+        return ((value >= property.minimum) && (value <= property.maximum));
+    }
+
+    /**
+     * Reads a property of a game from SRAM data.
+     *
+     * @param sram The SRAM data.
+     * @param game The game.
+     * @param property The property.
+     *
+     * @return The value.
+     */
+    inline int readProperty(const char *sram, int game,
+                            const PropertyDescriptor &property) {
+        const int byte = static_cast<unsigned char>(
+            sram[getPropertyOffset(property, game)]);
+
+        return (((byte >> property.shift) & ((1 << property.width) - 1))
+                + property.bias);
+    }
+
+    /**
+     * Works out the new value of the byte holding a property of a game,
+     * keeping any other bits in the byte.
+     *
+     * @param sram The SRAM data.
+     * @param game The game.
+     * @param property The property.
+     * @param value The new value of the property.
+     *
+     * @return The new value of the byte.
+     */
+    inline int mergeProperty(const char *sram, int game,
+                             const PropertyDescriptor &property, int value) {
+        const int mask = (((1 << property.width) - 1) << property.shift);
+        const int byte = static_cast<unsigned char>(
+            sram[getPropertyOffset(property, game)]);
+
+        return ((byte & ~mask)
+                | (((value - property.bias) << property.shift) & mask));
+    }
+
+    /**
+     * Reads a property of a game from SRAM data. The property is known at
+     * compile time, so this compiles down to a load, a shift and a mask.
+     *
+     * @param sram The SRAM data.
+     * @param game The game.
+     *
+     * @return The value.
+     */
+    template <enum sf_property P>
+    inline int readProperty(const char *sram, int game) {
+        constexpr PropertyDescriptor property = SRAM_PROPERTIES[P];
+
+        return readProperty(sram, game, property);
+    }
+
+    /**
+     * Works out the new value of the byte holding a property of a game.
+     *
+     * @param sram The SRAM data.
+     * @param game The game.
+     * @param value The new value of the property.
+     *
+     * @return The new value of the byte.
+     */
+    template <enum sf_property P>
+    inline int mergeProperty(const char *sram, int game, int value) {
+        constexpr PropertyDescriptor property = SRAM_PROPERTIES[P];
+
+        return mergeProperty(sram, game, property, value);
+    }
+
     /**
      * A model of the SRAM data used by The Legend of Zelda.
      */
     class SRAMFile {
       private:
-        int  game;
-        char sram[SRAM_SIZE];
-        bool modified, valid[3];
+        /// one byte changed by an edit
+        struct JournalEntry {
+            quint16 offset;
+            quint8  before, after;
+        };
+
+        /// where an undoable edit ends in the journal, and its game
+        struct JournalStep {
+            int end, game;
+        };
+
+        QSharedPointer<QFile> mappedFile;
+        const char           *mapping;
+        int                   game;
+        char                  sram[SRAM_SIZE];
+        quint16               sums[3];
+        bool                  valid[3];
+        QVector<JournalEntry> journal;
+        QVector<JournalStep>  steps;
+        int                   step, cleanStep;
+        quint64               dirty;
 
         /**
          * Calculates the checksum for one of the games.
@@ -183,26 +531,316 @@ namespace lozsrame {
          */
         void setChecksum(int game, quint16 checksum);
 
+        /**
+         * Stores the running checksum of each valid game in the SRAM data.
+         */
+        void updateChecksums();
+
+        /**
+         * Copies a mapped file into memory so it can be modified. Does
+         * nothing if the file is not mapped.
+         */
+        void detach();
+
+        /**
+         * Saves the SRAM data to a temporary file which then replaces the
+         * file, as save() does with SAVE_ATOMIC.
+         *
+         * @param filename The file to save to.
+         *
+         * @return true if the save succeeded; false otherwise.
+         */
+        bool saveAtomic(const QString &filename);
+
+        /**
+         * Saves the SRAM data over the file itself, as save() does with
+         * SAVE_INPLACE.
+         *
+         * @param filename The file to save to.
+         *
+         * @return true if the save succeeded; false otherwise.
+         */
+        bool saveInPlace(const QString &filename);
+
+        /**
+         * Gets the SRAM data, either mapped or copied.
+         *
+         * @return The SRAM data.
+         */
+        const char *image() const;
+
+        /**
+         * Checks if a game slot is empty, without decoding its name.
+         *
+         * @param data The SRAM data.
+         * @param game The game slot to check.
+         *
+         * @return true if empty; false otherwise.
+         */
+        static bool isEmpty(const char *data, int game);
+
+        /**
+         * Maps an SRAM file read-only into memory.
+         *
+         * @param filename The SRAM filename.
+         *
+         * @throw InvalidSRAMFileException if the file can't be opened or is
+         *        the wrong size.
+         */
+        void map(const QString &filename);
+
+        /**
+         * Changes one byte of the SRAM data as a single undoable edit.
+         *
+         * @param offset The offset of the byte.
+         * @param value The new value.
+         */
+        void setByte(int offset, int value);
+
+        /**
+         * Changes a run of bytes of the SRAM data as a single undoable
+         * edit. Only the bytes that actually change are journaled, and the
+         * edit is dropped entirely if none of them do.
+         *
+         * @param offset The offset of the first byte.
+         * @param data The new values.
+         * @param count The number of bytes.
+         */
+        void setBytes(int offset, const char *data, int count);
+
+        /**
+         * Changes one byte of the SRAM data without journaling it. The
+         * running checksum of the game the byte belongs to is adjusted by
+         * the difference, so save() never has to rescan the game.
+         *
+         * @param offset The offset of the byte.
+         * @param value The new value.
+         */
+        void writeByte(int offset, int value);
+
+        /**
+         * Gets the game whose checksum covers an offset.
+         *
+         * @param offset The offset.
+         *
+         * @return The game (0 - 2), or -1 if not part of any checksum.
+         */
+        static int slotOf(int offset);
+
+        /**
+         * Gets the fields held by a byte, in any game.
+         *
+         * @param offset The offset of the byte.
+         *
+         * @return The dirty field bits of the fields.
+         */
+        static quint64 getFieldsAt(int offset);
+
+        /**
+         * Checksums each game and finds the first valid one.
+         *
+         * @throw InvalidSRAMFileException if none of the games are valid.
+         */
+        void validate();
+
+        /**
+         * Takes the checksums and valid games from an earlier validation
+         * and finds the first valid game.
+         *
+         * @param validation The validation.
+         *
+         * @throw InvalidSRAMFileException if none of the games are valid.
+         */
+        void validate(const SRAMValidation &validation);
+
+        /**
+         * Creates an empty SRAMFile object for fromData to fill in.
+         */
+        SRAMFile();
+
       public:
         /**
          * Creates an SRAMFile object from an SRAM file.
          *
+         * With LOAD_MAP, the file is mapped read-only and read in place. It
+         * is only copied into memory when one of the setters is called, so
+         * the file must not be truncated while the SRAMFile is unmodified.
+         *
          * @param filename The SRAM filename.
+         * @param mode How to load the file.
          *
          * @return The new SRAMFile object.
          *
          * @throw InvalidSRAMFileException if the file is not a valid SRAM file.
          */
-        SRAMFile(const QString &filename);
+        SRAMFile(const QString &filename, enum sf_loadmode mode = LOAD_COPY);
+
+        /**
+         * Creates an SRAMFile object from SRAM data already in memory, such
+         * as an entry read from an archive. The data is copied.
+         *
+         * @param data The SRAM data.
+         * @param size The size of the data.
+         *
+         * @return The new SRAMFile object.
+         *
+         * @throw InvalidSRAMFileException if the data is not valid SRAM data.
+         */
+        static SRAMFile fromData(const char *data, qint64 size);
+
+        /**
+         * Creates an SRAMFile object from SRAM data that has been validated
+         * before, such as a copy of data already loaded. The data is copied
+         * but not checksummed.
+         *
+         * @param data The SRAM data.
+         * @param size The size of the data.
+         * @param validation The validation from getValidation() of an
+         *                   SRAMFile loaded from the same data.
+         *
+         * @return The new SRAMFile object.
+         *
+         * @throw InvalidSRAMFileException if the data is not valid SRAM data.
+         */
+        static SRAMFile fromData(const char *data, qint64 size,
+                                 const SRAMValidation &validation);
+
+        /**
+         * Checksums each game in SRAM data and checks which are valid, the
+         * same way loading the data would.
+         *
+         * @param data The SRAM_SIZE bytes of SRAM data.
+         *
+         * @return The validation.
+         */
+        static SRAMValidation validateData(const char *data);
+
+        /**
+         * Gets the running checksum and validity of each game, to load
+         * identical data later without checksumming it.
+         *
+         * @return The validation.
+         */
+        SRAMValidation getValidation() const;
 
         /**
          * Saves the SRAM data to a file.
          *
+         * With SAVE_ATOMIC, the data is written and synced to a temporary
+         * file which then replaces the old one, so a crash never leaves a
+         * half written file behind. SAVE_INPLACE overwrites the file itself,
+         * which keeps hard links intact but isn't crash safe.
+         *
          * @param filename The file to save to.
+         * @param mode How to save the file.
          *
          * @return true if the save succeeded; false otherwise.
          */
-        bool save(const QString &filename);
+        bool save(const QString &filename,
+                  enum sf_savemode mode = SAVE_ATOMIC);
+
+        /**
+         * Gets the SRAM data as save() would write it, with the checksums
+         * of the valid games brought up to date.
+         *
+         * @return The SRAM data.
+         */
+        QByteArray toData();
+
+        /**
+         * Checks if there is an edit to undo.
+         *
+         * @return true if there is; false otherwise.
+         */
+        bool canUndo() const;
+
+        /**
+         * Checks if there is an undone edit to redo.
+         *
+         * @return true if there is; false otherwise.
+         */
+        bool canRedo() const;
+
+        /**
+         * Takes the fields of the current game changed since they were
+         * last taken, so a view only has to refresh those. Every field is
+         * changed when the file is loaded or the current game changes.
+         *
+         * @param fields The dirty field bits to take.
+         *
+         * @return Those of the bits that were set, which are now cleared.
+         */
+        quint64 takeDirtyFields(quint64 fields = DIRTY_ALL);
+
+        /**
+         * Undoes the last edit, restoring the bytes it changed, and makes
+         * the game it changed the current game. Only the changed bytes are
+         * touched, so this takes time in proportion to the edit's size.
+         */
+        void undo();
+
+        /**
+         * Redoes the last undone edit, and makes the game it changed the
+         * current game. A new edit discards any edits left to redo.
+         */
+        void redo();
+
+        /**
+         * Takes on SRAM data written to the file by another program, such
+         * as an emulator, as the saved state of the file. Only the bytes
+         * that differ are written, so only their fields become dirty. If
+         * any do, the undo history is discarded, since its edits were made
+         * to the old data. The current game stays current if still valid.
+         *
+         * @param data The SRAM_SIZE bytes of SRAM data.
+         *
+         * @return The number of bytes that changed.
+         *
+         * @throw InvalidSRAMFileException if none of the games are valid, in
+         *        which case nothing is changed.
+         */
+        int reload(const char *data);
+
+        /**
+         * Decodes the map data of the current game.
+         *
+         * @return The map state.
+         */
+        MapState getMapState() const;
+
+        /**
+         * Gets a property of the current game.
+         *
+         * @return The value.
+         */
+        template <enum sf_property P>
+        int getProperty() const;
+
+        /**
+         * Gets a property of the current game, chosen at run time.
+         *
+         * @param property The property.
+         *
+         * @return The value.
+         */
+        int getProperty(enum sf_property property) const;
+
+        /**
+         * Sets a property of the current game as a single undoable edit.
+         *
+         * @param value The new value. It must be in the property's range.
+         */
+        template <enum sf_property P>
+        void setProperty(int value);
+
+        /**
+         * Sets a property of the current game, chosen at run time, as a
+         * single undoable edit.
+         *
+         * @param property The property.
+         * @param value The new value. It must be in the property's range.
+         */
+        void setProperty(enum sf_property property, int value);
 
         /**
          * Gets the kind of arrows Link is carrying.
@@ -354,7 +992,25 @@ namespace lozsrame {
         void setMap(int level, bool give);
 
         /**
-         * Checks if this SRAMFile has been modified or not.
+         * Checks if a game's stored checksum matches its current data. This
+         * is false for a valid game that has been modified but not saved.
+         *
+         * @param game The game to check.
+         *
+         * @return true if consistent; false otherwise.
+         */
+        bool isConsistent(int game) const;
+
+        /**
+         * Checks if the SRAM data is being read from a mapped file.
+         *
+         * @return true if mapped; false if copied into memory.
+         */
+        bool isMapped() const;
+
+        /**
+         * Checks if this SRAMFile has been modified since it was loaded or
+         * last saved. Undoing back to that point makes it unmodified again.
          *
          * @return true if modified; false otherwise.
          */
@@ -367,6 +1023,14 @@ namespace lozsrame {
          */
         QString getName() const;
 
+        /**
+         * Gets the name of the hero without allocating.
+         *
+         * @param buffer Where to store the NAME_DATA_SIZE Latin-1 characters
+         *               of the name. No terminator is written.
+         */
+        void getName(char *buffer) const;
+
         /**
          * Sets the name of the hero.
          *
@@ -499,6 +1163,28 @@ namespace lozsrame {
         bool isValid(int game) const;
     };
 
+    template <enum sf_property P>
+    inline int SRAMFile::getProperty() const {
+        Q_ASSERT(isValid(game));
+
+        return readProperty<P>(image(), game);
+    }
+
+    inline int SRAMFile::getProperty(enum sf_property property) const {
+        Q_ASSERT(isValid(game));
+
+        return readProperty(image(), game, SRAM_PROPERTIES[property]);
+    }
+
+    template <enum sf_property P>
+    inline void SRAMFile::setProperty(int value) {
+        Q_ASSERT(isValid(game));
+        Q_ASSERT(isPropertyInRange(SRAM_PROPERTIES[P], value));
+
+        setByte(getPropertyOffset(SRAM_PROPERTIES[P], game),
+                mergeProperty<P>(image(), game, value));
+    }
+
     inline int SRAMFile::getGame() const {
         return game;
     }
@@ -506,11 +1192,44 @@ namespace lozsrame {
     inline void SRAMFile::setGame(int game) {
         Q_ASSERT(isValid(game));
 
-        this->game = game;
+        if (this->game != game) {
+            this->game = game;
+            dirty      = DIRTY_ALL;
+        }
+    }
+
+    inline quint64 SRAMFile::takeDirtyFields(quint64 fields) {
+        const quint64 taken = (dirty & fields);
+
+        dirty &= ~fields;
+
+        return taken;
+    }
+
+    inline const char *SRAMFile::image() const {
+        return (mapping ? mapping : sram);
+    }
+
+    inline bool SRAMFile::isConsistent(int game) const {
+        Q_ASSERT((game >= 0) && (game <= 2));
+
+        return (sums[game] == getChecksum(game));
+    }
+
+    inline bool SRAMFile::isMapped() const {
+        return (mapping != nullptr);
+    }
+
+    inline bool SRAMFile::canUndo() const {
+        return (step > 0);
+    }
+
+    inline bool SRAMFile::canRedo() const {
+        return (step < steps.size());
     }
 
     inline bool SRAMFile::isModified() const {
-        return modified;
+        return (step != cleanStep);
     }
 
     inline bool SRAMFile::isValid(int game) const {
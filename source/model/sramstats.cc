@@ -0,0 +1,307 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QIODevice>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "model/filesync.hh"
+#include "model/sramstats.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /// a counter's Prometheus name and help text
+    struct MetricName {
+        const char *name;
+        const char *help;
+    };
+
+    /// the counters' names, indexed by ss_counter
+    const MetricName COUNTER_NAMES[COUNTER_COUNT] = {
+        {"lozsrame_sram_read_bytes_total", "Bytes of SRAM data read."},
+        {"lozsrame_sram_written_bytes_total", "Bytes of SRAM data written."},
+        {"lozsrame_sram_checksums_total", "Games checksummed."},
+        {"lozsrame_sram_opens_total", "SRAM files opened."},
+        {"lozsrame_sram_save_failures_total", "SRAM files not saved."},
+        {"lozsrame_sram_saves_total", "SRAM files saved."}};
+
+    /// the histograms' names, indexed by ss_histogram
+    const MetricName HISTOGRAM_NAMES[HISTOGRAM_COUNT] = {
+        {"lozsrame_sram_checksum_seconds",
+         "Time to checksum the games in SRAM data, sampled."},
+        {"lozsrame_sram_open_seconds",
+         "Time to open and validate an SRAM file, sampled."},
+        {"lozsrame_sram_save_seconds", "Time to save an SRAM file, sampled."}};
+
+    /// the failure label values, indexed by isfe_error
+    const char *const ERROR_NAMES[STATS_ERRORS] = {"filenotfound",
+                                                   "invalidsize",
+                                                   "novalidgames"};
+
+    /**
+     * Appends a metric's HELP and TYPE lines.
+     *
+     * @param text The text to append to.
+     * @param metric The metric.
+     * @param type The metric type.
+     */
+    void describe(QByteArray &text, const MetricName &metric,
+                  const char *type) {
+        text += "# HELP ";
+        text += metric.name;
+        text += ' ';
+        text += metric.help;
+        text += "\n# TYPE ";
+        text += metric.name;
+        text += ' ';
+        text += type;
+        text += '\n';
+    }
+}  // namespace
+
+struct SRAMStats::Registry {
+    QMutex               mutex;
+    std::vector<Shard *> shards;
+    SRAMStatsSnapshot    retired;
+};
+
+thread_local SRAMStats::Shard *SRAMStats::current = nullptr;
+QAtomicInt SRAMStats::sampleInterval(STATS_SAMPLE_INTERVAL);
+
+auto SRAMStats::registry() -> Registry & {
+    static Registry instance{};
+
+    return instance;
+}
+
+auto SRAMStats::attach() -> Shard * {
+    // folds the thread's counters into the retired totals when it ends
+    struct Detacher {
+        Shard *shard;
+
+        ~Detacher() {
+            Registry          &all = registry();
+            QMutexLocker       locker(&all.mutex);
+            SRAMStatsSnapshot &retired = all.retired;
+
+            for (int i = 0; i < COUNTER_COUNT; ++i) {
+                retired.counters[i] += shard->counters[i].loadAcquire();
+            }
+
+            for (int i = 0; i < STATS_ERRORS; ++i) {
+                retired.failures[i] += shard->failures[i].loadAcquire();
+            }
+
+            for (int i = 0; i < HISTOGRAM_COUNT; ++i) {
+                for (int j = 0; j <= STATS_BUCKETS; ++j) {
+                    retired.buckets[i][j] += shard->buckets[i][j].loadAcquire();
+                }
+
+                retired.sums[i] += shard->sums[i].loadAcquire();
+            }
+
+            for (auto it = all.shards.begin(); it != all.shards.end(); ++it) {
+                if (*it == shard) {
+                    all.shards.erase(it);
+                    break;
+                }
+            }
+
+            current = nullptr;
+            delete shard;
+        }
+    };
+
+    static thread_local Detacher detacher{nullptr};
+
+    Registry &all   = registry();
+    Shard    *stats = new Shard();
+
+    // time the first of each operation, so short runs get some samples
+    for (int &countdown : stats->countdown) {
+        countdown = 1;
+    }
+
+    {
+        QMutexLocker locker(&all.mutex);
+        all.shards.push_back(stats);
+    }
+
+    detacher.shard = stats;
+    current        = stats;
+
+    return stats;
+}
+
+auto SRAMStats::now() -> qint64 {
+    static const QElapsedTimer clock = [] {
+        QElapsedTimer timer;
+
+        timer.start();
+
+        return timer;
+    }();
+
+    return clock.nsecsElapsed();
+}
+
+void SRAMStats::observe(enum ss_histogram histogram, qint64 elapsed) {
+    Shard &stats  = shard();
+    int    bucket = 0;
+
+    while ((bucket < STATS_BUCKETS)
+           && (elapsed > STATS_BUCKET_BOUNDS[bucket])) {
+        ++bucket;
+    }
+
+    add(stats.buckets[histogram][bucket], 1);
+    add(stats.sums[histogram], static_cast<quint64>(elapsed));
+}
+
+void SRAMStats::setSampleInterval(int interval) {
+    Q_ASSERT(interval >= 1);
+
+    sampleInterval.storeRelease(interval);
+}
+
+auto SRAMStats::snapshot() -> SRAMStatsSnapshot {
+    Registry         &all = registry();
+    QMutexLocker      locker(&all.mutex);
+    SRAMStatsSnapshot totals = all.retired;
+
+    for (const Shard *shard : all.shards) {
+        for (int i = 0; i < COUNTER_COUNT; ++i) {
+            totals.counters[i] += shard->counters[i].loadAcquire();
+        }
+
+        for (int i = 0; i < STATS_ERRORS; ++i) {
+            totals.failures[i] += shard->failures[i].loadAcquire();
+        }
+
+        for (int i = 0; i < HISTOGRAM_COUNT; ++i) {
+            for (int j = 0; j <= STATS_BUCKETS; ++j) {
+                totals.buckets[i][j] += shard->buckets[i][j].loadAcquire();
+            }
+
+            totals.sums[i] += shard->sums[i].loadAcquire();
+        }
+    }
+
+    totals.sampleInterval = getSampleInterval();
+
+    return totals;
+}
+
+auto SRAMStats::toPrometheus(const SRAMStatsSnapshot &snapshot)
+    -> QByteArray {
+    QByteArray text;
+
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        describe(text, COUNTER_NAMES[i], "counter");
+        text += COUNTER_NAMES[i].name;
+        text += ' ';
+        text += QByteArray::number(snapshot.counters[i]);
+        text += '\n';
+    }
+
+    const MetricName failures = {"lozsrame_sram_validation_failures_total",
+                                 "SRAM files that failed to load, by reason."};
+
+    describe(text, failures, "counter");
+
+    for (int i = 0; i < STATS_ERRORS; ++i) {
+        text += failures.name;
+        text += "{error=\"";
+        text += ERROR_NAMES[i];
+        text += "\"} ";
+        text += QByteArray::number(snapshot.failures[i]);
+        text += '\n';
+    }
+
+    for (int i = 0; i < HISTOGRAM_COUNT; ++i) {
+        const char *name       = HISTOGRAM_NAMES[i].name;
+        quint64     cumulative = 0;
+
+        describe(text, HISTOGRAM_NAMES[i], "histogram");
+
+        for (int j = 0; j <= STATS_BUCKETS; ++j) {
+            cumulative += snapshot.buckets[i][j];
+
+            text += name;
+            text += "_bucket{le=\"";
+            text += (j < STATS_BUCKETS)
+                        ? QByteArray::number(STATS_BUCKET_BOUNDS[j] / 1e9, 'g')
+                        : QByteArray("+Inf");
+            text += "\"} ";
+            text += QByteArray::number(cumulative);
+            text += '\n';
+        }
+
+        text += name;
+        text += "_sum ";
+        text += QByteArray::number(snapshot.sums[i] / 1e9, 'f', 9);
+        text += '\n';
+        text += name;
+        text += "_count ";
+        text += QByteArray::number(cumulative);
+        text += '\n';
+    }
+
+    const MetricName interval = {"lozsrame_sram_sample_interval",
+                                 "Operations per timed operation."};
+
+    describe(text, interval, "gauge");
+    text += interval.name;
+    text += ' ';
+    text += QByteArray::number(snapshot.sampleInterval);
+    text += '\n';
+
+    return text;
+}
+
+auto SRAMStats::writePrometheus(QIODevice &device) -> bool {
+    const QByteArray text = toPrometheus(snapshot());
+
+    return (device.write(text) == text.size());
+}
+
+auto SRAMStats::writePrometheus(const QString &filename) -> bool {
+    const QString target    = resolveFile(filename);
+    const QString temporary =
+        writeTemporary(target, toPrometheus(snapshot()), false);
+
+    if (temporary.isEmpty()) {
+        return false;
+    }
+
+    if (!replaceFile(temporary, target)) {
+        QFile::remove(temporary);
+
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,284 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_SRAMSTATS_HH_
+#define LOZSRAME_SRAMSTATS_HH_
+
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QString>
+
+#include "exceptions/invalidsramfileexception.hh"
+
+class QIODevice;
+
+namespace lozsrame {
+    /// the events SRAMStats counts
+    enum ss_counter {
+        COUNTER_BYTESREAD,
+        COUNTER_BYTESWRITTEN,
+        COUNTER_CHECKSUMS,
+        COUNTER_OPENS,
+        COUNTER_SAVEFAILURES,
+        COUNTER_SAVES,
+        COUNTER_COUNT
+    };
+
+    /// the operations SRAMStats times
+    enum ss_histogram {
+        HISTOGRAM_CHECKSUM,
+        HISTOGRAM_OPEN,
+        HISTOGRAM_SAVE,
+        HISTOGRAM_COUNT
+    };
+
+    /// the number of isfe_error codes
+    const int STATS_ERRORS = ISFE_NOVALIDGAMES + 1;
+
+    /// the number of latency histogram buckets with an upper bound
+    const int STATS_BUCKETS = 18;
+
+    /// the upper bound of each latency histogram bucket, in nanoseconds
+    const qint64 STATS_BUCKET_BOUNDS[STATS_BUCKETS] = {
+        1000,      2500,      5000,      10000,     25000,     50000,
+        100000,    250000,    500000,    1000000,   2500000,   5000000,
+        10000000,  25000000,  50000000,  100000000, 250000000, 1000000000};
+
+    /// the default number of operations per timed operation
+    const int STATS_SAMPLE_INTERVAL = 16;
+
+    /**
+     * The values of every SRAMStats counter and histogram at one moment.
+     * The histogram buckets are not cumulative; the last one counts the
+     * operations slower than every bound.
+     */
+    struct SRAMStatsSnapshot {
+        quint64 counters[COUNTER_COUNT];
+        quint64 failures[STATS_ERRORS];
+        quint64 buckets[HISTOGRAM_COUNT][STATS_BUCKETS + 1];
+        quint64 sums[HISTOGRAM_COUNT];
+        int     sampleInterval;
+    };
+
+    /**
+     * Process wide counters and latency histograms for SRAMFile's loads,
+     * checksums and saves.
+     *
+     * Each thread updates its own set of counters without locked
+     * instructions, and snapshot() adds them up. Timing an operation costs
+     * more than the rest of the bookkeeping put together, so only one
+     * operation in getSampleInterval() is timed; the counters are always
+     * exact, and a histogram's count is the number of timed operations.
+     */
+    class SRAMStats {
+      private:
+        /// one thread's counters, only ever written by that thread
+        struct Shard {
+            QAtomicInteger<quint64> counters[COUNTER_COUNT];
+            QAtomicInteger<quint64> failures[STATS_ERRORS];
+            QAtomicInteger<quint64> buckets[HISTOGRAM_COUNT][STATS_BUCKETS + 1];
+            QAtomicInteger<quint64> sums[HISTOGRAM_COUNT];
+            int                     countdown[HISTOGRAM_COUNT];
+        };
+
+        /// every thread's counters, and the totals of finished threads
+        struct Registry;
+
+        static thread_local Shard *current;
+        static QAtomicInt          sampleInterval;
+
+        /**
+         * Gets the registry of every thread's counters.
+         *
+         * @return The registry.
+         */
+        static Registry &registry();
+
+        /**
+         * Adds to a counter owned by the calling thread. Nothing else
+         * writes it, so it needn't be incremented atomically.
+         *
+         * @param value The counter.
+         * @param amount The amount to add.
+         */
+        static void add(QAtomicInteger<quint64> &value, quint64 amount);
+
+        /**
+         * Gets the calling thread's counters, creating them on first use.
+         *
+         * @return The counters.
+         */
+        static Shard &shard();
+
+        /**
+         * Creates and registers the calling thread's counters, which are
+         * added to the totals of finished threads when it finishes.
+         *
+         * @return The counters.
+         */
+        static Shard *attach();
+
+        /**
+         * Adds a timed operation to a histogram.
+         *
+         * @param histogram The histogram.
+         * @param elapsed How long the operation took, in nanoseconds.
+         */
+        static void observe(enum ss_histogram histogram, qint64 elapsed);
+
+        /**
+         * Reads the clock the histograms are timed with.
+         *
+         * @return The time in nanoseconds.
+         */
+        static qint64 now();
+
+      public:
+        SRAMStats() = delete;
+
+        /**
+         * Counts an event.
+         *
+         * @param counter The counter.
+         * @param amount The amount to add.
+         */
+        static void count(enum ss_counter counter, quint64 amount = 1);
+
+        /**
+         * Counts a file that failed to load.
+         *
+         * @param error The reason it failed.
+         */
+        static void countFailure(enum isfe_error error);
+
+        /**
+         * Starts timing an operation, if it is one of those sampled.
+         *
+         * @param histogram The histogram the operation will be added to.
+         *
+         * @return The start time to pass to record(), or -1 if the
+         *         operation is not timed.
+         */
+        static qint64 startTimer(enum ss_histogram histogram);
+
+        /**
+         * Finishes timing an operation, adding it to a histogram.
+         *
+         * @param histogram The histogram.
+         * @param start The time from startTimer(). Does nothing if -1.
+         */
+        static void record(enum ss_histogram histogram, qint64 start);
+
+        /**
+         * Gets how many operations there are per timed operation.
+         *
+         * @return The interval.
+         */
+        static int getSampleInterval();
+
+        /**
+         * Sets how many operations there are per timed operation. 1 times
+         * every operation.
+         *
+         * @param interval The interval.
+         */
+        static void setSampleInterval(int interval);
+
+        /**
+         * Adds up the counters of every thread.
+         *
+         * @return The totals.
+         */
+        static SRAMStatsSnapshot snapshot();
+
+        /**
+         * Formats a snapshot in the Prometheus text exposition format.
+         *
+         * @param snapshot The snapshot.
+         *
+         * @return The text.
+         */
+        static QByteArray toPrometheus(const SRAMStatsSnapshot &snapshot);
+
+        /**
+         * Writes a snapshot of the current totals in the Prometheus text
+         * format to a device, such as a connected socket.
+         *
+         * @param device The device.
+         *
+         * @return true if it was all written; false otherwise.
+         */
+        static bool writePrometheus(QIODevice &device);
+
+        /**
+         * Writes a snapshot of the current totals in the Prometheus text
+         * format to a file, replacing it in one step so a collector reading
+         * it never sees half a file.
+         *
+         * @param filename The file.
+         *
+         * @return true if the file was written; false otherwise.
+         */
+        static bool writePrometheus(const QString &filename);
+    };
+
+    inline void SRAMStats::add(QAtomicInteger<quint64> &value,
+                               quint64 amount) {
+        value.storeRelease(value.loadAcquire() + amount);
+    }
+
+    inline SRAMStats::Shard &SRAMStats::shard() {
+        return *(current ? current : attach());
+    }
+
+    inline void SRAMStats::count(enum ss_counter counter, quint64 amount) {
+        add(shard().counters[counter], amount);
+    }
+
+    inline void SRAMStats::countFailure(enum isfe_error error) {
+        add(shard().failures[error], 1);
+    }
+
+    inline qint64 SRAMStats::startTimer(enum ss_histogram histogram) {
+        int &countdown = shard().countdown[histogram];
+
+        if (--countdown > 0) {
+            return -1;
+        }
+
+        countdown = sampleInterval.loadAcquire();
+
+        return now();
+    }
+
+    inline void SRAMStats::record(enum ss_histogram histogram,
+                                  qint64 start) {
+        if (start >= 0) {
+            observe(histogram, now() - start);
+        }
+    }
+
+    inline int SRAMStats::getSampleInterval() {
+        return sampleInterval.loadAcquire();
+    }
+}  // namespace lozsrame
+
+#endif
@@ -0,0 +1,475 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "exceptions/invalidsramfileexception.hh"
+#include "model/checksum.hh"
+#include "model/simd.hh"
+#include "model/sramfile.hh"
+
+#if defined(LOZSRAME_SIMD) && defined(__GNUC__)
+    #include <x86intrin.h>
+#endif
+
+// the sav directory of the source tree, set by bench.pro
+#ifndef LOZSRAME_SAVDIR
+    #define LOZSRAME_SAVDIR "../sav"
+#endif
+
+using namespace lozsrame;
+
+namespace {
+    /// heap allocations made so far, by any thread
+    std::atomic<quint64> allocations(0);
+
+    /// defeats dead code elimination of benchmarked results
+    volatile unsigned int sink;
+
+    /// the version of the --json output, raised when its fields change
+    const int BENCH_FORMAT = 1;
+
+    /// the save benchmarked when none is given
+    const char *const SAMPLE_FILE =
+        LOZSRAME_SAVDIR "/Legend of Zelda, The (U) (PRG0).sav";
+
+    /// a measurement of one benchmark against one image
+    struct BenchResult {
+        QByteArray  name;
+        const char *image;
+        int         iterations;
+        double      ns;
+        double      cycles;
+        double      allocations;
+        double      bytesPerSecond;
+    };
+
+    /// an SRAM image to benchmark with, and a copy of it on disk
+    struct BenchImage {
+        const char *label;
+        QByteArray  data;
+        QString     filename;
+    };
+}  // namespace
+
+#ifdef __GLIBC__
+// wrap glibc's allocator so allocations inside Qt are counted too
+extern "C" {
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+
+    void *malloc(size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+
+        return __libc_realloc(ptr, size);
+    }
+}
+#else
+// elsewhere, only allocations made with new can be counted
+void *operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+#endif
+
+namespace {
+    /**
+     * Reads the processor's time stamp counter.
+     *
+     * @return The counter, or 0 if it can't be read.
+     */
+    inline quint64 readCycles() {
+#ifdef LOZSRAME_SIMD
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * Times one benchmark. The body is called once untimed to warm the
+     * caches, then iterations times with the iteration number.
+     *
+     * @param name The benchmark name.
+     * @param image The image label.
+     * @param bytes The bytes each call processes.
+     * @param iterations The number of timed calls.
+     * @param body The code to time.
+     *
+     * @return The measurement.
+     */
+    template <typename Body>
+    BenchResult measure(const QByteArray &name, const char *image, int bytes,
+                        int iterations, Body body) {
+        body(0);
+
+        const quint64 before = allocations.load(std::memory_order_relaxed);
+        QElapsedTimer timer;
+
+        timer.start();
+
+        const quint64 start = readCycles();
+
+        for (int i = 0; i < iterations; ++i) {
+            body(i);
+        }
+
+        const quint64 cycles = readCycles() - start;
+        const double  ns     = timer.nsecsElapsed();
+        const quint64 after  = allocations.load(std::memory_order_relaxed);
+
+        BenchResult result;
+
+        result.name           = name;
+        result.image          = image;
+        result.iterations     = iterations;
+        result.ns             = ns / iterations;
+        result.cycles         = static_cast<double>(cycles) / iterations;
+        result.allocations    = static_cast<double>(after - before)
+                                / iterations;
+        result.bytesPerSecond = (ns > 0)
+                                    ? (static_cast<double>(bytes) * iterations
+                                       / (ns / 1e9))
+                                    : 0;
+
+        return result;
+    }
+
+    /**
+     * Fills an image with random bytes, then gives every game a matching
+     * checksum so the image loads.
+     *
+     * @param image The SRAM_SIZE byte image.
+     */
+    void makeSynthetic(char *image) {
+        std::mt19937 random(0x5A4D);
+
+        for (int i = 0; i < SRAM_SIZE; ++i) {
+            image[i] = static_cast<char>(random());
+        }
+
+        for (int game = 0; game < 3; ++game) {
+            const quint16 sum    = slotChecksum(image, game);
+            const int     offset = CHECKSUM_OFFSET + (game * 2);
+
+            image[offset]     = static_cast<char>(sum >> 8);
+            image[offset + 1] = static_cast<char>(sum & 0xFF);
+        }
+    }
+
+    /**
+     * Checks that every supported kernel agrees with the scalar kernel.
+     *
+     * @param image The SRAM image.
+     *
+     * @return true if they agree; false otherwise.
+     */
+    bool verifyKernels(const char *image) {
+        for (int game = 0; game < 3; ++game) {
+            quint16 expected = slotChecksum(image, game, KERNEL_SCALAR);
+
+            for (int kernel = KERNEL_SSE2; kernel <= KERNEL_AVX2; ++kernel) {
+                auto k = static_cast<enum cs_kernel>(kernel);
+
+                if (isChecksumKernelSupported(k)
+                    && (slotChecksum(image, game, k) != expected)) {
+                    std::fprintf(stderr, "%s kernel mismatch in game %d\n",
+                                 getChecksumKernelName(k), game + 1);
+
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Runs every benchmark against an image.
+     *
+     * @param image The image.
+     * @param iterations The timed calls for the in-memory benchmarks.
+     * @param ioIterations The timed calls for the benchmarks that touch
+     *                     the disk.
+     * @param scratch A file the save benchmarks can overwrite.
+     * @param results The list to add the measurements to.
+     *
+     * @throw InvalidSRAMFileException if the image is not valid SRAM data.
+     */
+    void benchImage(const BenchImage &image, int iterations,
+                    int ioIterations, const QString &scratch,
+                    QVector<BenchResult> &results) {
+        const int   slotBytes = NAME_DATA_SIZE + INVENTORY_DATA_SIZE
+                                + MAP_DATA_SIZE + MISC_DATA_SIZE;
+        const char *data      = image.data.constData();
+
+        for (int kernel = KERNEL_SCALAR; kernel <= KERNEL_AVX2; ++kernel) {
+            auto k = static_cast<enum cs_kernel>(kernel);
+
+            if (!isChecksumKernelSupported(k)) {
+                continue;
+            }
+
+            results.append(measure(
+                QByteArray("checksum/") + getChecksumKernelName(k),
+                image.label, slotBytes, iterations, [data, k](int i) {
+                    sink = sink + slotChecksum(data, i % 3, k);
+                }));
+        }
+
+        SRAMFile file = SRAMFile::fromData(data, SRAM_SIZE);
+
+        results.append(measure("getName", image.label, NAME_DATA_SIZE,
+                               iterations, [&file](int) {
+                                   sink = sink + file.getName().size();
+                               }));
+
+        // alternate so every call changes the name
+        const QString names[2] = {"LINK", "ZELDA"};
+
+        results.append(measure("setName", image.label, NAME_DATA_SIZE,
+                               iterations, [&file, &names](int i) {
+                                   file.setName(names[i & 1]);
+                               }));
+
+        const SRAMValidation validation = file.getValidation();
+
+        results.append(measure("load/data", image.label, SRAM_SIZE,
+                               iterations, [data](int) {
+                                   SRAMFile copy =
+                                       SRAMFile::fromData(data, SRAM_SIZE);
+                                   sink = sink + copy.getGame();
+                               }));
+        results.append(measure("load/validated", image.label, SRAM_SIZE,
+                               iterations, [data, &validation](int) {
+                                   SRAMFile copy = SRAMFile::fromData(
+                                       data, SRAM_SIZE, validation);
+                                   sink = sink + copy.getGame();
+                               }));
+        results.append(measure("load/copy", image.label, SRAM_SIZE,
+                               ioIterations, [&image](int) {
+                                   SRAMFile copy(image.filename, LOAD_COPY);
+                                   sink = sink + copy.getGame();
+                               }));
+        results.append(measure("load/map", image.label, SRAM_SIZE,
+                               ioIterations, [&image](int) {
+                                   SRAMFile copy(image.filename, LOAD_MAP);
+                                   sink = sink + copy.getGame();
+                               }));
+
+        SRAMFile saved = SRAMFile::fromData(data, SRAM_SIZE);
+
+        results.append(measure("save/atomic", image.label, SRAM_SIZE,
+                               ioIterations, [&saved, &scratch](int) {
+                                   sink = sink
+                                          + saved.save(scratch, SAVE_ATOMIC);
+                               }));
+        results.append(measure("save/inplace", image.label, SRAM_SIZE,
+                               ioIterations, [&saved, &scratch](int) {
+                                   sink = sink
+                                          + saved.save(scratch, SAVE_INPLACE);
+                               }));
+    }
+
+    /**
+     * Prints the measurements as a table.
+     *
+     * @param results The measurements.
+     */
+    void printTable(const QVector<BenchResult> &results) {
+        std::printf("selected kernel: %s\n",
+                    getChecksumKernelName(getChecksumKernel()));
+        std::printf("benchmark       image          ns/op     cycles "
+                    " allocs/op       MB/s\n");
+
+        for (const BenchResult &result : results) {
+            std::printf("%-15s %-9s %10.2f %10.1f %10.2f %10.1f\n",
+                        result.name.constData(), result.image, result.ns,
+                        result.cycles, result.allocations,
+                        result.bytesPerSecond / 1e6);
+        }
+    }
+
+    /**
+     * Prints the measurements as a JSON document. Cycles are null where
+     * the time stamp counter can't be read.
+     *
+     * @param results The measurements.
+     */
+    void printJSON(const QVector<BenchResult> &results) {
+        std::printf("{\n  \"format\": %d,\n  \"kernel\": \"%s\",\n"
+                    "  \"results\": [\n",
+                    BENCH_FORMAT, getChecksumKernelName(getChecksumKernel()));
+
+        for (int i = 0; i < results.size(); ++i) {
+            const BenchResult &result = results[i];
+            char               cycles[32] = "null";
+
+            if (readCycles() != 0) {
+                std::snprintf(cycles, sizeof(cycles), "%.1f", result.cycles);
+            }
+
+            std::printf("    {\"benchmark\": \"%s\", \"image\": \"%s\", "
+                        "\"iterations\": %d, \"ns_per_op\": %.2f, "
+                        "\"cycles_per_op\": %s, \"allocations_per_op\": %.3f, "
+                        "\"bytes_per_second\": %.0f}%s\n",
+                        result.name.constData(), result.image,
+                        result.iterations, result.ns, cycles,
+                        result.allocations, result.bytesPerSecond,
+                        (i + 1 < results.size()) ? "," : "");
+        }
+
+        std::printf("  ]\n}\n");
+    }
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("lozsrame-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Benchmarks checksumming, loading, saving and naming SRAM files.");
+    parser.addHelpOption();
+    parser.addPositionalArgument(
+        "file",
+        "An SRAM file to benchmark with; the one in the sav directory by "
+        "default.",
+        "[file]");
+
+    QCommandLineOption iterationsOption(
+        QStringList() << "n" << "iterations",
+        "Calls per in-memory benchmark.", "n", "1000000");
+    QCommandLineOption ioIterationsOption(
+        "io-iterations", "Calls per benchmark that loads or saves a file.",
+        "n", "200");
+    QCommandLineOption jsonOption("json", "Print the results as JSON.");
+
+    parser.addOption(iterationsOption);
+    parser.addOption(ioIterationsOption);
+    parser.addOption(jsonOption);
+    parser.process(app);
+
+    const int iterations   = qMax(1, parser.value(iterationsOption).toInt());
+    const int ioIterations = qMax(1, parser.value(ioIterationsOption).toInt());
+
+    QVector<BenchImage> images;
+    BenchImage          synthetic = {"synthetic", QByteArray(SRAM_SIZE, 0),
+                                     QString()};
+
+    makeSynthetic(synthetic.data.data());
+    images.append(synthetic);
+
+    const QString filename = parser.positionalArguments().isEmpty()
+                                 ? QString::fromLocal8Bit(SAMPLE_FILE)
+                                 : parser.positionalArguments().first();
+    QFile         file(filename);
+    BenchImage    sample = {"sample", QByteArray(), QString()};
+
+    if (!file.open(QIODevice::ReadOnly)
+        || ((sample.data = file.readAll()).size() != SRAM_SIZE)) {
+        std::fprintf(stderr, "unable to read a %d byte SRAM file from %s\n",
+                     SRAM_SIZE, QFile::encodeName(filename).constData());
+
+        return 1;
+    }
+
+    images.append(sample);
+
+    // the load and save benchmarks use copies, never the file itself
+    QTemporaryDir directory;
+
+    if (!directory.isValid()) {
+        std::fprintf(stderr, "unable to create a temporary directory\n");
+
+        return 1;
+    }
+
+    for (BenchImage &image : images) {
+        if (!verifyKernels(image.data.constData())) {
+            return 1;
+        }
+
+        image.filename = directory.path() + '/' + image.label + ".sav";
+
+        QFile copy(image.filename);
+
+        if (!copy.open(QIODevice::WriteOnly)
+            || (copy.write(image.data) != SRAM_SIZE)) {
+            std::fprintf(stderr, "unable to write a temporary file\n");
+
+            return 1;
+        }
+    }
+
+    const QString        scratch = directory.path() + "/save.sav";
+    QVector<BenchResult> results;
+
+    try {
+        for (const BenchImage &image : images) {
+            benchImage(image, iterations, ioIterations, scratch, results);
+        }
+    } catch (InvalidSRAMFileException &) {
+        std::fprintf(stderr, "the SRAM file has no valid games\n");
+
+        return 1;
+    }
+
+    if (parser.isSet(jsonOption)) {
+        printJSON(results);
+    } else {
+        printTable(results);
+    }
+
+    return 0;
+}
@@ -0,0 +1,12 @@
+TEMPLATE = app
+TARGET = lozsrame-bench
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+
+include(../../lozsrame.pri)
+
+# the sample save benchmarked when no file is given
+DEFINES += LOZSRAME_SAVDIR=\\\"$$clean_path($$PWD/../../../sav)\\\"
+
+SOURCES += bench.cc
@@ -0,0 +1,399 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cstdio>
+
+#include <QAtomicInteger>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+#include "batch/batchloader.hh"
+#include "batch/workstealingpool.hh"
+#include "model/savearchivereader.hh"
+#include "model/sramfile.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /// running totals shared by all the workers
+    struct Totals {
+        QAtomicInteger<qint64> files, valid, bytes;
+    };
+
+    /**
+     * Prints the result for one SRAM file.
+     *
+     * @param result The result.
+     * @param path The path of the SRAM file.
+     * @param quiet true to only count the result; false to print it.
+     */
+    void report(QByteArray result, const QString &path, bool quiet) {
+        if (!quiet) {
+            result += '\t';
+            result += QFile::encodeName(path);
+            result += '\n';
+
+            std::fwrite(result.constData(), 1, result.size(), stdout);
+        }
+    }
+
+    /**
+     * Validates one SRAM file and prints the result.
+     *
+     * @param load Loads the SRAM file.
+     * @param path The path of the SRAM file.
+     * @param quiet true to only count the result; false to print it.
+     * @param totals The totals to update.
+     */
+    template <typename Loader>
+    void checkSRAM(Loader load, const QString &path, bool quiet,
+                   Totals &totals) {
+        QByteArray result;
+
+        try {
+            SRAMFile sram = load();
+
+            result = "ok\t";
+
+            for (int game = 0; game < 3; ++game) {
+                result += (sram.isValid(game) ? static_cast<char>('1' + game)
+                                              : '-');
+            }
+
+            totals.valid.fetchAndAddRelaxed(1);
+            totals.bytes.fetchAndAddRelaxed(SRAM_SIZE);
+        } catch (InvalidSRAMFileException &e) {
+            switch (e.getError()) {
+                case ISFE_FILENOTFOUND:
+                    result = "error\tunreadable";
+                    break;
+                case ISFE_INVALIDSIZE:
+                    result = "error\tbadsize";
+                    break;
+                case ISFE_NOVALIDGAMES:
+                    result = "error\tnogames";
+                    totals.bytes.fetchAndAddRelaxed(SRAM_SIZE);
+                    break;
+            }
+        }
+
+        totals.files.fetchAndAddRelaxed(1);
+        report(result, path, quiet);
+    }
+
+    /**
+     * Validates one SRAM file on disk and prints the result.
+     *
+     * @param filename The file to validate.
+     * @param mode How to load the file.
+     * @param quiet true to only count the result; false to print it.
+     * @param totals The totals to update.
+     */
+    void checkFile(const QString &filename, enum sf_loadmode mode, bool quiet,
+                   Totals &totals) {
+        checkSRAM([&filename, mode] { return SRAMFile(filename, mode); },
+                  filename, quiet, totals);
+    }
+
+    /**
+     * Validates every SRAM file in a tar or zip archive and prints the
+     * results. Entries are read straight from the archive, so nothing is
+     * extracted to disk.
+     *
+     * @param filename The archive to validate.
+     * @param quiet true to only count the results; false to print them.
+     * @param totals The totals to update.
+     */
+    void checkArchive(const QString &filename, bool quiet, Totals &totals) {
+        QFile file(filename);
+
+        if (!file.open(QIODevice::ReadOnly)) {
+            totals.files.fetchAndAddRelaxed(1);
+            report("error\tunreadable", filename, quiet);
+            return;
+        }
+
+        SaveArchiveReader reader(&file);
+
+        try {
+            while (reader.next()) {
+                const QString path = filename + ':' + reader.getEntryName();
+
+                checkSRAM([&reader] { return reader.getSRAMFile(); }, path,
+                          quiet, totals);
+            }
+        } catch (InvalidArchiveException &e) {
+            QByteArray result;
+
+            switch (e.getError()) {
+                case IAE_READERROR:
+                    result = "error\tunreadable";
+                    break;
+                case IAE_UNKNOWNFORMAT:
+                case IAE_CORRUPT:
+                    result = "error\tbadarchive";
+                    break;
+                case IAE_UNSUPPORTED:
+                    result = "error\tunsupported";
+                    break;
+            }
+
+            totals.files.fetchAndAddRelaxed(1);
+            report(result, filename, quiet);
+        }
+    }
+
+    /**
+     * Checks if a file should be read as an archive.
+     *
+     * @param filename The filename.
+     *
+     * @return true if it is a tar or zip archive; false otherwise.
+     */
+    auto isArchive(const QString &filename) -> bool {
+        return filename.endsWith(".tar", Qt::CaseInsensitive)
+               || filename.endsWith(".zip", Qt::CaseInsensitive);
+    }
+
+    /**
+     * Validates SRAM files read by a batch loader and prints the results.
+     *
+     * @param loader The loader to read the files with.
+     * @param filenames The files to validate.
+     * @param quiet true to only count the results; false to print them.
+     * @param totals The totals to update.
+     */
+    void checkBatch(BatchLoader &loader, const QStringList &filenames,
+                    bool quiet, Totals &totals) {
+        loader.load(filenames, [quiet, &totals](const QString &filename,
+                                                const char *data,
+                                                qint64 size) {
+            checkSRAM(
+                [data, size] {
+                    if (size < 0) {
+                        throw InvalidSRAMFileException(ISFE_FILENOTFOUND);
+                    }
+
+                    return SRAMFile::fromData(data, size);
+                },
+                filename, quiet, totals);
+        });
+    }
+
+    /**
+     * Validates a file, which may be an SRAM file or an archive of them.
+     *
+     * @param filename The file to validate.
+     * @param mode How to load SRAM files.
+     * @param quiet true to only count the results; false to print them.
+     * @param totals The totals to update.
+     */
+    void checkPath(const QString &filename, enum sf_loadmode mode, bool quiet,
+                   Totals &totals) {
+        if (isArchive(filename)) {
+            checkArchive(filename, quiet, totals);
+        } else {
+            checkFile(filename, mode, quiet, totals);
+        }
+    }
+
+    /**
+     * Walks a directory, queueing its subdirectories and matching files as
+     * separate tasks so they spread across the pool.
+     *
+     * @param pool The pool to queue tasks on.
+     * @param path The directory to walk.
+     * @param filters The file name filters.
+     * @param mode How to load the files.
+     * @param quiet true to suppress per file output.
+     * @param totals The totals to update.
+     */
+    void walk(WorkStealingPool &pool, const QString &path,
+              const QStringList &filters, enum sf_loadmode mode, bool quiet,
+              Totals &totals) {
+        QDir dir(path);
+
+        const QStringList subdirs = dir.entryList(
+            QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks,
+            QDir::Unsorted);
+
+        for (const QString &subdir : subdirs) {
+            QString child = dir.filePath(subdir);
+
+            pool.submit([&pool, child, &filters, mode, quiet, &totals] {
+                walk(pool, child, filters, mode, quiet, totals);
+            });
+        }
+
+        const QStringList files =
+            dir.entryList(filters, QDir::Files, QDir::Unsorted);
+
+        for (const QString &file : files) {
+            QString filename = dir.filePath(file);
+
+            pool.submit([filename, mode, quiet, &totals] {
+                checkPath(filename, mode, quiet, totals);
+            });
+        }
+    }
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("lozsrame-check");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Validates Legend of Zelda SRAM files in bulk.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("paths", "Files or directories to check.",
+                                 "paths...");
+
+    QCommandLineOption threadsOption(
+        QStringList() << "j" << "threads", "Number of worker threads.", "n",
+        QString::number(QThread::idealThreadCount()));
+    QCommandLineOption filterOption(
+        QStringList() << "f" << "filter",
+        "File name filter used when walking directories.", "pattern");
+    QCommandLineOption mapOption(QStringList() << "m" << "map",
+                                 "Map files instead of reading them.");
+    QCommandLineOption batchOption(
+        QStringList() << "b" << "batch",
+        "Read SRAM files in batches, through io_uring where available.");
+    QCommandLineOption preadOption(
+        "pread", "With --batch, read with a thread pool instead of io_uring.");
+    QCommandLineOption depthOption(QStringList() << "d" << "queue-depth",
+                                   "Files io_uring keeps in flight.", "n",
+                                   "256");
+    QCommandLineOption quietOption(QStringList() << "q" << "quiet",
+                                   "Only print the summary.");
+
+    filterOption.setDefaultValues(QStringList() << "*.sav" << "*.tar"
+                                                << "*.zip");
+
+    parser.addOption(threadsOption);
+    parser.addOption(filterOption);
+    parser.addOption(mapOption);
+    parser.addOption(batchOption);
+    parser.addOption(preadOption);
+    parser.addOption(depthOption);
+    parser.addOption(quietOption);
+    parser.process(app);
+
+    const QStringList paths = parser.positionalArguments();
+
+    if (paths.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    const QStringList filters = parser.values(filterOption);
+    const bool        quiet   = parser.isSet(quietOption);
+    enum sf_loadmode  mode    = LOAD_COPY;
+    Totals            totals;
+    QElapsedTimer     timer;
+
+    if (parser.isSet(mapOption)) {
+        mode = LOAD_MAP;
+    }
+
+    timer.start();
+
+    if (parser.isSet(batchOption)) {
+        const int   threads = parser.value(threadsOption).toInt();
+        QStringList filenames;
+        BatchLoader loader(parser.isSet(preadOption) ? BACKEND_PREAD
+                                                     : BACKEND_AUTO);
+
+        loader.setQueueDepth(parser.value(depthOption).toInt());
+        loader.setThreadCount(threads * 4);
+
+        // archives are read by the pool while the loader takes the rest
+        WorkStealingPool pool(threads);
+
+        for (const QString &path : paths) {
+            QStringList found;
+
+            if (QFileInfo(path).isDir()) {
+                QDirIterator it(path, filters, QDir::Files,
+                                QDirIterator::Subdirectories);
+
+                while (it.hasNext()) {
+                    found << it.next();
+                }
+            } else {
+                found << path;
+            }
+
+            for (const QString &filename : found) {
+                if (isArchive(filename)) {
+                    pool.submit([filename, quiet, &totals] {
+                        checkArchive(filename, quiet, totals);
+                    });
+                } else {
+                    filenames << filename;
+                }
+            }
+        }
+
+        checkBatch(loader, filenames, quiet, totals);
+        pool.waitForDone();
+
+        std::fflush(stdout);
+        std::fprintf(stderr, "read with %s\n",
+                     BatchLoader::getBackendName(loader.getBackend()));
+    } else {
+        WorkStealingPool pool(parser.value(threadsOption).toInt());
+
+        for (const QString &path : paths) {
+            if (QFileInfo(path).isDir()) {
+                pool.submit([&pool, path, &filters, mode, quiet, &totals] {
+                    walk(pool, path, filters, mode, quiet, totals);
+                });
+            } else {
+                pool.submit([path, mode, quiet, &totals] {
+                    checkPath(path, mode, quiet, totals);
+                });
+            }
+        }
+
+        pool.waitForDone();
+    }
+
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    const qint64 files   = totals.files.loadAcquire();
+    const qint64 valid   = totals.valid.loadAcquire();
+    const qint64 bytes   = totals.bytes.loadAcquire();
+    const double rate    = (seconds > 0) ? (files / seconds) : 0;
+    const double mbps    = (seconds > 0) ? (bytes / seconds / 1e6) : 0;
+
+    std::fflush(stdout);
+    std::fprintf(stderr,
+                 "%lld files, %lld valid, %lld invalid in %.3f s "
+                 "(%.0f files/s, %.1f MB/s)\n",
+                 static_cast<long long>(files), static_cast<long long>(valid),
+                 static_cast<long long>(files - valid), seconds, rate, mbps);
+
+    return (files == valid) ? 0 : 1;
+}
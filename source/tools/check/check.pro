@@ -0,0 +1,19 @@
+TEMPLATE = app
+TARGET = lozsrame-check
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+LIBS += -lz
+
+include(../../lozsrame.pri)
+
+HEADERS += ../../batch/batchloader.hh \
+	../../batch/workstealingpool.hh \
+	../../exceptions/invalidarchiveexception.hh \
+	../../model/savearchivereader.hh
+
+SOURCES += check.cc \
+	../../batch/batchloader.cc \
+	../../batch/workstealingpool.cc \
+	../../exceptions/invalidarchiveexception.cc \
+	../../model/savearchivereader.cc
@@ -0,0 +1,207 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cstdio>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+#include "model/mapstate.hh"
+#include "model/savecorpus.hh"
+#include "model/sramfile.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /**
+     * Adds an SRAM file to a corpus.
+     *
+     * @param writer The corpus to add to.
+     * @param filename The SRAM file.
+     *
+     * @return true if the file was added; false if it isn't valid.
+     */
+    auto addFile(SaveCorpusWriter &writer, const QString &filename) -> bool {
+        try {
+            SRAMFile sram(filename, LOAD_MAP);
+
+            writer.add(sram);
+        } catch (InvalidSRAMFileException &) {
+            std::fprintf(stderr, "skipped %s\n",
+                         QFile::encodeName(filename).constData());
+
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Builds a corpus from SRAM files and directories of them.
+     *
+     * @param output The corpus file to write.
+     * @param paths The files and directories to read.
+     *
+     * @return The exit code.
+     */
+    auto build(const QString &output, const QStringList &paths) -> int {
+        SaveCorpusWriter writer;
+        qint64           files = 0, skipped = 0;
+
+        for (const QString &path : paths) {
+            if (!QFileInfo(path).isDir()) {
+                ++files;
+                skipped += !addFile(writer, path);
+
+                continue;
+            }
+
+            QDirIterator it(path, QStringList() << "*.sav", QDir::Files,
+                            QDirIterator::Subdirectories);
+
+            while (it.hasNext()) {
+                ++files;
+                skipped += !addFile(writer, it.next());
+            }
+        }
+
+        if (!writer.save(output)) {
+            std::fprintf(stderr, "unable to write %s\n",
+                         QFile::encodeName(output).constData());
+
+            return 1;
+        }
+
+        std::fprintf(stderr, "%lld files, %lld skipped, %lld games\n",
+                     static_cast<long long>(files),
+                     static_cast<long long>(skipped),
+                     static_cast<long long>(writer.getRowCount()));
+
+        return 0;
+    }
+
+    /**
+     * Prints some aggregate statistics about a corpus.
+     *
+     * @param filename The corpus file.
+     *
+     * @return The exit code.
+     */
+    auto stats(const QString &filename) -> int {
+        try {
+            SaveCorpus    corpus(filename);
+            QElapsedTimer timer;
+            qint64        hearts[256];
+
+            timer.start();
+
+            const qint64 rows    = corpus.getRowCount();
+            const qint64 second  = corpus.count(COLUMN_QUEST, QUEST_SECOND);
+            const qint64 key     =
+                corpus.countAll(COLUMN_ITEMS, getItemBit(ITEM_MAGICKEY));
+            const qint64 rupees  = corpus.sum(COLUMN_RUPEES);
+            const qint64 screens = corpus.sum(COLUMN_SCREENS);
+            const qint64 rooms   = corpus.sum(COLUMN_ROOMS);
+
+            corpus.histogram(COLUMN_HEARTCONTAINERS, hearts);
+
+            const double ms    = timer.nsecsElapsed() / 1e6;
+            const double total = (rows > 0) ? rows : 1;
+
+            std::printf("%s (%s kernel)\n",
+                        QFile::encodeName(filename).constData(),
+                        getChecksumKernelName(corpus.getKernel()));
+            std::printf("  games          %lld\n",
+                        static_cast<long long>(rows));
+            std::printf("  second quest   %.1f%%\n", second * 100 / total);
+            std::printf("  magic key      %.1f%%\n", key * 100 / total);
+            std::printf("  mean rupees    %.1f\n", rupees / total);
+            std::printf("  overworld      %.1f%% explored\n",
+                        screens * 100 / (total * MAP_ROOMS));
+            std::printf("  rooms cleared  %.1f\n", rooms / total);
+            std::printf("  heart containers\n");
+
+            for (int value = 0; value < 256; ++value) {
+                if (hearts[value] > 0) {
+                    std::printf("    %3d          %lld\n", value,
+                                static_cast<long long>(hearts[value]));
+                }
+            }
+
+            std::printf("  scanned in %.3f ms\n", ms);
+        } catch (InvalidCorpusException &e) {
+            std::fprintf(stderr, "%s: %s\n",
+                         QFile::encodeName(filename).constData(),
+                         (e.getError() == ICE_FILENOTFOUND)
+                             ? "unable to read"
+                             : "not a corpus file");
+
+            return 1;
+        }
+
+        return 0;
+    }
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("lozsrame-corpus");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Packs Legend of Zelda SRAM files into a columnar corpus file, or "
+        "prints statistics about one.");
+    parser.addHelpOption();
+    parser.addPositionalArgument(
+        "paths", "SRAM files or directories, or corpus files with --stats.",
+        "paths...");
+
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Corpus file to build.", "file");
+    QCommandLineOption statsOption(QStringList() << "s" << "stats",
+                                   "Print statistics about corpus files.");
+
+    parser.addOption(outputOption);
+    parser.addOption(statsOption);
+    parser.process(app);
+
+    const QStringList paths = parser.positionalArguments();
+
+    if (paths.isEmpty()
+        || (parser.isSet(outputOption) == parser.isSet(statsOption))) {
+        parser.showHelp(1);
+    }
+
+    if (parser.isSet(outputOption)) {
+        return build(parser.value(outputOption), paths);
+    }
+
+    int result = 0;
+
+    for (const QString &path : paths) {
+        result |= stats(path);
+    }
+
+    return result;
+}
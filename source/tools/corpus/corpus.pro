@@ -0,0 +1,14 @@
+TEMPLATE = app
+TARGET = lozsrame-corpus
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+
+include(../../lozsrame.pri)
+
+HEADERS += ../../exceptions/invalidcorpusexception.hh \
+	../../model/savecorpus.hh
+
+SOURCES += corpus.cc \
+	../../exceptions/invalidcorpusexception.cc \
+	../../model/savecorpus.cc
@@ -0,0 +1,603 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cstdio>
+
+#include <functional>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QSet>
+#include <QSharedPointer>
+#include <QVector>
+#include <QtConcurrentRun>
+
+#include "model/editscript.hh"
+#include "model/sramcache.hh"
+#include "model/sramstats.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /// the longest request accepted, so a client can't use up the memory
+    const qint64 MAXIMUM_REQUEST = 65536;
+
+    /**
+     * Makes the response to a request that failed.
+     *
+     * @param error What went wrong.
+     *
+     * @return The response.
+     */
+    QJsonObject failure(const char *error) {
+        QJsonObject response;
+
+        response.insert("ok", false);
+        response.insert("error", QString::fromLatin1(error));
+
+        return response;
+    }
+
+    /**
+     * Makes the response to a request for a file that couldn't be loaded.
+     *
+     * @param error Why it couldn't be loaded.
+     *
+     * @return The response.
+     */
+    QJsonObject failure(enum isfe_error error) {
+        switch (error) {
+            case ISFE_FILENOTFOUND:
+                return failure("notfound");
+            case ISFE_INVALIDSIZE:
+                return failure("invalidsize");
+            case ISFE_NOVALIDGAMES:
+                return failure("novalidgames");
+        }
+
+        return failure("invalid");
+    }
+
+    /// the result of reading or editing a file on the thread pool
+    struct Outcome {
+        /// the file as read or saved, if it can be cached
+        QSharedPointer<SRAMFile> sram;
+
+        /// the identity of the file when it was read or saved
+        SRAMCacheKey key;
+
+        /// the response if it failed
+        QJsonObject failure;
+    };
+
+    /**
+     * Reads fields of a game.
+     *
+     * @param sram The SRAM file.
+     * @param request The request, with the game (1 - 3; the first valid
+     *                one by default) and the fields (all of them by
+     *                default).
+     *
+     * @return The response.
+     */
+    QJsonObject get(SRAMFile &sram, const QJsonObject &request) {
+        QJsonArray valid;
+        int        game = -1;
+
+        for (int i = 0; i < 3; ++i) {
+            valid.append(sram.isValid(i));
+
+            if ((game < 0) && sram.isValid(i)) {
+                game = i;
+            }
+        }
+
+        if (request.contains("game")) {
+            game = request.value("game").toInt() - 1;
+
+            if ((game < 0) || (game > 2) || !sram.isValid(game)) {
+                return failure("badgame");
+            }
+        }
+
+        sram.setGame(game);
+
+        QJsonArray fields = request.value("fields").toArray();
+
+        if (!request.contains("fields")) {
+            fields.append(QString("name"));
+
+            for (const PropertyDescriptor &property : SRAM_PROPERTIES) {
+                fields.append(QString::fromLatin1(property.name));
+            }
+        }
+
+        QJsonObject values;
+
+        for (const QJsonValue &field : fields) {
+            const QString          name     = field.toString();
+            const enum sf_property property =
+                findProperty(name.toLatin1().constData());
+
+            if (name == "name") {
+                values.insert(name, sram.getName().trimmed());
+            } else if (property != PROPERTY_COUNT) {
+                values.insert(name, sram.getProperty(property));
+            } else {
+                return failure("badfield");
+            }
+        }
+
+        QJsonObject response;
+
+        response.insert("ok", true);
+        response.insert("game", game + 1);
+        response.insert("valid", valid);
+        response.insert("fields", values);
+
+        return response;
+    }
+
+    /**
+     * Gets the edit script of an edit request. It is either given as is,
+     * or as the fields to set, named and valued as get returns them.
+     *
+     * @param request The request.
+     *
+     * @return The text of the script.
+     * @throw InvalidEditScriptException if a field name or value would
+     *        break out of its line of the script.
+     */
+    QByteArray getScript(const QJsonObject &request) {
+        if (!request.contains("fields")) {
+            return request.value("script").toString().toUtf8();
+        }
+
+        const QJsonObject fields = request.value("fields").toObject();
+        QByteArray        script;
+        int               number = 0;
+
+        for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+            QByteArray line = it.key().toUtf8() + ' ';
+
+            if (it.value().isBool()) {
+                line += it.value().toBool() ? "on" : "off";
+            } else if (it.value().isDouble()) {
+                line += QByteArray::number(it.value().toInt());
+            } else {
+                line += it.value().toString().toUtf8();
+            }
+
+            ++number;
+
+            // each field must stay one edit: a line break would add edits
+            // of its own, and a comment would cut this one short
+            if (line.contains('\n') || line.contains('\r')
+                || line.contains('#')) {
+                throw InvalidEditScriptException(IESE_SYNTAX, number);
+            }
+
+            script += line + '\n';
+        }
+
+        return script;
+    }
+
+    /**
+     * Reads a file which isn't cached. This runs on the thread pool.
+     *
+     * @param filename The SRAM filename.
+     *
+     * @return The file.
+     */
+    Outcome readFile(const QString &filename) {
+        Outcome outcome = {};
+
+        try {
+            // identified before reading, so a change made while reading
+            // makes the next lookup read it again
+            outcome.key  = SRAMCache::identify(filename);
+            outcome.sram = QSharedPointer<SRAMFile>(new SRAMFile(filename));
+        } catch (InvalidSRAMFileException &e) {
+            outcome.failure = failure(e.getError());
+        }
+
+        return outcome;
+    }
+
+    /**
+     * Applies an edit script to every valid game of a file and saves it.
+     * This runs on the thread pool.
+     *
+     * @param filename The SRAM filename.
+     * @param script The edit script.
+     * @param sram A copy of the cached file, or null to read it.
+     *
+     * @return The file as saved.
+     */
+    Outcome editFile(const QString &filename, const EditScript &script,
+                     QSharedPointer<SRAMFile> sram) {
+        Outcome outcome = {};
+
+        try {
+            if (!sram) {
+                sram = QSharedPointer<SRAMFile>(new SRAMFile(filename));
+            }
+
+            script.apply(*sram);
+
+            const QByteArray data = sram->toData();
+
+            if (!sram->save(filename)) {
+                outcome.failure = failure("unwritable");
+
+                return outcome;
+            }
+
+            // start over from what was saved, so the undo history of a
+            // file that stays cached doesn't grow with every edit
+            outcome.sram = QSharedPointer<SRAMFile>(
+                new SRAMFile(SRAMFile::fromData(data.constData(), data.size(),
+                                                sram->getValidation())));
+        } catch (InvalidSRAMFileException &e) {
+            outcome.failure = failure(e.getError());
+
+            return outcome;
+        }
+
+        try {
+            outcome.key = SRAMCache::identify(filename);
+        } catch (InvalidSRAMFileException &) {
+            // gone already, so there's nothing to cache
+            outcome.sram.reset();
+        }
+
+        return outcome;
+    }
+
+    /**
+     * Reports the cache and SRAM statistics.
+     *
+     * @param cache The cache.
+     *
+     * @return The response.
+     */
+    QJsonObject stats(const SRAMCache &cache) {
+        QJsonObject counts;
+
+        counts.insert("files", cache.getCount());
+        counts.insert("capacity", cache.getCapacity());
+        counts.insert("hits", static_cast<double>(cache.getHits()));
+        counts.insert("misses", static_cast<double>(cache.getMisses()));
+
+        QJsonObject response;
+
+        response.insert("ok", true);
+        response.insert("cache", counts);
+        response.insert("prometheus",
+                        QString::fromLatin1(SRAMStats::toPrometheus(
+                            SRAMStats::snapshot())));
+
+        return response;
+    }
+
+    /**
+     * Answers the requests of every client. All of this runs on the main
+     * thread, which owns the cache: a get of a cached file is answered at
+     * once, while reading a file that isn't cached and saving an edit run
+     * on the thread pool, so a slow disk only holds up the clients waiting
+     * on it. Each client's requests are answered in order, and requests
+     * for a file wait while it is being read or edited.
+     */
+    class Daemon {
+      private:
+        SRAMCache cache;
+
+        /// clients waiting on the thread pool
+        QSet<QLocalSocket *> busy;
+
+        /// files being read or edited, with the requests waiting on them
+        QHash<QString, QVector<std::function<void()>>> running;
+
+        /**
+         * Sends the response to a request.
+         *
+         * @param socket The client.
+         * @param request The request.
+         * @param response The response.
+         */
+        void reply(QLocalSocket *socket, const QJsonObject &request,
+                   QJsonObject response);
+
+        /**
+         * Reads or edits a file on the thread pool, then answers the
+         * request and resumes the client.
+         *
+         * @param socket The client.
+         * @param request The request.
+         * @param filename The file.
+         * @param work Reads or edits the file, on the thread pool.
+         * @param finish Makes the response from what work did, after the
+         *               cache has been updated.
+         */
+        void start(QLocalSocket *socket, const QJsonObject &request,
+                   const QString &filename,
+                   const std::function<Outcome()> &work,
+                   const std::function<QJsonObject(SRAMFile *)> &finish);
+
+        /**
+         * Handles one request.
+         *
+         * @param socket The client.
+         * @param line The request, a JSON object on one line.
+         */
+        void handle(QLocalSocket *socket, const QByteArray &line);
+
+      public:
+        /**
+         * Creates a new Daemon.
+         *
+         * @param capacity The most files to keep loaded.
+         */
+        explicit Daemon(int capacity);
+
+        /**
+         * Handles the whole requests a client has sent so far, stopping
+         * at one that must wait.
+         *
+         * @param socket The client.
+         */
+        void serve(QLocalSocket *socket);
+
+        /**
+         * Forgets a client that has gone away.
+         *
+         * @param socket The client.
+         */
+        void forget(QLocalSocket *socket);
+    };
+
+    Daemon::Daemon(int capacity) : cache(capacity) {}
+
+    void Daemon::reply(QLocalSocket *socket, const QJsonObject &request,
+                       QJsonObject response) {
+        // so a client with several requests in flight can match them up
+        if (request.contains("id")) {
+            response.insert("id", request.value("id"));
+        }
+
+        socket->write(QJsonDocument(response).toJson(QJsonDocument::Compact)
+                      + '\n');
+    }
+
+    void Daemon::start(QLocalSocket *socket, const QJsonObject &request,
+                       const QString &filename,
+                       const std::function<Outcome()> &work,
+                       const std::function<QJsonObject(SRAMFile *)> &finish) {
+        auto                  *watcher = new QFutureWatcher<Outcome>();
+        QPointer<QLocalSocket> client(socket);
+
+        busy.insert(socket);
+        running.insert(filename, QVector<std::function<void()>>());
+
+        QObject::connect(
+            watcher, &QFutureWatcher<Outcome>::finished,
+            [this, watcher, client, request, filename, finish]() {
+                const Outcome outcome = watcher->result();
+                SRAMFile     *sram    = nullptr;
+
+                watcher->deleteLater();
+
+                if (outcome.sram) {
+                    sram = &cache.insert(filename, outcome.key, *outcome.sram);
+                }
+
+                const QJsonObject response =
+                    outcome.failure.isEmpty() ? finish(sram) : outcome.failure;
+
+                if (client) {
+                    busy.remove(client);
+                    reply(client, request, response);
+                }
+
+                // the waiting requests go in order; any that reads or edits
+                // the file again makes the rest wait on it once more
+                for (const auto &resume : running.take(filename)) {
+                    resume();
+                }
+
+                if (client) {
+                    serve(client);
+                }
+            });
+
+        watcher->setFuture(QtConcurrent::run(work));
+    }
+
+    void Daemon::handle(QLocalSocket *socket, const QByteArray &line) {
+        const QJsonDocument document = QJsonDocument::fromJson(line);
+        const QJsonObject   request  = document.object();
+        const QString       op       = request.value("op").toString();
+        const QString       filename = request.value("file").toString();
+
+        if (!document.isObject()) {
+            reply(socket, request, failure("badrequest"));
+
+            return;
+        }
+
+        if (op == "stats") {
+            reply(socket, request, stats(cache));
+
+            return;
+        }
+
+        if ((op != "get") && (op != "edit")) {
+            reply(socket, request, failure("badop"));
+
+            return;
+        }
+
+        if (running.contains(filename)) {
+            QPointer<QLocalSocket> client(socket);
+
+            busy.insert(socket);
+            running[filename].append([this, client, line]() {
+                if (client) {
+                    busy.remove(client);
+                    handle(client, line);
+                    serve(client);
+                }
+            });
+
+            return;
+        }
+
+        try {
+            SRAMFile *sram = cache.find(filename);
+
+            if (op == "get") {
+                if (sram) {
+                    reply(socket, request, get(*sram, request));
+                } else {
+                    start(socket, request, filename,
+                          [filename]() { return readFile(filename); },
+                          [request](SRAMFile *loaded) {
+                              return get(*loaded, request);
+                          });
+                }
+
+                return;
+            }
+
+            const EditScript script =
+                EditScript::fromText(getScript(request));
+            QSharedPointer<SRAMFile> copy;
+
+            // edited and saved as a copy, so the cached file stays as it
+            // is on disk until the save is done
+            if (sram) {
+                copy = QSharedPointer<SRAMFile>(new SRAMFile(*sram));
+            }
+
+            start(socket, request, filename,
+                  [filename, script, copy]() {
+                      return editFile(filename, script, copy);
+                  },
+                  [script](SRAMFile *) {
+                      QJsonObject response;
+
+                      response.insert("ok", true);
+                      response.insert("edits", script.getEditCount());
+
+                      return response;
+                  });
+        } catch (InvalidSRAMFileException &e) {
+            reply(socket, request, failure(e.getError()));
+        } catch (InvalidEditScriptException &) {
+            reply(socket, request, failure("badscript"));
+        }
+    }
+
+    void Daemon::serve(QLocalSocket *socket) {
+        while (!busy.contains(socket) && socket->canReadLine()) {
+            handle(socket, socket->readLine().trimmed());
+        }
+
+        // the read buffer holds one request at most, so a full buffer
+        // without a whole line is a request that's too long
+        if (!socket->canReadLine()
+            && (socket->bytesAvailable() >= MAXIMUM_REQUEST)) {
+            socket->abort();
+        }
+    }
+
+    void Daemon::forget(QLocalSocket *socket) {
+        busy.remove(socket);
+    }
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("lozsrame-daemon");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Answers queries about and edits to SRAM files over a local socket, "
+        "keeping the files used most recently loaded.");
+    parser.addHelpOption();
+
+    QCommandLineOption socketOption(QStringList() << "s" << "socket",
+                                    "Name or path of the socket.", "name",
+                                    "lozsrame");
+    QCommandLineOption cacheOption(QStringList() << "c" << "cache",
+                                   "Most SRAM files to keep loaded.", "n",
+                                   "1024");
+
+    parser.addOption(socketOption);
+    parser.addOption(cacheOption);
+    parser.process(app);
+
+    Daemon       daemon(parser.value(cacheOption).toInt());
+    QLocalServer server;
+
+    // a socket left behind by a daemon that didn't shut down cleanly
+    QLocalServer::removeServer(parser.value(socketOption));
+    server.setSocketOptions(QLocalServer::UserAccessOption);
+
+    if (!server.listen(parser.value(socketOption))) {
+        std::fprintf(stderr, "unable to listen on %s: %s\n",
+                     qPrintable(parser.value(socketOption)),
+                     qPrintable(server.errorString()));
+
+        return 1;
+    }
+
+    QObject::connect(&server, &QLocalServer::newConnection, [&]() {
+        while (server.hasPendingConnections()) {
+            QLocalSocket *socket = server.nextPendingConnection();
+
+            // a client waiting on the thread pool isn't read from, so
+            // bounding the buffer holds back one that keeps on sending
+            socket->setReadBufferSize(MAXIMUM_REQUEST);
+
+            QObject::connect(socket, &QLocalSocket::readyRead,
+                             [&daemon, socket]() { daemon.serve(socket); });
+            QObject::connect(socket, &QObject::destroyed,
+                             [&daemon, socket]() { daemon.forget(socket); });
+            QObject::connect(socket, &QLocalSocket::disconnected, socket,
+                             &QObject::deleteLater);
+        }
+    });
+
+    std::printf("listening on %s\n", qPrintable(server.fullServerName()));
+    std::fflush(stdout);
+
+    return app.exec();
+}
@@ -0,0 +1,17 @@
+TEMPLATE = app
+TARGET = lozsrame-daemon
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+QT += concurrent network
+
+include(../../lozsrame.pri)
+
+HEADERS += ../../exceptions/invalideditscriptexception.hh \
+	../../model/editscript.hh \
+	../../model/sramcache.hh
+
+SOURCES += daemon.cc \
+	../../exceptions/invalideditscriptexception.cc \
+	../../model/editscript.cc \
+	../../model/sramcache.cc
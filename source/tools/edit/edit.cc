@@ -0,0 +1,199 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cstdio>
+
+#include <QAtomicInteger>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QFileInfo>
+
+#include "batch/editpipeline.hh"
+#include "model/editscript.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /**
+     * Prints the result for one file.
+     *
+     * @param filename The file.
+     * @param status What happened to the file.
+     */
+    void report(const QString &filename, enum ep_status status) {
+        QByteArray result;
+
+        switch (status) {
+            case STATUS_OK:
+                result = "ok";
+                break;
+            case STATUS_UNREADABLE:
+                result = "error\tunreadable";
+                break;
+            case STATUS_INVALID:
+                result = "error\tinvalid";
+                break;
+            case STATUS_UNWRITABLE:
+                result = "error\tunwritable";
+                break;
+            case STATUS_CONFLICT:
+                result = "error\tconflict";
+                break;
+        }
+
+        result += '\t';
+        result += QFile::encodeName(filename);
+        result += '\n';
+
+        std::fwrite(result.constData(), 1, result.size(), stdout);
+    }
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("lozsrame-edit");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Applies an edit script to every game in many SRAM files.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("paths", "Files or directories to edit.",
+                                 "paths...");
+
+    QCommandLineOption scriptOption(QStringList() << "s" << "script",
+                                    "Edit script to apply.", "file");
+    QCommandLineOption outputOption(
+        QStringList() << "o" << "output",
+        "Directory to write edited files to, instead of in place.",
+        "directory");
+    QCommandLineOption filterOption(
+        QStringList() << "f" << "filter",
+        "File name filter used when walking directories.", "pattern", "*.sav");
+    QCommandLineOption readOption("read-threads", "Threads reading files.",
+                                  "n", "4");
+    QCommandLineOption writeOption("write-threads", "Threads writing files.",
+                                   "n", "4");
+    QCommandLineOption depthOption(QStringList() << "d" << "queue-depth",
+                                   "Files queued between stages.", "n", "64");
+    QCommandLineOption batchOption(QStringList() << "b" << "batch-size",
+                                   "Files each write thread syncs at once.",
+                                   "n", "64");
+    QCommandLineOption quietOption(QStringList() << "q" << "quiet",
+                                   "Only print the summary.");
+
+    parser.addOption(scriptOption);
+    parser.addOption(outputOption);
+    parser.addOption(filterOption);
+    parser.addOption(readOption);
+    parser.addOption(writeOption);
+    parser.addOption(depthOption);
+    parser.addOption(batchOption);
+    parser.addOption(quietOption);
+    parser.process(app);
+
+    const QStringList paths = parser.positionalArguments();
+
+    if (paths.isEmpty() || !parser.isSet(scriptOption)) {
+        parser.showHelp(1);
+    }
+
+    QStringList filenames;
+
+    for (const QString &path : paths) {
+        if (!QFileInfo(path).isDir()) {
+            filenames << path;
+            continue;
+        }
+
+        QDirIterator it(path, parser.values(filterOption), QDir::Files,
+                        QDirIterator::Subdirectories);
+
+        while (it.hasNext()) {
+            filenames << it.next();
+        }
+    }
+
+    try {
+        const EditScript       script(parser.value(scriptOption));
+        EditPipeline           pipeline(script);
+        QAtomicInteger<qint64> failed(0);
+        const bool             quiet = parser.isSet(quietOption);
+
+        pipeline.setOutputDirectory(parser.value(outputOption));
+        pipeline.setQueueDepth(parser.value(depthOption).toInt());
+        pipeline.setBatchSize(parser.value(batchOption).toInt());
+        pipeline.setThreadCount(STAGE_READ, parser.value(readOption).toInt());
+        pipeline.setThreadCount(STAGE_WRITE,
+                                parser.value(writeOption).toInt());
+        pipeline.setReporter(
+            [&failed, quiet](const QString &filename, enum ep_status status) {
+                if (status != STATUS_OK) {
+                    failed.fetchAndAddRelaxed(1);
+                }
+
+                if (!quiet) {
+                    report(filename, status);
+                }
+            });
+
+        pipeline.run(filenames);
+
+        const double seconds = pipeline.getElapsedTime() / 1e9;
+        const qint64 files   = filenames.size();
+
+        std::fflush(stdout);
+        std::fprintf(stderr,
+                     "stage     threads    files    busy s    files/s\n");
+
+        // a stage's rate is what its threads could sustain if never idle
+        for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+            auto         s       = static_cast<enum ep_stage>(stage);
+            const qint64 items   = pipeline.getStageItems(s);
+            const double busy    = pipeline.getStageTime(s) / 1e9;
+            const int    threads = pipeline.getThreadCount(s);
+            const double rate    = (busy > 0) ? (items * threads / busy) : 0;
+
+            std::fprintf(stderr, "%-8s %8d %8lld %9.3f %10.0f\n",
+                         EditPipeline::getStageName(s), threads,
+                         static_cast<long long>(items), busy, rate);
+        }
+
+        std::fprintf(stderr,
+                     "%lld files, %lld edited, %lld failed in %.3f s "
+                     "(%.0f files/s)\n",
+                     static_cast<long long>(files),
+                     static_cast<long long>(files - failed.loadAcquire()),
+                     static_cast<long long>(failed.loadAcquire()), seconds,
+                     (seconds > 0) ? (files / seconds) : 0);
+
+        return (failed.loadAcquire() == 0) ? 0 : 1;
+    } catch (InvalidEditScriptException &e) {
+        if (e.getError() == IESE_FILENOTFOUND) {
+            std::fprintf(stderr, "unable to read the edit script\n");
+        } else {
+            std::fprintf(stderr, "edit script error on line %d\n",
+                         e.getLine());
+        }
+
+        return 1;
+    }
+}
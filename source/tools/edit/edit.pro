@@ -0,0 +1,19 @@
+TEMPLATE = app
+TARGET = lozsrame-edit
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+
+include(../../lozsrame.pri)
+
+HEADERS += ../../batch/boundedqueue.hh \
+	../../batch/editpipeline.hh \
+	../../batch/savebatch.hh \
+	../../exceptions/invalideditscriptexception.hh \
+	../../model/editscript.hh
+
+SOURCES += edit.cc \
+	../../batch/editpipeline.cc \
+	../../batch/savebatch.cc \
+	../../exceptions/invalideditscriptexception.cc \
+	../../model/editscript.cc
@@ -0,0 +1,253 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cstdio>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+
+#include "model/savestore.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /**
+     * Adds an SRAM file to a store.
+     *
+     * @param store The store to add to.
+     * @param filename The SRAM file.
+     *
+     * @return true if the file was added; false otherwise.
+     */
+    auto addFile(SaveStore &store, const QString &filename) -> bool {
+        const char *error = nullptr;
+
+        try {
+            store.addFile(filename);
+        } catch (InvalidSRAMFileException &e) {
+            error = (e.getError() == ISFE_FILENOTFOUND) ? "unreadable"
+                                                         : "badsize";
+        } catch (InvalidSaveStoreException &) {
+            error = "collision";
+        }
+
+        if (error) {
+            std::fprintf(stderr, "skipped %s (%s)\n",
+                         QFile::encodeName(filename).constData(), error);
+
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Builds a store from SRAM files and directories of them.
+     *
+     * @param output The store file to write.
+     * @param paths The files and directories to read.
+     *
+     * @return The exit code.
+     */
+    auto build(const QString &output, const QStringList &paths) -> int {
+        SaveStore store;
+        qint64    files = 0, skipped = 0, valid = 0;
+
+        for (const QString &path : paths) {
+            if (!QFileInfo(path).isDir()) {
+                ++files;
+                skipped += !addFile(store, path);
+
+                continue;
+            }
+
+            QDirIterator it(path, QStringList() << "*.sav", QDir::Files,
+                            QDirIterator::Subdirectories);
+
+            while (it.hasNext()) {
+                ++files;
+                skipped += !addFile(store, it.next());
+            }
+        }
+
+        // duplicates reuse the first copy's validation
+        for (const QString &path : store.getPaths()) {
+            valid += store.isValid(store.getHash(path));
+        }
+
+        if (!store.save(output)) {
+            std::fprintf(stderr, "unable to write %s\n",
+                         QFile::encodeName(output).constData());
+
+            return 1;
+        }
+
+        const qint64 added = store.getPathCount();
+        const qint64 dupes = added - store.getImageCount();
+
+        std::fprintf(stderr,
+                     "%lld files, %lld skipped, %lld valid\n"
+                     "%d unique images, %lld duplicates (%.1f%%)\n"
+                     "%lld checksummed, %lld validations reused\n",
+                     static_cast<long long>(files),
+                     static_cast<long long>(skipped),
+                     static_cast<long long>(valid), store.getImageCount(),
+                     static_cast<long long>(dupes),
+                     (added > 0) ? (dupes * 100.0 / added) : 0.0,
+                     static_cast<long long>(store.getValidationCount()),
+                     static_cast<long long>(store.getReuseCount()));
+
+        return 0;
+    }
+
+    /**
+     * Opens a store file, printing an error if it can't be read.
+     *
+     * @param filename The store file.
+     * @param store Set to the store.
+     *
+     * @return true if the store was read; false otherwise.
+     */
+    auto open(const QString &filename, SaveStore &store) -> bool {
+        try {
+            store = SaveStore(filename);
+        } catch (InvalidSaveStoreException &e) {
+            std::fprintf(stderr, "%s: %s\n",
+                         QFile::encodeName(filename).constData(),
+                         (e.getError() == ISSE_FILENOTFOUND)
+                             ? "unable to read"
+                             : "not a store file");
+
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Prints the hash, validity, and path of every file in a store.
+     *
+     * @param filename The store file.
+     *
+     * @return The exit code.
+     */
+    auto list(const QString &filename) -> int {
+        SaveStore store;
+
+        if (!open(filename, store)) {
+            return 1;
+        }
+
+        for (const QString &path : store.getPaths()) {
+            const SaveHash hash = store.getHash(path);
+
+            std::printf("%s\t%s\t%s\n", hash.toString().toLatin1().constData(),
+                        store.isValid(hash) ? "ok" : "nogames",
+                        QFile::encodeName(path).constData());
+        }
+
+        return 0;
+    }
+
+    /**
+     * Writes each unique image in a store to a directory, named by its
+     * hash.
+     *
+     * @param filename The store file.
+     * @param directory The directory to write to.
+     *
+     * @return The exit code.
+     */
+    auto extract(const QString &filename, const QString &directory) -> int {
+        SaveStore store;
+
+        if (!open(filename, store)) {
+            return 1;
+        }
+
+        const QDir dir(directory);
+
+        for (const SaveHash &hash : store.getHashes()) {
+            QFile file(dir.filePath(hash.toString() + ".sav"));
+
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+                || (file.write(store.getData(hash)) != SRAM_SIZE)) {
+                std::fprintf(stderr, "unable to write %s\n",
+                             QFile::encodeName(file.fileName()).constData());
+
+                return 1;
+            }
+        }
+
+        std::fprintf(stderr, "%d images written\n", store.getImageCount());
+
+        return 0;
+    }
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("lozsrame-store");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Packs Legend of Zelda SRAM files into a deduplicated store file, "
+        "or lists or extracts one.");
+    parser.addHelpOption();
+    parser.addPositionalArgument(
+        "paths", "SRAM files or directories, or a store file.", "paths...");
+
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Store file to build.", "file");
+    QCommandLineOption listOption(QStringList() << "l" << "list",
+                                  "List the files in a store.");
+    QCommandLineOption extractOption(
+        QStringList() << "x" << "extract",
+        "Write each unique image in a store to a directory.", "directory");
+
+    parser.addOption(outputOption);
+    parser.addOption(listOption);
+    parser.addOption(extractOption);
+    parser.process(app);
+
+    const QStringList paths = parser.positionalArguments();
+    const int         modes = parser.isSet(outputOption)
+                              + parser.isSet(listOption)
+                              + parser.isSet(extractOption);
+
+    if (paths.isEmpty() || (modes != 1)
+        || (!parser.isSet(outputOption) && (paths.size() != 1))) {
+        parser.showHelp(1);
+    }
+
+    if (parser.isSet(outputOption)) {
+        return build(parser.value(outputOption), paths);
+    }
+
+    if (parser.isSet(listOption)) {
+        return list(paths.first());
+    }
+
+    return extract(paths.first(), parser.value(extractOption));
+}
@@ -0,0 +1,14 @@
+TEMPLATE = app
+TARGET = lozsrame-store
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+
+include(../../lozsrame.pri)
+
+HEADERS += ../../exceptions/invalidsavestoreexception.hh \
+	../../model/savestore.hh
+
+SOURCES += store.cc \
+	../../exceptions/invalidsavestoreexception.cc \
+	../../model/savestore.cc
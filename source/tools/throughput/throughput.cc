@@ -0,0 +1,410 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include <QAtomicInt>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#ifdef Q_OS_WIN
+    #include <windows.h>
+    #include <psapi.h>
+#elif !defined(Q_OS_LINUX)
+    #include <sys/resource.h>
+#endif
+
+#include "batch/workstealingpool.hh"
+#include "exceptions/invalidsramfileexception.hh"
+#include "model/checksum.hh"
+#include "model/sramfile.hh"
+#include "model/sramstats.hh"
+
+using namespace lozsrame;
+
+namespace {
+    /// characters the generated names are made of
+    const char NAME_CHARACTERS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+    /// a measurement of one pass over the corpus
+    struct RoundResult {
+        int    threads;
+        int    failed;
+        double seconds;
+        qint64 p50, p99;
+        qint64 peakRSS;
+    };
+
+    /**
+     * Gets the most memory the process has had resident, since the last
+     * call to resetPeakRSS() where the system allows it to be reset.
+     *
+     * @return The peak resident set size in bytes, or 0 if unknown.
+     */
+    qint64 getPeakRSS() {
+#if defined(Q_OS_WIN)
+        PROCESS_MEMORY_COUNTERS counters;
+
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                                  sizeof(counters))) {
+            return 0;
+        }
+
+        return static_cast<qint64>(counters.PeakWorkingSetSize);
+#elif defined(Q_OS_LINUX)
+        // unlike getrusage, VmHWM can be reset between rounds
+        std::FILE *status = std::fopen("/proc/self/status", "r");
+        char       line[128];
+        long long  kilobytes = 0;
+
+        if (!status) {
+            return 0;
+        }
+
+        while (std::fgets(line, sizeof(line), status)) {
+            if (std::sscanf(line, "VmHWM: %lld kB", &kilobytes) == 1) {
+                break;
+            }
+        }
+
+        std::fclose(status);
+
+        return kilobytes * 1024;
+#else
+        struct rusage usage;
+
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+
+    #ifdef Q_OS_MACOS
+        return usage.ru_maxrss;
+    #else
+        return static_cast<qint64>(usage.ru_maxrss) * 1024;
+    #endif
+#endif
+    }
+
+    /**
+     * Resets the peak resident set size to the current one, so each round
+     * reports its own peak. Only Linux allows this; elsewhere the peak
+     * covers the whole run.
+     */
+    void resetPeakRSS() {
+#ifdef Q_OS_LINUX
+        if (std::FILE *refs = std::fopen("/proc/self/clear_refs", "w")) {
+            std::fputs("5", refs);
+            std::fclose(refs);
+        }
+#endif
+    }
+
+    /**
+     * Stores a checksum for every game in an image, making them all valid.
+     *
+     * @param data The SRAM image.
+     */
+    void storeChecksums(char *data) {
+        for (int game = 0; game < 3; ++game) {
+            const quint16 sum    = slotChecksum(data, game);
+            const int     offset = CHECKSUM_OFFSET + (game * 2);
+
+            data[offset]     = static_cast<char>(sum >> 8);
+            data[offset + 1] = static_cast<char>(sum & 0xFF);
+        }
+    }
+
+    /**
+     * Fills all of a game's map data in an image with random room flags.
+     * SRAMFile has no setters for rooms, so these are written directly,
+     * before the image is loaded.
+     *
+     * @param data The SRAM image.
+     * @param game The game.
+     * @param random The random number generator.
+     */
+    void randomizeRooms(char *data, int game, std::mt19937 &random) {
+        // MAP_DATA_SIZE is one game's worth: the overworld, levels 1 - 6
+        // and levels 7 - 9 maps, MAP_ROOMS bytes each
+        char *rooms = data + MAP_DATA + (game * MAP_DATA_SIZE);
+
+        for (int room = 0; room < MAP_DATA_SIZE; ++room) {
+            // the doors and the visited, cleared and item flags
+            rooms[room] = static_cast<char>(random() & 0x7F);
+        }
+    }
+
+    /**
+     * Writes a corpus of valid SRAM files with random games. The same
+     * seed always gives the same corpus.
+     *
+     * @param directory The directory to write to.
+     * @param files The number of files.
+     * @param seed The random seed.
+     *
+     * @return The filenames, or an empty list if a file couldn't be written.
+     */
+    QStringList generateCorpus(const QString &directory, int files,
+                               quint32 seed) {
+        std::mt19937 random(seed);
+        QStringList  filenames;
+
+        for (int i = 0; i < files; ++i) {
+            // the names start out as zeros, which isn't an empty game
+            QByteArray image(SRAM_SIZE, '\0');
+
+            for (int game = 0; game < 3; ++game) {
+                randomizeRooms(image.data(), game, random);
+            }
+
+            storeChecksums(image.data());
+
+            // everything else goes through the setters
+            SRAMFile sram = SRAMFile::fromData(image.constData(), SRAM_SIZE);
+
+            for (int game = 0; game < 3; ++game) {
+                sram.setGame(game);
+
+                // leave some games empty after the first
+                if ((game > 0) && ((random() % 3) == 0)) {
+                    sram.setName("        ");
+                    continue;
+                }
+
+                QString name(NAME_CHARACTERS[random() % 26]);
+                const int length = 1 + (random() % NAME_DATA_SIZE);
+
+                while (name.length() < length) {
+                    name += NAME_CHARACTERS[random()
+                                            % (sizeof(NAME_CHARACTERS) - 1)];
+                }
+
+                sram.setName(name);
+
+                for (int p = 0; p < PROPERTY_COUNT; ++p) {
+                    const PropertyDescriptor &descriptor = SRAM_PROPERTIES[p];
+                    const int range =
+                        descriptor.maximum - descriptor.minimum + 1;
+
+                    sram.setProperty(descriptor.property,
+                                     descriptor.minimum + (random() % range));
+                }
+            }
+
+            const QString filename =
+                QDir(directory).filePath(QString("%1.sav").arg(i, 6, 10,
+                                                               QChar('0')));
+
+            if (!sram.save(filename, SAVE_INPLACE)) {
+                return QStringList();
+            }
+
+            filenames << filename;
+        }
+
+        return filenames;
+    }
+
+    /**
+     * Loads, validates, edits and saves one file, as a nightly
+     * re-validation of an archive would.
+     *
+     * @param filename The file.
+     *
+     * @return true if the file was valid and saved; false otherwise.
+     */
+    bool cycle(const QString &filename) {
+        try {
+            SRAMFile sram(filename);
+
+            for (int game = 0; game < 3; ++game) {
+                if (sram.isValid(game)) {
+                    sram.setGame(game);
+                    sram.setPlayCount((sram.getPlayCount() + 1) & 0xFF);
+                }
+            }
+
+            return sram.save(filename);
+        } catch (InvalidSRAMFileException &) {
+            return false;
+        }
+    }
+
+    /**
+     * Cycles every file in the corpus once.
+     *
+     * @param filenames The corpus.
+     * @param threads The number of threads to use.
+     *
+     * @return The measurement.
+     */
+    RoundResult runRound(const QStringList &filenames, int threads) {
+        QVector<qint64> latencies(filenames.size());
+        QAtomicInt      failed(0);
+        QElapsedTimer   timer;
+
+        resetPeakRSS();
+        timer.start();
+
+        {
+            WorkStealingPool pool(threads);
+
+            for (int i = 0; i < filenames.size(); ++i) {
+                pool.submit([&filenames, &latencies, &failed, i] {
+                    QElapsedTimer latency;
+
+                    latency.start();
+
+                    if (!cycle(filenames[i])) {
+                        failed.fetchAndAddRelaxed(1);
+                    }
+
+                    latencies[i] = latency.nsecsElapsed();
+                });
+            }
+
+            pool.waitForDone();
+        }
+
+        RoundResult result;
+
+        result.threads = threads;
+        result.failed  = failed.loadAcquire();
+        result.seconds = timer.nsecsElapsed() / 1e9;
+        result.peakRSS = getPeakRSS();
+
+        // nearest rank percentiles
+        std::sort(latencies.begin(), latencies.end());
+
+        const int files = latencies.size();
+
+        result.p50 = latencies[qMax(0, ((files * 50) + 99) / 100 - 1)];
+        result.p99 = latencies[qMax(0, ((files * 99) + 99) / 100 - 1)];
+
+        return result;
+    }
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("lozsrame-throughput");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Generates a corpus of SRAM files, then times loading, validating, "
+        "editing and saving all of them with more and more threads.");
+    parser.addHelpOption();
+
+    QCommandLineOption filesOption(QStringList() << "n" << "files",
+                                   "Files in the corpus.", "n", "10000");
+    QCommandLineOption seedOption("seed", "Seed the corpus is generated from.",
+                                  "n", "1");
+    QCommandLineOption directoryOption(
+        QStringList() << "d" << "directory",
+        "Directory to generate the corpus in, instead of a temporary one.",
+        "directory");
+    QCommandLineOption threadsOption(
+        QStringList() << "t" << "threads",
+        "Most threads to use; rounds double from 1 up to this.", "n",
+        QString::number(QThread::idealThreadCount()));
+
+    QCommandLineOption statsOption(
+        "stats", "File to write SRAM statistics to, in Prometheus format.",
+        "file");
+
+    parser.addOption(filesOption);
+    parser.addOption(seedOption);
+    parser.addOption(directoryOption);
+    parser.addOption(threadsOption);
+    parser.addOption(statsOption);
+    parser.process(app);
+
+    const int files      = qMax(1, parser.value(filesOption).toInt());
+    const int maxThreads = qMax(1, parser.value(threadsOption).toInt());
+
+    QTemporaryDir temporary;
+    QString       directory = parser.value(directoryOption);
+
+    if (directory.isEmpty()) {
+        if (!temporary.isValid()) {
+            std::fprintf(stderr, "unable to create a temporary directory\n");
+
+            return 1;
+        }
+
+        directory = temporary.path();
+    } else if (!QDir().mkpath(directory)) {
+        std::fprintf(stderr, "unable to create the corpus directory\n");
+
+        return 1;
+    }
+
+    QElapsedTimer timer;
+
+    timer.start();
+
+    const QStringList filenames =
+        generateCorpus(directory, files, parser.value(seedOption).toUInt());
+
+    if (filenames.isEmpty()) {
+        std::fprintf(stderr, "unable to write the corpus\n");
+
+        return 1;
+    }
+
+    std::printf("generated %d files in %.3f s\n", files,
+                timer.nsecsElapsed() / 1e9);
+    std::printf("threads    files/s    p50 us    p99 us   peak RSS MB  "
+                "failed\n");
+
+    bool allValid = true;
+
+    for (int threads = 1;; threads = qMin(threads * 2, maxThreads)) {
+        const RoundResult result = runRound(filenames, threads);
+
+        std::printf("%7d %10.0f %9.1f %9.1f %13.1f %7d\n", result.threads,
+                    files / result.seconds, result.p50 / 1e3,
+                    result.p99 / 1e3, result.peakRSS / 1048576.0,
+                    result.failed);
+        std::fflush(stdout);
+
+        allValid = allValid && (result.failed == 0);
+
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+
+    if (parser.isSet(statsOption)
+        && !SRAMStats::writePrometheus(parser.value(statsOption))) {
+        std::fprintf(stderr, "unable to write the statistics\n");
+
+        return 1;
+    }
+
+    return allValid ? 0 : 1;
+}
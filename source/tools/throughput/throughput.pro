@@ -0,0 +1,16 @@
+TEMPLATE = app
+TARGET = lozsrame-throughput
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+
+win32 {
+	LIBS += -lpsapi
+}
+
+include(../../lozsrame.pri)
+
+HEADERS += ../../batch/workstealingpool.hh
+
+SOURCES += throughput.cc \
+	../../batch/workstealingpool.cc
@@ -23,22 +23,89 @@
 #include <QApplication>
 #include <QButtonGroup>
 #include <QDesktopWidget>
+#include <QDir>
+#include <QEventLoop>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QHeaderView>
 #include <QMessageBox>
 #include <QMimeData>
 #include <QRegExpValidator>
 #include <QScreen>
 #include <QSignalMapper>
+#include <QTableView>
+#include <QTimer>
 #include <QUrl>
+#include <QVBoxLayout>
+#include <QtConcurrentRun>
 
 #include "view/mainwindow.hh"
 
 using namespace lozsrame;
 
-MainWindow::MainWindow() : QMainWindow(), ignoreSignals(false), open(false) {
+MainWindow::MainWindow()
+    : QMainWindow(), sram(nullptr), current(-1), ignoreSignals(false),
+      open(false), refreshPending(false), busy(false), closePending(false),
+      resolving(false) {
     // create widgets
     ui.setupUi(this);
 
+    // every open file gets a tab, and they all share the one set of
+    // controls below
+    auto *editor = new QWidget(this);
+    auto *layout = new QVBoxLayout(editor);
+
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+
+    tabs = new QTabBar(editor);
+    tabs->setDocumentMode(true);
+    tabs->setExpanding(false);
+    tabs->setTabsClosable(true);
+
+    layout->addWidget(tabs);
+    layout->addWidget(takeCentralWidget());
+    setCentralWidget(editor);
+
+    connect(tabs, SIGNAL(currentChanged(int)), this,
+            SLOT(selectDocument(int)));
+    connect(tabs, SIGNAL(tabCloseRequested(int)), this,
+            SLOT(closeDocument(int)));
+
+    // an indefinite progress bar, as loading and saving are single reads
+    // and writes
+    progress = new QProgressBar(this);
+    progress->setRange(0, 0);
+    progress->setMaximumWidth(160);
+    progress->hide();
+    ui.statusbar->addPermanentWidget(progress);
+
+    // the folder browser only decodes the rows scrolled into view, so the
+    // rows must be a fixed height and no column may size to its contents,
+    // or the view would ask for every row up front
+    folderModel = new SaveFolderModel(this);
+
+    auto *folderView = new QTableView();
+    folderView->setModel(folderModel);
+    folderView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    folderView->setSelectionMode(QAbstractItemView::SingleSelection);
+    folderView->setWordWrap(false);
+    folderView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    folderView->verticalHeader()->hide();
+
+    folderDock = new QDockWidget(tr("Folder"), this);
+    folderDock->setObjectName("folderDock");
+    folderDock->setWidget(folderView);
+    folderDock->hide();
+    addDockWidget(Qt::BottomDockWidgetArea, folderDock);
+
+    connect(folderView, SIGNAL(activated(QModelIndex)), this,
+            SLOT(folderActivated(QModelIndex)));
+    connect(&openWatcher, SIGNAL(finished()), this, SLOT(openFinished()));
+    connect(&watcher, SIGNAL(fileChanged(QString)), this,
+            SLOT(fileChanged(QString)));
+    connect(&saveWatcher, SIGNAL(finished()), this, SLOT(saveFinished()));
+
     // setup button groups
     auto *gameActionGroup = new QActionGroup(this);
     gameActionGroup->addAction(ui.gameGame1);
@@ -144,12 +211,21 @@ auto MainWindow::closeSRAM() -> bool {
 
     if (sram->isModified()) {
         int choice = QMessageBox::question(
-            this, tr("Warning: Unsaved Changes"), tr("Save changes?"),
+            this, tr("Warning: Unsaved Changes"),
+            tr("Save changes to %1?").arg(QFileInfo(sramFile).fileName()),
             QMessageBox::Yes, QMessageBox::No, QMessageBox::Cancel);
 
         if (choice == QMessageBox::Yes) {
+            QEventLoop loop;
+
+            // wait for the save without freezing the window
+            connect(&saveWatcher, SIGNAL(finished()), &loop, SLOT(quit()));
             ui.fileSave->trigger();
 
+            if (busy) {
+                loop.exec();
+            }
+
             // if the save failed, abort
             if (sram->isModified()) {
                 return false;
@@ -159,169 +235,360 @@ auto MainWindow::closeSRAM() -> bool {
         }
     }
 
+    watcher.removePath(sramFile);
+
     delete sram;
-    open = false;
+    documents.remove(current);
+
+    // the tab bar picks the tab to show next, once the model is gone
+    tabs->blockSignals(true);
+    tabs->removeTab(current);
+    tabs->blockSignals(false);
+
+    selectDocument(tabs->currentIndex());
 
     return true;
 }
 
-void MainWindow::loadSRAMData() {
+void MainWindow::finishTask() {
+    busy = false;
+
+    progress->hide();
+    ui.statusbar->clearMessage();
+
+    // a close was put off until now
+    if (closePending) {
+        closePending = false;
+        QTimer::singleShot(0, this, SLOT(close()));
+    }
+}
+
+auto MainWindow::loadSRAM(const QString &filename) -> OpenResult {
+    OpenResult result = {nullptr, filename, ISFE_FILENOTFOUND};
+
+    try {
+        result.sram = new SRAMFile(filename);
+    } catch (InvalidSRAMFileException &e) {
+        result.error = e.getError();
+    }
+
+    return result;
+}
+
+void MainWindow::loadSRAMData(quint64 fields) {
     Q_ASSERT(open);
 
     ignoreSignals = true;
 
     // load the hero's name
-    ui.lineHerosName->setText(sram->getName());
+    if (fields & DIRTY_NAME) {
+        ui.lineHerosName->setText(sram->getName());
+    }
 
     // load the play count
-    ui.spinPlayCount->setValue(sram->getPlayCount());
+    if (fields & getDirtyBit(PROPERTY_PLAYCOUNT)) {
+        ui.spinPlayCount->setValue(sram->getPlayCount());
+    }
 
     // load the quest number
-    switch (sram->getQuest()) {
-        case QUEST_FIRST:
-            ui.radioQuestFirst->setChecked(true);
-            break;
-        case QUEST_SECOND:
-            ui.radioQuestSecond->setChecked(true);
-            break;
+    if (fields & getDirtyBit(PROPERTY_QUEST)) {
+        switch (sram->getQuest()) {
+            case QUEST_FIRST:
+                ui.radioQuestFirst->setChecked(true);
+                break;
+            case QUEST_SECOND:
+                ui.radioQuestSecond->setChecked(true);
+                break;
+        }
     }
 
     // load the sword type
-    switch (sram->getSword()) {
-        case SWORD_NONE:
-            ui.radioSwordNone->setChecked(true);
-            break;
-        case SWORD_WOODEN:
-            ui.radioSwordWooden->setChecked(true);
-            break;
-        case SWORD_WHITE:
-            ui.radioSwordWhite->setChecked(true);
-            break;
-        case SWORD_MASTER:
-            ui.radioSwordMaster->setChecked(true);
-            break;
+    if (fields & getDirtyBit(PROPERTY_SWORD)) {
+        switch (sram->getSword()) {
+            case SWORD_NONE:
+                ui.radioSwordNone->setChecked(true);
+                break;
+            case SWORD_WOODEN:
+                ui.radioSwordWooden->setChecked(true);
+                break;
+            case SWORD_WHITE:
+                ui.radioSwordWhite->setChecked(true);
+                break;
+            case SWORD_MASTER:
+                ui.radioSwordMaster->setChecked(true);
+                break;
+        }
     }
 
     // load the arrow type
-    switch (sram->getArrows()) {
-        case ARROW_NONE:
-            ui.radioArrowsNone->setChecked(true);
-            break;
-        case ARROW_WOODEN:
-            ui.radioArrowsWooden->setChecked(true);
-            break;
-        case ARROW_SILVER:
-            ui.radioArrowsSilver->setChecked(true);
-            break;
+    if (fields & getDirtyBit(PROPERTY_ARROWS)) {
+        switch (sram->getArrows()) {
+            case ARROW_NONE:
+                ui.radioArrowsNone->setChecked(true);
+                break;
+            case ARROW_WOODEN:
+                ui.radioArrowsWooden->setChecked(true);
+                break;
+            case ARROW_SILVER:
+                ui.radioArrowsSilver->setChecked(true);
+                break;
+        }
     }
 
     // load the candle type
-    switch (sram->getCandle()) {
-        case CANDLE_NONE:
-            ui.radioCandleNone->setChecked(true);
-            break;
-        case CANDLE_BLUE:
-            ui.radioCandleBlue->setChecked(true);
-            break;
-        case CANDLE_RED:
-            ui.radioCandleRed->setChecked(true);
-            break;
+    if (fields & getDirtyBit(PROPERTY_CANDLE)) {
+        switch (sram->getCandle()) {
+            case CANDLE_NONE:
+                ui.radioCandleNone->setChecked(true);
+                break;
+            case CANDLE_BLUE:
+                ui.radioCandleBlue->setChecked(true);
+                break;
+            case CANDLE_RED:
+                ui.radioCandleRed->setChecked(true);
+                break;
+        }
     }
 
     // load the potion type
-    switch (sram->getPotion()) {
-        case POTION_NONE:
-            ui.radioPotionNone->setChecked(true);
-            break;
-        case POTION_BLUE:
-            ui.radioPotionBlue->setChecked(true);
-            break;
-        case POTION_RED:
-            ui.radioPotionRed->setChecked(true);
-            break;
+    if (fields & getDirtyBit(PROPERTY_POTION)) {
+        switch (sram->getPotion()) {
+            case POTION_NONE:
+                ui.radioPotionNone->setChecked(true);
+                break;
+            case POTION_BLUE:
+                ui.radioPotionBlue->setChecked(true);
+                break;
+            case POTION_RED:
+                ui.radioPotionRed->setChecked(true);
+                break;
+        }
     }
 
     // load the ring type
-    switch (sram->getRing()) {
-        case RING_NONE:
-            ui.radioRingNone->setChecked(true);
-            break;
-        case RING_BLUE:
-            ui.radioRingBlue->setChecked(true);
-            break;
-        case RING_RED:
-            ui.radioRingRed->setChecked(true);
-            break;
+    if (fields & getDirtyBit(PROPERTY_RING)) {
+        switch (sram->getRing()) {
+            case RING_NONE:
+                ui.radioRingNone->setChecked(true);
+                break;
+            case RING_BLUE:
+                ui.radioRingBlue->setChecked(true);
+                break;
+            case RING_RED:
+                ui.radioRingRed->setChecked(true);
+                break;
+        }
     }
 
     // load inventory data
-    ui.checkBoomerang->setChecked(sram->hasItem(ITEM_BOOMERANG));
-    ui.checkBow->setChecked(sram->hasItem(ITEM_BOW));
-    ui.checkMagicBoomerang->setChecked(sram->hasItem(ITEM_MAGICBOOMERANG));
-    ui.checkRaft->setChecked(sram->hasItem(ITEM_RAFT));
-    ui.checkLadder->setChecked(sram->hasItem(ITEM_LADDER));
-    ui.checkWhistle->setChecked(sram->hasItem(ITEM_WHISTLE));
-    ui.checkWand->setChecked(sram->hasItem(ITEM_WAND));
-    ui.checkBook->setChecked(sram->hasItem(ITEM_BOOK));
-    ui.checkMagicKey->setChecked(sram->hasItem(ITEM_MAGICKEY));
-    ui.checkMagicShield->setChecked(sram->hasItem(ITEM_MAGICSHIELD));
-    ui.checkPowerBracelet->setChecked(sram->hasItem(ITEM_POWERBRACELET));
-    ui.checkBait->setChecked(sram->hasItem(ITEM_BAIT));
+    if (fields & getDirtyBit(PROPERTY_BOOMERANG)) {
+        ui.checkBoomerang->setChecked(sram->hasItem(ITEM_BOOMERANG));
+    }
+
+    if (fields & getDirtyBit(PROPERTY_BOW)) {
+        ui.checkBow->setChecked(sram->hasItem(ITEM_BOW));
+    }
+
+    if (fields & getDirtyBit(PROPERTY_MAGICBOOMERANG)) {
+        ui.checkMagicBoomerang->setChecked(sram->hasItem(ITEM_MAGICBOOMERANG));
+    }
+
+    if (fields & getDirtyBit(PROPERTY_RAFT)) {
+        ui.checkRaft->setChecked(sram->hasItem(ITEM_RAFT));
+    }
+
+    if (fields & getDirtyBit(PROPERTY_LADDER)) {
+        ui.checkLadder->setChecked(sram->hasItem(ITEM_LADDER));
+    }
+
+    if (fields & getDirtyBit(PROPERTY_WHISTLE)) {
+        ui.checkWhistle->setChecked(sram->hasItem(ITEM_WHISTLE));
+    }
+
+    if (fields & getDirtyBit(PROPERTY_WAND)) {
+        ui.checkWand->setChecked(sram->hasItem(ITEM_WAND));
+    }
+
+    if (fields & getDirtyBit(PROPERTY_BOOK)) {
+        ui.checkBook->setChecked(sram->hasItem(ITEM_BOOK));
+    }
+
+    if (fields & getDirtyBit(PROPERTY_MAGICKEY)) {
+        ui.checkMagicKey->setChecked(sram->hasItem(ITEM_MAGICKEY));
+    }
+
+    if (fields & getDirtyBit(PROPERTY_MAGICSHIELD)) {
+        ui.checkMagicShield->setChecked(sram->hasItem(ITEM_MAGICSHIELD));
+    }
+
+    if (fields & getDirtyBit(PROPERTY_POWERBRACELET)) {
+        ui.checkPowerBracelet->setChecked(sram->hasItem(ITEM_POWERBRACELET));
+    }
+
+    if (fields & getDirtyBit(PROPERTY_BAIT)) {
+        ui.checkBait->setChecked(sram->hasItem(ITEM_BAIT));
+    }
 
     // load dungeon data
+    const bool compasses =
+        (fields
+         & (getDirtyBit(PROPERTY_COMPASSES) | getDirtyBit(PROPERTY_COMPASS9)));
+    const bool maps =
+        (fields & (getDirtyBit(PROPERTY_MAPS) | getDirtyBit(PROPERTY_MAP9)));
+    const bool triforce = (fields & getDirtyBit(PROPERTY_TRIFORCE));
+
     for (int i = 1; i < 10; ++i) {
-        compassChecks[i - 1]->setChecked(sram->hasCompass(i));
-        mapChecks[i - 1]->setChecked(sram->hasMap(i));
+        if (compasses) {
+            compassChecks[i - 1]->setChecked(sram->hasCompass(i));
+        }
+
+        if (maps) {
+            mapChecks[i - 1]->setChecked(sram->hasMap(i));
+        }
 
-        if (i < 9) {
+        if (triforce && (i < 9)) {
             triforceChecks[i - 1]->setChecked(sram->hasTriforce(i));
         }
     }
 
     // load potion note data
-    switch (sram->getNote()) {
-        case NOTE_OLDMAN:
-            ui.radioNoteOldMan->setChecked(true);
-            break;
-        case NOTE_LINK:
-            ui.radioNoteLink->setChecked(true);
-            break;
-        case NOTE_OLDWOMAN:
-            ui.radioNoteOldWoman->setChecked(true);
-            break;
+    if (fields & getDirtyBit(PROPERTY_NOTE)) {
+        switch (sram->getNote()) {
+            case NOTE_OLDMAN:
+                ui.radioNoteOldMan->setChecked(true);
+                break;
+            case NOTE_LINK:
+                ui.radioNoteLink->setChecked(true);
+                break;
+            case NOTE_OLDWOMAN:
+                ui.radioNoteOldWoman->setChecked(true);
+                break;
+        }
     }
 
     // load treasure and bomb data
-    ui.spinRupees->setValue(sram->getRupees());
-    ui.spinKeys->setValue(sram->getKeys());
-    ui.spinHeartContainers->setValue(sram->getHeartContainers());
-    ui.spinBombsCarrying->setValue(sram->getBombs());
-    ui.spinBombsCapacity->setValue(sram->getBombCapacity());
+    if (fields & getDirtyBit(PROPERTY_RUPEES)) {
+        ui.spinRupees->setValue(sram->getRupees());
+    }
+
+    if (fields & getDirtyBit(PROPERTY_KEYS)) {
+        ui.spinKeys->setValue(sram->getKeys());
+    }
+
+    if (fields & getDirtyBit(PROPERTY_HEARTCONTAINERS)) {
+        ui.spinHeartContainers->setValue(sram->getHeartContainers());
+    }
+
+    if (fields & getDirtyBit(PROPERTY_BOMBS)) {
+        ui.spinBombsCarrying->setValue(sram->getBombs());
+    }
+
+    if (fields & getDirtyBit(PROPERTY_BOMBCAPACITY)) {
+        ui.spinBombsCapacity->setValue(sram->getBombCapacity());
+    }
 
     ignoreSignals = false;
 }
 
 void MainWindow::openSRAM(const QString &filename) {
-    Q_ASSERT(!open);
+    const QFileInfo info(filename);
 
-    try {
-        sram     = new SRAMFile(filename);
-        sramFile = filename;
-        open     = true;
+    for (int i = 0; i < documents.size(); ++i) {
+        if (QFileInfo(documents[i].filename) == info) {
+            tabs->setCurrentIndex(i);
 
-        loadSRAMData();
-        updateUI();
-    } catch (InvalidSRAMFileException &e) {
-        QString temp;
+            return;
+        }
+    }
 
-        if (e.getError() == ISFE_INVALIDSIZE) {
-            temp = tr("Invalid SRAM File Size");
-        } else if (e.getError() == ISFE_NOVALIDGAMES) {
-            temp = tr("No Save Games Found");
+    startTask(tr("Opening %1...").arg(info.fileName()));
+    openWatcher.setFuture(QtConcurrent::run(loadSRAM, filename));
+}
+
+auto MainWindow::readSRAM(const QString &filename, char *data) -> bool {
+    QFile file(filename);
+
+    // a file caught part way through being written is the wrong size
+    return (file.open(QIODevice::ReadOnly) && (file.size() == SRAM_SIZE)
+            && (file.read(data, SRAM_SIZE) == SRAM_SIZE));
+}
+
+void MainWindow::reloadDocument(int index) {
+    char data[SRAM_SIZE];
+
+    if (!readSRAM(documents[index].filename, data)) {
+        return;
+    }
+
+    // nothing to take on, as after one of our own saves
+    if (documents[index].sram->toData()
+        == QByteArray::fromRawData(data, SRAM_SIZE)) {
+        return;
+    }
+
+    if (documents[index].sram->isModified()) {
+        // a tab in the background asks once it is shown
+        if (index != current) {
+            documents[index].changedOnDisk = true;
+
+            return;
         }
 
-        QMessageBox::warning(this, tr("Unable to Open SRAM File"), temp,
-                             QMessageBox::Ok, QMessageBox::NoButton);
+        if (documents[index].keepLocal) {
+            return;
+        }
+
+        // the program may keep writing while the question is up
+        resolving = true;
+
+        const int choice = QMessageBox::question(
+            this, tr("File Changed on Disk"),
+            tr("%1 was changed by another program. Reload it and lose your "
+               "unsaved changes?")
+                .arg(QFileInfo(sramFile).fileName()),
+            QMessageBox::Yes, QMessageBox::No);
+
+        resolving = false;
+
+        // keep the changes until they are saved over the file
+        if (choice != QMessageBox::Yes) {
+            documents[index].keepLocal = true;
+
+            return;
+        }
+
+        if (!readSRAM(documents[index].filename, data)) {
+            return;
+        }
+    }
+
+    try {
+        documents[index].sram->reload(data);
+    } catch (InvalidSRAMFileException &) {
+        // caught part way through being written; writing the rest of it
+        // changes the file again
+        return;
+    }
+
+    documents[index].keepLocal = false;
+
+    if (index == current) {
+        scheduleRefresh();
+    }
+}
+
+void MainWindow::startTask(const QString &message) {
+    busy = true;
+
+    ui.statusbar->showMessage(message);
+    progress->show();
+    updateUI();
+}
+
+void MainWindow::scheduleRefresh() {
+    if (!refreshPending) {
+        refreshPending = true;
+        QTimer::singleShot(0, this, SLOT(refresh()));
     }
 }
 
@@ -329,14 +596,14 @@ void MainWindow::selectArrows(enum sf_arrow arrows) {
     Q_ASSERT(open);
 
     sram->setArrows(arrows);
-    updateUI();
+    scheduleRefresh();
 }
 
 void MainWindow::selectCandle(enum sf_candle candle) {
     Q_ASSERT(open);
 
     sram->setCandle(candle);
-    updateUI();
+    scheduleRefresh();
 }
 
 void MainWindow::selectCompass(int level, bool give) {
@@ -344,14 +611,14 @@ void MainWindow::selectCompass(int level, bool give) {
     Q_ASSERT((level >= 1) && (level <= 9));
 
     sram->setCompass(level, give);
-    updateUI();
+    scheduleRefresh();
 }
 
 void MainWindow::selectItem(enum sf_item item, bool give) {
     Q_ASSERT(open);
 
     sram->setItem(item, give);
-    updateUI();
+    scheduleRefresh();
 }
 
 void MainWindow::selectMap(int level, bool give) {
@@ -359,42 +626,42 @@ void MainWindow::selectMap(int level, bool give) {
     Q_ASSERT((level >= 1) && (level <= 9));
 
     sram->setMap(level, give);
-    updateUI();
+    scheduleRefresh();
 }
 
 void MainWindow::selectNote(enum sf_note note) {
     Q_ASSERT(open);
 
     sram->setNote(note);
-    updateUI();
+    scheduleRefresh();
 }
 
 void MainWindow::selectQuest(enum sf_quest quest) {
     Q_ASSERT(open);
 
     sram->setQuest(quest);
-    updateUI();
+    scheduleRefresh();
 }
 
 void MainWindow::selectPotion(enum sf_potion potion) {
     Q_ASSERT(open);
 
     sram->setPotion(potion);
-    updateUI();
+    scheduleRefresh();
 }
 
 void MainWindow::selectRing(enum sf_ring ring) {
     Q_ASSERT(open);
 
     sram->setRing(ring);
-    updateUI();
+    scheduleRefresh();
 }
 
 void MainWindow::selectSword(enum sf_sword sword) {
     Q_ASSERT(open);
 
     sram->setSword(sword);
-    updateUI();
+    scheduleRefresh();
 }
 
 void MainWindow::selectTriforce(int level, bool give) {
@@ -402,21 +669,37 @@ void MainWindow::selectTriforce(int level, bool give) {
     Q_ASSERT((level >= 1) && (level <= 8));
 
     sram->setTriforce(level, give);
-    updateUI();
+    scheduleRefresh();
 }
 
 void MainWindow::updateUI() {
-    ui.fileClose->setEnabled(open);
-    ui.fileSave->setEnabled(open && sram->isModified());
-    ui.fileSaveAs->setEnabled(open);
+    // nothing may touch the file while a worker is loading or saving it
+    const bool ready = (open && !busy);
+
+    ui.fileOpen->setEnabled(!busy);
+    ui.fileClose->setEnabled(ready);
+    ui.fileSave->setEnabled(ready && sram->isModified());
+    ui.fileSaveAs->setEnabled(ready);
 
-    ui.gameGame1->setEnabled(open && sram->isValid(0));
-    ui.gameGame2->setEnabled(open && sram->isValid(1));
-    ui.gameGame3->setEnabled(open && sram->isValid(2));
+    ui.editUndo->setEnabled(ready && sram->canUndo());
+    ui.editRedo->setEnabled(ready && sram->canRedo());
+
+    ui.gameGame1->setEnabled(ready && sram->isValid(0));
+    ui.gameGame2->setEnabled(ready && sram->isValid(1));
+    ui.gameGame3->setEnabled(ready && sram->isValid(2));
 
     ui.centralwidget->setVisible(open);
+    ui.centralwidget->setEnabled(!busy);
+
+    tabs->setVisible(open);
+    tabs->setEnabled(!busy);
 
     if (open) {
+        // a star marks a file with unsaved changes
+        tabs->setTabText(current, QFileInfo(sramFile).fileName()
+                                      + (sram->isModified() ? "*" : ""));
+        tabs->setTabToolTip(current, sramFile);
+
         switch (sram->getGame()) {
             case 0:
                 ui.gameGame1->setChecked(true);
@@ -436,10 +719,16 @@ void MainWindow::updateUI() {
 }
 
 void MainWindow::closeEvent(QCloseEvent *event) {
-    if (open) {
-        event->setAccepted(closeSRAM());
+    if (busy) {
+        // close once the worker is done with the file
+        closePending = true;
+        event->ignore();
     } else {
-        event->accept();
+        // ask about each file with unsaved changes, until one is cancelled
+        while (open && closeSRAM()) {
+        }
+
+        event->setAccepted(!open);
     }
 }
 
@@ -454,15 +743,38 @@ void MainWindow::dropEvent(QDropEvent *event) {
     QString     filename = urls.first().toLocalFile();
 
     // uri could be something else
-    if (filename.isEmpty()) {
+    if (filename.isEmpty() || busy) {
         return;
     }
 
-    if (open && !closeSRAM()) {
+    openSRAM(filename);
+}
+
+void MainWindow::on_editRedo_triggered(bool) {
+    Q_ASSERT(open);
+
+    sram->redo();
+    scheduleRefresh();
+}
+
+void MainWindow::on_editUndo_triggered(bool) {
+    Q_ASSERT(open);
+
+    sram->undo();
+    scheduleRefresh();
+}
+
+void MainWindow::on_fileBrowse_triggered(bool) {
+    const QString directory = QFileDialog::getExistingDirectory(
+        this, tr("Browse Folder of SRAM Files"), folderModel->getDirectory());
+
+    if (directory.isNull()) {
         return;
     }
 
-    openSRAM(filename);
+    folderModel->setDirectory(directory);
+    folderDock->setWindowTitle(QDir(directory).dirName());
+    folderDock->show();
 }
 
 void MainWindow::on_fileClose_triggered(bool) {
@@ -474,10 +786,6 @@ void MainWindow::on_fileClose_triggered(bool) {
 }
 
 void MainWindow::on_fileOpen_triggered(bool) {
-    if (open && !closeSRAM()) {
-        return;
-    }
-
     QString filename =
         QFileDialog::getOpenFileName(this, tr("Open Legend of Zelda SRAM File"),
                                      "", tr("SRAM Files (*.sav)"));
@@ -492,13 +800,21 @@ void MainWindow::on_fileOpen_triggered(bool) {
 void MainWindow::on_fileSave_triggered(bool) {
     Q_ASSERT(open);
 
-    if (!sram->save(sramFile)) {
-        QMessageBox::warning(this, tr("Unable to Save SRAM File"),
-                             tr("An I/O error occurred while trying to save."),
-                             QMessageBox::Ok, QMessageBox::NoButton);
-    }
+    // the worker saves a copy, so it never shares the model with the view
+    auto         *copy     = new SRAMFile(*sram);
+    const QString filename = sramFile;
 
-    updateUI();
+    startTask(tr("Saving %1...").arg(QFileInfo(filename).fileName()));
+    saveWatcher.setFuture(
+        QtConcurrent::run([copy, filename]() -> SRAMFile * {
+            if (copy->save(filename)) {
+                return copy;
+            }
+
+            delete copy;
+
+            return nullptr;
+        }));
 }
 
 void MainWindow::on_fileSaveAs_triggered(bool) {
@@ -511,7 +827,10 @@ void MainWindow::on_fileSaveAs_triggered(bool) {
         return;
     }
 
-    sramFile = temp;
+    watcher.removePath(sramFile);
+
+    sramFile                    = temp;
+    documents[current].filename = temp;
 
     ui.fileSave->trigger();
 }
@@ -527,7 +846,11 @@ void MainWindow::on_lineHerosName_textEdited(const QString &text) {
     Q_ASSERT(open);
 
     sram->setName(text);
-    updateUI();
+
+    // the line edit already shows the name, and reloading would move the
+    // cursor
+    sram->takeDirtyFields(DIRTY_NAME);
+    scheduleRefresh();
 }
 
 void MainWindow::on_spinBombsCarrying_valueChanged(int value) {
@@ -535,7 +858,7 @@ void MainWindow::on_spinBombsCarrying_valueChanged(int value) {
 
     if (!ignoreSignals) {
         sram->setBombs(value);
-        updateUI();
+        scheduleRefresh();
     }
 }
 
@@ -544,7 +867,7 @@ void MainWindow::on_spinBombsCapacity_valueChanged(int value) {
 
     if (!ignoreSignals) {
         sram->setBombCapacity(value);
-        updateUI();
+        scheduleRefresh();
     }
 }
 
@@ -553,7 +876,7 @@ void MainWindow::on_spinHeartContainers_valueChanged(int value) {
 
     if (!ignoreSignals) {
         sram->setHeartContainers(value);
-        updateUI();
+        scheduleRefresh();
     }
 }
 
@@ -562,7 +885,7 @@ void MainWindow::on_spinKeys_valueChanged(int value) {
 
     if (!ignoreSignals) {
         sram->setKeys(value);
-        updateUI();
+        scheduleRefresh();
     }
 }
 
@@ -571,7 +894,7 @@ void MainWindow::on_spinPlayCount_valueChanged(int value) {
 
     if (!ignoreSignals) {
         sram->setPlayCount(value);
-        updateUI();
+        scheduleRefresh();
     }
 }
 
@@ -580,15 +903,145 @@ void MainWindow::on_spinRupees_valueChanged(int value) {
 
     if (!ignoreSignals) {
         sram->setRupees(value);
-        updateUI();
+        scheduleRefresh();
+    }
+}
+
+void MainWindow::closeDocument(int index) {
+    Q_ASSERT(!busy);
+
+    // show the file being closed, in case it asks to save
+    tabs->setCurrentIndex(index);
+    closeSRAM();
+}
+
+void MainWindow::fileChanged(const QString &filename) {
+    // a program that saves by renaming a new file over the old one leaves
+    // the watcher watching nothing
+    if (!watcher.files().contains(filename) && QFile::exists(filename)) {
+        watcher.addPath(filename);
+    }
+
+    // our own saves change the file too
+    if (busy || resolving) {
+        return;
+    }
+
+    for (int i = 0; i < documents.size(); ++i) {
+        if (documents[i].filename == filename) {
+            reloadDocument(i);
+
+            return;
+        }
+    }
+}
+
+void MainWindow::folderActivated(const QModelIndex &index) {
+    if (busy) {
+        return;
+    }
+
+    openSRAM(folderModel->getFilename(index.row()));
+}
+
+void MainWindow::openFinished() {
+    const OpenResult result = openWatcher.result();
+
+    finishTask();
+
+    if (result.sram) {
+        documents.append({result.sram, result.filename, false, false});
+        watcher.addPath(result.filename);
+
+        tabs->blockSignals(true);
+        tabs->setCurrentIndex(
+            tabs->addTab(QFileInfo(result.filename).fileName()));
+        tabs->blockSignals(false);
+
+        selectDocument(documents.size() - 1);
+    } else {
+        QString temp;
+
+        if (result.error == ISFE_INVALIDSIZE) {
+            temp = tr("Invalid SRAM File Size");
+        } else if (result.error == ISFE_NOVALIDGAMES) {
+            temp = tr("No Save Games Found");
+        }
+
+        QMessageBox::warning(this, tr("Unable to Open SRAM File"), temp,
+                             QMessageBox::Ok, QMessageBox::NoButton);
+    }
+
+    updateUI();
+}
+
+void MainWindow::refresh() {
+    refreshPending = false;
+
+    // the file may have been closed since the refresh was scheduled
+    if (open) {
+        loadSRAMData(sram->takeDirtyFields());
     }
+
+    updateUI();
+}
+
+void MainWindow::saveFinished() {
+    SRAMFile *saved = saveWatcher.result();
+
+    finishTask();
+
+    if (saved) {
+        // the saved copy matches the model, and knows it has been saved
+        delete sram;
+        sram                    = saved;
+        documents[current].sram = saved;
+
+        // the file now holds our changes, so there is nothing to resolve
+        documents[current].changedOnDisk = false;
+        documents[current].keepLocal     = false;
+
+        // saving replaces the file, which drops it from the watcher
+        if (!watcher.files().contains(sramFile)) {
+            watcher.addPath(sramFile);
+        }
+    } else {
+        QMessageBox::warning(this, tr("Unable to Save SRAM File"),
+                             tr("An I/O error occurred while trying to save."),
+                             QMessageBox::Ok, QMessageBox::NoButton);
+    }
+
+    updateUI();
 }
 
 void MainWindow::selectGame(int game) {
     Q_ASSERT(open);
 
     sram->setGame(game);
-    loadSRAMData();
+    scheduleRefresh();
+}
+
+void MainWindow::selectDocument(int index) {
+    current = index;
+    open    = (index >= 0);
+
+    if (open) {
+        sram     = documents[index].sram;
+        sramFile = documents[index].filename;
+
+        // the controls were showing another file, so every field is stale
+        sram->takeDirtyFields();
+        loadSRAMData(DIRTY_ALL);
+
+        if (documents[index].changedOnDisk) {
+            documents[index].changedOnDisk = false;
+            reloadDocument(index);
+        }
+    } else {
+        sram = nullptr;
+        sramFile.clear();
+    }
+
     updateUI();
 }
 
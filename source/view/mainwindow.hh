@@ -22,12 +22,18 @@
 #ifndef LOZSRAME_MAINWINDOW_HH_
 #define LOZSRAME_MAINWINDOW_HH_
 
+#include <QDockWidget>
 #include <QDragEnterEvent>
 #include <QDropEvent>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QProgressBar>
+#include <QTabBar>
 
 #include "ui_mainwindow.h"
 
 #include "model/sramfile.hh"
+#include "view/savefoldermodel.hh"
 
 /// namespace used by all the classes and members of lozsrame
 namespace lozsrame {
@@ -38,31 +44,108 @@ namespace lozsrame {
         Q_OBJECT
 
       private:
-        QString        sramFile;
-        QCheckBox     *compassChecks[9], *mapChecks[9], *triforceChecks[8];
-        Ui::MainWindow ui;
-        SRAMFile      *sram;
-        bool           ignoreSignals, open;
-
-        /**
-         * Closes the current SRAM file.
+        /// the outcome of loading an SRAM file on a worker thread
+        struct OpenResult {
+            SRAMFile       *sram;
+            QString         filename;
+            enum isfe_error error;
+        };
+
+        /// an open SRAM file, shown in a tab
+        struct Document {
+            SRAMFile *sram;
+            QString   filename;
+            bool      changedOnDisk, keepLocal;
+        };
+
+        QString                    sramFile;
+        QCheckBox                 *compassChecks[9], *mapChecks[9],
+                                  *triforceChecks[8];
+        Ui::MainWindow             ui;
+        QFutureWatcher<OpenResult> openWatcher;
+        QFutureWatcher<SRAMFile *> saveWatcher;
+        QFileSystemWatcher         watcher;
+        QVector<Document>          documents;
+        QProgressBar              *progress;
+        QTabBar                   *tabs;
+        QDockWidget               *folderDock;
+        SaveFolderModel           *folderModel;
+        SRAMFile                  *sram;
+        int                        current;
+        bool                       ignoreSignals, open, refreshPending, busy,
+                                   closePending, resolving;
+
+        /**
+         * Closes the SRAM file in the current tab, and shows the next one.
          *
          * @return true if closed; false otherwise.
          */
         bool closeSRAM();
 
         /**
-         * Loads the SRAM data into the controls.
+         * Finishes a file operation started with startTask.
+         */
+        void finishTask();
+
+        /**
+         * Loads an SRAM file. Runs on a worker thread.
+         *
+         * @param filename The SRAM filename.
+         *
+         * @return The loaded file, or a null file and the reason it failed.
+         */
+        static OpenResult loadSRAM(const QString &filename);
+
+        /**
+         * Loads some of the SRAM data into the controls.
+         *
+         * @param fields The dirty field bits of the fields to load.
          */
-        void loadSRAMData();
+        void loadSRAMData(quint64 fields);
 
         /**
-         * Opens an SRAM file for editing.
+         * Starts opening an SRAM file for editing on a worker thread. The
+         * file is shown in a new tab once it has loaded and been validated.
+         * A file that is already open is shown in its own tab instead.
          *
          * @param filename The SRAM filename.
          */
         void openSRAM(const QString &filename);
 
+        /**
+         * Reads an SRAM file, without validating it.
+         *
+         * @param filename The SRAM filename.
+         * @param data Where to put the SRAM_SIZE bytes of SRAM data.
+         *
+         * @return true if read; false if the file is missing or is the
+         *         wrong size.
+         */
+        static bool readSRAM(const QString &filename, char *data);
+
+        /**
+         * Takes on the changes another program made to the file of a tab.
+         * If the tab has unsaved changes of its own, the user is asked
+         * which to keep, once the tab is shown.
+         *
+         * @param index The tab.
+         */
+        void reloadDocument(int index);
+
+        /**
+         * Shows the progress of a file operation running on a worker
+         * thread, and disables the controls until finishTask is called.
+         *
+         * @param message The message to show.
+         */
+        void startTask(const QString &message);
+
+        /**
+         * Schedules a refresh for when control returns to the event loop,
+         * so any number of edits made before then cost one refresh.
+         */
+        void scheduleRefresh();
+
         /**
          * Updates the UI based on the status of the program.
          */
@@ -150,6 +233,51 @@ namespace lozsrame {
         void selectTriforce(int level, bool give);
 
       private slots:
+        /**
+         * Called when the close button of a tab is clicked.
+         *
+         * @param index The tab.
+         */
+        void closeDocument(int index);
+
+        /**
+         * Called when another program changes an open SRAM file.
+         *
+         * @param filename The SRAM filename.
+         */
+        void fileChanged(const QString &filename);
+
+        /**
+         * Called when a file in the folder browser is activated.
+         *
+         * @param index The activated cell.
+         */
+        void folderActivated(const QModelIndex &index);
+
+        /**
+         * Called when an SRAM file has finished loading on a worker thread.
+         */
+        void openFinished();
+
+        /**
+         * Loads the fields changed since the last refresh into the controls
+         * and updates the UI.
+         */
+        void refresh();
+
+        /**
+         * Called when an SRAM file has finished saving on a worker thread.
+         */
+        void saveFinished();
+
+        /**
+         * Shows the SRAM file of a tab in the controls. Every tab shares the
+         * one set of controls, so another open file only costs its model.
+         *
+         * @param index The tab, or -1 if there are none.
+         */
+        void selectDocument(int index);
+
         /**
          * Called when the bait is (de)selected.
          *
@@ -416,6 +544,21 @@ namespace lozsrame {
          */
         void on_checkWhistle_clicked(bool checked);
 
+        /**
+         * Called when redo from the edit menu is selected.
+         */
+        void on_editRedo_triggered(bool);
+
+        /**
+         * Called when undo from the edit menu is selected.
+         */
+        void on_editUndo_triggered(bool);
+
+        /**
+         * Called when browse folder from the file menu is selected.
+         */
+        void on_fileBrowse_triggered(bool);
+
         /**
          * Called when close from the file menu is selected.
          */
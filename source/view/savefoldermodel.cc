@@ -0,0 +1,289 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <QDir>
+#include <QTimer>
+#include <QtConcurrentRun>
+#include <QtCore/qalgorithms.h>
+
+#include "exceptions/invalidsramfileexception.hh"
+#include "model/srambatch.hh"
+#include "view/savefoldermodel.hh"
+
+using namespace lozsrame;
+
+SaveFolderModel::FileSummary::FileSummary() : state(SUMMARY_UNLOADED) {}
+
+SaveFolderModel::SaveFolderModel(QObject *parent)
+    : QAbstractTableModel(parent), generation(0), inFlight(0),
+      flushPending(false) {
+    connect(&listWatcher, SIGNAL(finished()), this, SLOT(listFinished()));
+}
+
+SaveFolderModel::~SaveFolderModel() {
+    // the workers fill in batches this model owns the watchers of
+    pool.waitForDone();
+}
+
+void SaveFolderModel::decode(const QString &directory,
+                             const QStringList &filenames, Batch *batch) {
+    const QDir folder(directory);
+    SRAMBatch  sram;
+
+    sram.reserve(filenames.size());
+    batch->summaries.resize(filenames.size());
+
+    for (int i = 0; i < filenames.size(); ++i) {
+        FileSummary &summary = batch->summaries[i];
+        int          file;
+
+        try {
+            file = sram.append(folder.filePath(filenames[i]));
+        } catch (const InvalidSRAMFileException &) {
+            summary.state = SUMMARY_INVALID;
+            continue;
+        }
+
+        summary.state = SUMMARY_LOADED;
+
+        for (int game = 0; game < 3; ++game) {
+            GameSummary &slot = summary.games[game];
+
+            slot.valid = sram.isValid(file, game);
+
+            if (!slot.valid) {
+                continue;
+            }
+
+            slot.name     = sram.getName(file, game).trimmed();
+            slot.quest    = static_cast<quint8>(sram.getQuest(file, game));
+            slot.hearts   =
+                static_cast<quint8>(sram.getHeartContainers(file, game));
+            slot.triforce = static_cast<quint8>(qPopulationCount(
+                static_cast<quint8>(
+                    sram.getProperty<PROPERTY_TRIFORCE>(file, game))));
+        }
+    }
+}
+
+auto SaveFolderModel::list(const QString &directory) -> QStringList {
+    // sorting here rather than in QDir spares it a QFileInfo per file
+    QStringList names = QDir(directory).entryList(QStringList("*.sav"),
+                                                  QDir::Files, QDir::NoSort);
+
+    names.sort(Qt::CaseInsensitive);
+
+    return names;
+}
+
+void SaveFolderModel::request(int row) const {
+    summaries[row].state = SUMMARY_PENDING;
+    requested.append(row);
+
+    if (!flushPending) {
+        flushPending = true;
+        QTimer::singleShot(0, this, SLOT(flush()));
+    }
+}
+
+void SaveFolderModel::batchFinished() {
+    auto *watcher = static_cast<QFutureWatcher<Batch> *>(sender());
+    const Batch batch = watcher->result();
+
+    watcher->deleteLater();
+    --inFlight;
+
+    // rows of a folder no longer shown are thrown away
+    if (batch.generation == generation) {
+        int first = batch.rows.first(), last = first;
+
+        for (int i = 0; i < batch.rows.size(); ++i) {
+            const int row = batch.rows[i];
+
+            summaries[row] = batch.summaries[i];
+            first          = qMin(first, row);
+            last           = qMax(last, row);
+        }
+
+        emit dataChanged(index(first, 1), index(last, columnCount() - 1));
+    }
+
+    flush();
+}
+
+void SaveFolderModel::flush() {
+    flushPending = false;
+
+    // the newest requests are the rows in view now, so they go first, and
+    // only as many batches as there are workers are handed out at a time
+    // so rows scrolled past don't hold up the ones on screen
+    while ((inFlight < pool.maxThreadCount()) && !requested.isEmpty()) {
+        const int   count = qMin(requested.size(), SUMMARY_BATCH);
+        QStringList names;
+        Batch       batch;
+
+        batch.generation = generation;
+        batch.rows       = requested.mid(requested.size() - count);
+        requested.resize(requested.size() - count);
+
+        for (int row : batch.rows) {
+            names.append(filenames[row]);
+        }
+
+        auto *watcher = new QFutureWatcher<Batch>(this);
+
+        connect(watcher, SIGNAL(finished()), this, SLOT(batchFinished()));
+
+        const QString folder = directory;
+
+        watcher->setFuture(QtConcurrent::run(&pool, [folder, names,
+                                                     batch]() mutable {
+            decode(folder, names, &batch);
+
+            return batch;
+        }));
+
+        ++inFlight;
+    }
+}
+
+void SaveFolderModel::listFinished() {
+    beginResetModel();
+
+    filenames = listWatcher.result();
+    summaries = QVector<FileSummary>(filenames.size());
+
+    endResetModel();
+}
+
+void SaveFolderModel::setDirectory(const QString &directory) {
+    beginResetModel();
+
+    this->directory = directory;
+    ++generation;
+
+    filenames.clear();
+    summaries.clear();
+    requested.clear();
+
+    endResetModel();
+
+    listWatcher.setFuture(QtConcurrent::run(&pool, list, directory));
+}
+
+auto SaveFolderModel::getFilename(int row) const -> QString {
+    return QDir(directory).filePath(filenames[row]);
+}
+
+auto SaveFolderModel::columnCount(const QModelIndex &parent) const -> int {
+    return (parent.isValid() ? 0 : 1 + (3 * FIELD_COUNT));
+}
+
+auto SaveFolderModel::data(const QModelIndex &index, int role) const
+    -> QVariant {
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    const int row = index.row();
+
+    if (role == Qt::ToolTipRole) {
+        return getFilename(row);
+    }
+
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    if (summaries[row].state == SUMMARY_UNLOADED) {
+        request(row);
+    }
+
+    if (index.column() == 0) {
+        return filenames[row];
+    }
+
+    const FileSummary &summary = summaries[row];
+    const int          game    = (index.column() - 1) / FIELD_COUNT;
+    const int          field   = (index.column() - 1) % FIELD_COUNT;
+
+    if (summary.state == SUMMARY_INVALID) {
+        return ((index.column() == 1) ? tr("(invalid)") : QVariant());
+    } else if (summary.state != SUMMARY_LOADED) {
+        return QVariant();
+    }
+
+    const GameSummary &slot = summary.games[game];
+
+    if (!slot.valid) {
+        return ((field == FIELD_NAME) ? tr("(empty)") : QVariant());
+    }
+
+    switch (field) {
+        case FIELD_NAME:
+            return slot.name;
+        case FIELD_QUEST:
+            return ((slot.quest == QUEST_SECOND) ? tr("Second")
+                                                 : tr("First"));
+        case FIELD_HEARTS:
+            return slot.hearts;
+        case FIELD_TRIFORCE:
+            return tr("%1/8").arg(slot.triforce);
+
+        default:
+            // we must never get here!
+            Q_ASSERT(false);
+    }
+
+    return QVariant();
+}
+
+auto SaveFolderModel::headerData(int section, Qt::Orientation orientation,
+                                 int role) const -> QVariant {
+    if ((orientation != Qt::Horizontal) || (role != Qt::DisplayRole)) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    if (section == 0) {
+        return tr("File");
+    }
+
+    switch ((section - 1) % FIELD_COUNT) {
+        case FIELD_NAME:
+            return tr("Game %1").arg(((section - 1) / FIELD_COUNT) + 1);
+        case FIELD_QUEST:
+            return tr("Quest");
+        case FIELD_HEARTS:
+            return tr("Hearts");
+        case FIELD_TRIFORCE:
+            return tr("Triforce");
+
+        default:
+            // we must never get here!
+            Q_ASSERT(false);
+    }
+
+    return QVariant();
+}
+
+auto SaveFolderModel::rowCount(const QModelIndex &parent) const -> int {
+    return (parent.isValid() ? 0 : filenames.size());
+}
@@ -0,0 +1,216 @@
+/*
+ * lozsrame - Legend of Zelda SRAM Editor
+ * Copyright (C) 2007-2008 emuWorks
+ * http://games.technoplaza.net/
+ *
+ * This file is part of lozsrame.
+ *
+ * lozsrame is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * lozsrame is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * lozsrame; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOZSRAME_SAVEFOLDERMODEL_HH_
+#define LOZSRAME_SAVEFOLDERMODEL_HH_
+
+#include <QAbstractTableModel>
+#include <QFutureWatcher>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+namespace lozsrame {
+    /// the columns shown for each game of a file
+    enum sfm_field {
+        FIELD_NAME, FIELD_QUEST, FIELD_HEARTS, FIELD_TRIFORCE, FIELD_COUNT
+    };
+
+    /// how far along a row's summary is
+    enum sfm_state {
+        SUMMARY_UNLOADED, SUMMARY_PENDING, SUMMARY_LOADED, SUMMARY_INVALID
+    };
+
+    /// the rows decoded by one worker task
+    const int SUMMARY_BATCH = 64;
+
+    /**
+     * A table of every SRAM file in a folder, with a summary of each game
+     * in it. Only the file names are listed up front. A row is decoded on
+     * a worker thread the first time a view asks for it, which only
+     * happens as it scrolls into view, and the summary is kept from then
+     * on. The files of a batch are read into one SRAMBatch, so no SRAMFile
+     * is ever made for them.
+     */
+    class SaveFolderModel : public QAbstractTableModel {
+        Q_OBJECT
+
+      private:
+        /// what the table shows of one game
+        struct GameSummary {
+            QString name;
+            quint8  quest, hearts, triforce;
+            bool    valid;
+        };
+
+        /// what the table shows of one file
+        struct FileSummary {
+            enum sfm_state state;
+            GameSummary    games[3];
+
+            FileSummary();
+        };
+
+        /// the summaries decoded by one worker task
+        struct Batch {
+            int                  generation;
+            QVector<int>         rows;
+            QVector<FileSummary> summaries;
+        };
+
+        QString                      directory;
+        QStringList                  filenames;
+        QFutureWatcher<QStringList>  listWatcher;
+        QThreadPool                  pool;
+        mutable QVector<FileSummary> summaries;
+        mutable QVector<int>         requested;
+        int                          generation, inFlight;
+        mutable bool                 flushPending;
+
+        /**
+         * Decodes the summaries of some files. Runs on a worker thread.
+         *
+         * @param directory The folder the files are in.
+         * @param filenames The names of the files.
+         * @param batch The batch to fill in.
+         */
+        static void decode(const QString &directory,
+                           const QStringList &filenames, Batch *batch);
+
+        /**
+         * Lists the SRAM files in a folder. Runs on a worker thread.
+         *
+         * @param directory The folder.
+         *
+         * @return The file names, sorted.
+         */
+        static QStringList list(const QString &directory);
+
+        /**
+         * Queues a row to be decoded, if it hasn't been already.
+         *
+         * @param row The row.
+         */
+        void request(int row) const;
+
+      private slots:
+        /**
+         * Called when a worker has decoded a batch of rows.
+         */
+        void batchFinished();
+
+        /**
+         * Hands the rows requested since the last flush to the workers.
+         */
+        void flush();
+
+        /**
+         * Called when a worker has listed the folder.
+         */
+        void listFinished();
+
+      public:
+        /**
+         * Creates a new, empty SaveFolderModel.
+         *
+         * @param parent The parent object.
+         */
+        explicit SaveFolderModel(QObject *parent = nullptr);
+
+        /**
+         * Destroys a SaveFolderModel, waiting for its workers to finish.
+         */
+        ~SaveFolderModel();
+
+        /**
+         * Gets the folder being shown.
+         *
+         * @return The folder.
+         */
+        const QString &getDirectory() const;
+
+        /**
+         * Shows the SRAM files in a folder. The folder is listed on a
+         * worker thread, and the table is empty until it has been.
+         *
+         * @param directory The folder.
+         */
+        void setDirectory(const QString &directory);
+
+        /**
+         * Gets the path of the file shown on a row.
+         *
+         * @param row The row.
+         *
+         * @return The path.
+         */
+        QString getFilename(int row) const;
+
+        /**
+         * Gets the number of columns: the file name, then the fields of
+         * each game.
+         *
+         * @param parent Unused; the table has no children.
+         *
+         * @return The number of columns.
+         */
+        int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+        /**
+         * Gets what a cell shows. A row not decoded yet shows nothing but
+         * its file name until its worker is done.
+         *
+         * @param index The cell.
+         * @param role The role of the data.
+         *
+         * @return The data.
+         */
+        QVariant data(const QModelIndex &index,
+                      int role = Qt::DisplayRole) const;
+
+        /**
+         * Gets the title of a column.
+         *
+         * @param section The column.
+         * @param orientation The header's orientation.
+         * @param role The role of the data.
+         *
+         * @return The title.
+         */
+        QVariant headerData(int section, Qt::Orientation orientation,
+                            int role = Qt::DisplayRole) const;
+
+        /**
+         * Gets the number of files listed.
+         *
+         * @param parent Unused; the table has no children.
+         *
+         * @return The number of files.
+         */
+        int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    };
+
+    inline const QString &SaveFolderModel::getDirectory() const {
+        return directory;
+    }
+}  // namespace lozsrame
+
+#endif